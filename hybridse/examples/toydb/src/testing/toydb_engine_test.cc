@@ -17,6 +17,7 @@
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "testing/toydb_engine_test_base.h"
+#include "vm/runner.h"
 
 using namespace llvm;       // NOLINT (build/namespaces)
 using namespace llvm::orc;  // NOLINT (build/namespaces)
@@ -115,6 +116,148 @@ TEST_P(BatchRequestEngineTest, TestClusterBatchRequestEngine) {
     }
 }
 
+// run the batch case with the window incremental aggregation on and off, the outputs must be the same
+void WindowIncrementalAggCheck(const SqlCase& sql_case) {
+    if (!sql_case.expect().success_ || boost::contains(sql_case.mode(), "batch-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-batch-unsupport")) {
+        LOG(INFO) << "Skip mode " << sql_case.mode();
+        return;
+    }
+    std::vector<std::unique_ptr<ToydbBatchEngineTestRunner>> runners;
+    std::vector<std::vector<Row>> outputs(2);
+    for (bool incremental : {true, false}) {
+        EngineOptions options;
+        options.SetEnableBatchWindowIncrementalAgg(incremental);
+        runners.emplace_back(new ToydbBatchEngineTestRunner(sql_case, options));
+        auto& runner = runners.back();
+        ASSERT_TRUE(runner->InitEngineCatalog());
+        Status status = runner->Compile();
+        ASSERT_TRUE(status.isOK()) << status;
+        status = runner->PrepareData();
+        ASSERT_TRUE(status.isOK()) << status;
+        status = runner->Compute(&outputs[incremental ? 0 : 1]);
+        ASSERT_TRUE(status.isOK()) << status;
+
+        auto compile_info = std::dynamic_pointer_cast<SqlCompileInfo>(runner->GetSession()->GetCompileInfo());
+        std::vector<Runner*> stack = {compile_info->GetMainTask()};
+        bool used = false;
+        while (!stack.empty()) {
+            Runner* cur = stack.back();
+            stack.pop_back();
+            if (cur == nullptr) {
+                continue;
+            }
+            if (cur->type_ == kRunnerWindowAgg && dynamic_cast<WindowAggRunner*>(cur)->incremental_agg_ != nullptr) {
+                used = true;
+            }
+            stack.insert(stack.end(), cur->GetProducers().begin(), cur->GetProducers().end());
+        }
+        ASSERT_EQ(incremental, used);
+    }
+    CheckRows(runners[0]->GetSession()->GetSchema(), outputs[0], outputs[1]);
+}
+
+// the cases are all computed incrementally
+class WindowIncrementalAggTest : public ::testing::TestWithParam<SqlCase> {};
+INSTANTIATE_TEST_SUITE_P(
+    EngineTestWindowIncrementalAgg, WindowIncrementalAggTest,
+    testing::ValuesIn(sqlcase::InitCases("/cases/function/window/test_window_incremental_agg.yaml")));
+TEST_P(WindowIncrementalAggTest, TestBatchEngineWindowIncrementalAgg) {
+    ParamType sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    WindowIncrementalAggCheck(sql_case);
+}
+
+// check the window cases with the incremental aggregation on, some of them fall back to the compiled function
+class WindowIncrementalAggFallbackTest : public ::testing::TestWithParam<SqlCase> {};
+INSTANTIATE_TEST_SUITE_P(EngineTestWindowRowQuery, WindowIncrementalAggFallbackTest,
+                         testing::ValuesIn(sqlcase::InitCases("/cases/function/window/test_window_row.yaml")));
+INSTANTIATE_TEST_SUITE_P(
+    EngineTestWindowRowsRangeQuery, WindowIncrementalAggFallbackTest,
+    testing::ValuesIn(sqlcase::InitCases("/cases/function/window/test_window_row_range.yaml")));
+INSTANTIATE_TEST_SUITE_P(EngineTestWindowMaxSize, WindowIncrementalAggFallbackTest,
+                         testing::ValuesIn(sqlcase::InitCases("/cases/function/window/test_maxsize.yaml")));
+INSTANTIATE_TEST_SUITE_P(
+    EngineTestUdafFunction, WindowIncrementalAggFallbackTest,
+    testing::ValuesIn(sqlcase::InitCases("/cases/function/function/test_udaf_function.yaml")));
+TEST_P(WindowIncrementalAggFallbackTest, TestBatchEngineWindowIncrementalAgg) {
+    ParamType sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    if (!sql_case.expect().success_ || boost::contains(sql_case.mode(), "batch-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-batch-unsupport")) {
+        LOG(INFO) << "Skip mode " << sql_case.mode();
+        return;
+    }
+    EngineOptions options;
+    options.SetEnableBatchWindowIncrementalAgg(true);
+    EngineCheck(sql_case, options, kBatchMode);
+}
+
+// run the cluster case with the independent subqueries prefetched and not, the outputs must be the same
+void PrefetchCheck(const SqlCase& sql_case, EngineMode engine_mode) {
+    std::vector<std::unique_ptr<EngineTestRunner>> runners;
+    std::vector<std::vector<Row>> outputs(2);
+    for (bool prefetch : {true, false}) {
+        EngineOptions options;
+        options.SetClusterOptimized(true);
+        if (engine_mode == kRequestMode) {
+            runners.emplace_back(new ToydbRequestEngineTestRunner(sql_case, options));
+        } else {
+            runners.emplace_back(new ToydbBatchRequestEngineTestRunner(sql_case, options, {}));
+        }
+        auto& runner = runners.back();
+        ASSERT_TRUE(runner->InitEngineCatalog());
+        Status status = runner->Compile();
+        ASSERT_TRUE(status.isOK()) << status;
+        auto& cluster_job =
+            std::dynamic_pointer_cast<SqlCompileInfo>(runner->GetSession()->GetCompileInfo())->get_sql_context().cluster_job;
+        if (cluster_job.GetPrefetchRunners(cluster_job.main_task_id()).size() < 2) {
+            LOG(INFO) << "Skip case without independent subqueries";
+            return;
+        }
+        if (!prefetch) {
+            for (size_t id = 0; id < cluster_job.GetTaskSize(); id++) {
+                cluster_job.SetPrefetchRunners(id, {});
+            }
+        }
+        status = runner->PrepareData();
+        ASSERT_TRUE(status.isOK()) << status;
+        status = runner->Compute(&outputs[prefetch ? 0 : 1]);
+        ASSERT_TRUE(status.isOK()) << status;
+    }
+    CheckRows(runners[0]->GetSession()->GetSchema(), outputs[0], outputs[1]);
+}
+
+class PrefetchTest : public ::testing::TestWithParam<SqlCase> {};
+INSTANTIATE_TEST_SUITE_P(
+    EngineTestClusterWindowAndLastJoin, PrefetchTest,
+    testing::ValuesIn(sqlcase::InitCases("/cases/function/cluster/window_and_lastjoin.yaml")));
+TEST_P(PrefetchTest, TestClusterRequestEnginePrefetch) {
+    ParamType sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    if (!sql_case.expect().success_ || boost::contains(sql_case.mode(), "request-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-unsupport") ||
+        boost::contains(sql_case.mode(), "cluster-unsupport")) {
+        LOG(INFO) << "Skip mode " << sql_case.mode();
+        return;
+    }
+    PrefetchCheck(sql_case, kRequestMode);
+}
+TEST_P(PrefetchTest, TestClusterBatchRequestEnginePrefetch) {
+    ParamType sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    if (!sql_case.expect().success_ || boost::contains(sql_case.mode(), "request-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-unsupport") ||
+        boost::contains(sql_case.mode(), "batch-request-unsupport") ||
+        boost::contains(sql_case.mode(), "cluster-unsupport")) {
+        LOG(INFO) << "Skip mode " << sql_case.mode();
+        return;
+    }
+    PrefetchCheck(sql_case, kBatchRequestMode);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -150,6 +150,11 @@ class RefCountedSlice : public Slice {
     RefCountedSlice &operator=(const RefCountedSlice &);
     RefCountedSlice &operator=(RefCountedSlice &&);
 
+    // Give up the ownership of the buffer if the slice is its only owner and
+    // return the buffer, which must be freed with free() by the caller.
+    // The slice still references the buffer. Return nullptr otherwise
+    int8_t *Detach();
+
  private:
     RefCountedSlice(int8_t *data, size_t size, bool managed)
         : Slice(reinterpret_cast<const char *>(data), size),
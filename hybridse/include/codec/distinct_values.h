@@ -0,0 +1,73 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_CODEC_DISTINCT_VALUES_H_
+#define HYBRIDSE_INCLUDE_CODEC_DISTINCT_VALUES_H_
+
+#include <stdint.h>
+#include <string>
+#include <unordered_set>
+
+namespace hybridse {
+namespace codec {
+
+/// \brief The distinct values of distinct_count, which the pre-aggr buckets of
+/// the storage keep and the request path merges.
+///
+/// The values are always kept exactly as their bytes. A DistinctValues with a
+/// `max_exact` limit, as the pre-aggr buckets use, is marked overflowed instead
+/// of keeping more than `max_exact` values, and the reader of an overflowed
+/// bucket has to count the base rows of its range instead.
+///
+/// The encoding is uint32 count, then uint32 length and bytes of every value.
+/// An overflowed state is encoded as uint32 kOverflowTag only.
+class DistinctValues {
+ public:
+    static constexpr uint32_t kDefaultMaxExact = 4096;
+    static constexpr uint32_t kOverflowTag = UINT32_MAX;
+
+    /// \param max_exact the max number of the values kept, 0 for no limit
+    explicit DistinctValues(uint32_t max_exact = 0) : max_exact_(max_exact) {}
+
+    void Add(const char* data, uint32_t size);
+
+    /// \brief Merge the encoded values, return false if they are invalid.
+    /// Merging an overflowed state overflows this one
+    bool MergeEncoded(const char* data, uint32_t size);
+
+    void Encode(std::string* output) const;
+
+    /// \brief The number of the distinct values, not meaningful once overflowed
+    uint64_t Count() const { return vals_.size(); }
+
+    bool IsOverflowed() const { return overflowed_; }
+
+    /// \brief Whether the encoded values are of an overflowed state
+    static bool IsOverflowed(const char* data, uint32_t size);
+
+    void Clear();
+
+ private:
+    void Overflow();
+
+    uint32_t max_exact_;
+    bool overflowed_ = false;
+    std::unordered_set<std::string> vals_;
+};
+
+}  // namespace codec
+}  // namespace hybridse
+#endif  // HYBRIDSE_INCLUDE_CODEC_DISTINCT_VALUES_H_
@@ -80,6 +80,10 @@ class Row {
     inline void Append(const hybridse::base::RefCountedSlice &slice) {
         slices_.emplace_back(slice);
     }
+    // Give up the ownership of the buffer of the pos-th slice, see RefCountedSlice::Detach
+    inline int8_t *DetachBuf(int32_t pos) {
+        return 0 == pos ? slice_.Detach() : slices_[pos - 1].Detach();
+    }
     // Return a string that contains the copy of the referenced data.
     std::string ToString() const;
 
@@ -17,11 +17,16 @@
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_H_
 
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <tuple>
 #include <utility>
 #include <vector>
 #include <unordered_map>
@@ -103,6 +108,24 @@ class EngineOptions {
         return enable_batch_window_parallelization_;
     }
 
+    /// Set the number of threads a window aggregation of batch mode runs its partition keys on when
+    /// batch window parallelization is enabled, `0` for the number of cores. default `0`.
+    inline EngineOptions* SetBatchWindowParallelThreadNum(uint32_t num) {
+        batch_window_parallel_thread_num_ = num;
+        return this;
+    }
+    /// Return the number of threads of a batch mode window aggregation.
+    inline uint32_t GetBatchWindowParallelThreadNum() const { return batch_window_parallel_thread_num_; }
+
+    /// Set `true` to compute the batch mode window aggregations of sum, count, avg, min and max
+    /// with aggregate states that slide with the window, default `false`.
+    inline EngineOptions* SetEnableBatchWindowIncrementalAgg(bool flag) {
+        enable_batch_window_incremental_agg_ = flag;
+        return this;
+    }
+    /// Return if the batch mode window aggregations can be computed incrementally.
+    inline bool IsEnableBatchWindowIncrementalAgg() const { return enable_batch_window_incremental_agg_; }
+
     /// Set `true` to enable window column purning
     inline EngineOptions* SetEnableWindowColumnPruning(bool flag) {
         enable_window_column_pruning_ = flag;
@@ -131,6 +154,8 @@ class EngineOptions {
     bool batch_request_optimized_;
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
+    uint32_t batch_window_parallel_thread_num_;
+    bool enable_batch_window_incremental_agg_;
     bool enable_window_column_pruning_;
     uint32_t max_sql_cache_size_;
     JitOptions jit_options_;
@@ -361,13 +386,28 @@ class Engine {
 
     static void InitializeUnsafeRowOptFlag(bool isUnsafeRowOpt);
 
+    /// \brief Get the hit count, the miss count and the bytes of the jit object cache of `dir`.
+    /// Return false if no engine of the process has opened the cache.
+    static bool GetJitObjectCacheStats(const std::string& dir, uint64_t* hit_cnt, uint64_t* miss_cnt,
+                                       uint64_t* size);
+
     ~Engine();
 
     /// \brief Compile sql in db and stored the results in the session
+    ///
+    /// The concurrent calls of the same sql, db and engine mode share one compilation,
+    /// the followers wait for the first caller instead of compiling again.
     bool Get(const std::string& sql, const std::string& db,
              RunSession& session,    // NOLINT
              base::Status& status);  // NOLINT
 
+    /// \brief Compile sql in db on the background thread of the engine and store the results in the cache
+    ///
+    /// The session decides the engine mode and the compile options, and it gets the results as `Get` does.
+    /// The callback, if any, is invoked with the compile status on the background thread.
+    void PreCompile(const std::string& sql, const std::string& db, std::shared_ptr<RunSession> session,
+                    std::function<void(const base::Status&)> callback = nullptr);
+
     /// \brief Search all tables related to the specific sql in db.
     ///
     /// The tables' names are returned in tables
@@ -436,10 +476,45 @@ class Engine {
                  EngineMode engine_mode, const codec::Schema& parameter_schema,
                  const std::set<size_t>& common_column_indices,
                  ExplainOutput* explain_output, base::Status* status);
+
+    /// Compile sql without looking up the cache, then add the results into the cache
+    bool Compile(const std::string& sql, const std::string& db,
+                 RunSession& session,    // NOLINT
+                 base::Status& status);  // NOLINT
+
+    void PreCompileLoop();
+
+    /// A compilation in progress, the followers wait until it is done
+    struct CompileFlight {
+        std::mutex mu;
+        std::condition_variable cv;
+        bool done = false;
+        /// nullptr if the compilation fails
+        std::shared_ptr<CompileInfo> info;
+    };
+
+    struct PreCompileTask {
+        std::string sql;
+        std::string db;
+        std::shared_ptr<RunSession> session;
+        std::function<void(const base::Status&)> callback;
+    };
+
     std::shared_ptr<Catalog> cl_;
     EngineOptions options_;
     base::SpinMutex mu_;
     EngineLRUCache lru_cache_;
+
+    std::mutex compile_mu_;
+    /// (engine mode, db, sql) -> the compilation in progress
+    std::map<std::tuple<EngineMode, std::string, std::string>, std::shared_ptr<CompileFlight>> compiling_;
+
+    std::mutex pre_compile_mu_;
+    std::condition_variable pre_compile_cv_;
+    std::deque<PreCompileTask> pre_compile_tasks_;
+    /// started by the first PreCompile
+    std::thread pre_compile_thread_;
+    bool stopped_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
@@ -101,11 +101,22 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    /// The directory of the on-disk object cache, disabled if empty
+    const std::string& GetObjectCacheDir() const { return object_cache_dir_; }
+    void SetObjectCacheDir(const std::string& dir) { object_cache_dir_ = dir; }
+
+    /// The max bytes of the objects in the object cache directory, the least
+    /// recently used objects are removed beyond it. 0 for no limit
+    uint64_t GetObjectCacheMaxSize() const { return object_cache_max_size_; }
+    void SetObjectCacheMaxSize(uint64_t size) { object_cache_max_size_ = size; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    std::string object_cache_dir_;
+    uint64_t object_cache_max_size_ = 0;
 };
 }  // namespace vm
 }  // namespace hybridse
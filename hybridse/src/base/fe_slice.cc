@@ -32,6 +32,15 @@ void RefCountedSlice::Release() {
     }
 }
 
+int8_t* RefCountedSlice::Detach() {
+    if (this->ref_cnt_ == nullptr || *this->ref_cnt_ != 1) {
+        return nullptr;
+    }
+    delete this->ref_cnt_;
+    this->ref_cnt_ = nullptr;
+    return buf();
+}
+
 void RefCountedSlice::Update(const RefCountedSlice& slice) {
     reset(slice.data(), slice.size());
     this->ref_cnt_ = slice.ref_cnt_;
@@ -46,6 +46,25 @@ TEST_F(SliceTest, ref_cnt_slice) {
     ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(ref.buf()), "hello world"));
 }
 
+TEST_F(SliceTest, detach) {
+    auto buf = reinterpret_cast<int8_t*>(malloc(16));
+    auto slice = RefCountedSlice::CreateManaged(buf, 16);
+    {
+        RefCountedSlice copy = slice;
+        // shared by two slices
+        ASSERT_EQ(nullptr, slice.Detach());
+    }
+    ASSERT_EQ(buf, slice.Detach());
+    // not owned any more
+    ASSERT_EQ(nullptr, slice.Detach());
+    ASSERT_EQ(buf, slice.buf());
+    free(buf);
+
+    char data[] = "hello";
+    auto view = RefCountedSlice::Create(data, 5);
+    ASSERT_EQ(nullptr, view.Detach());
+}
+
 }  // namespace base
 }  // namespace hybridse
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/distinct_values.h"
+
+namespace hybridse {
+namespace codec {
+
+void DistinctValues::Add(const char* data, uint32_t size) {
+    if (overflowed_) {
+        return;
+    }
+    vals_.emplace(data, size);
+    if (max_exact_ > 0 && vals_.size() > max_exact_) {
+        Overflow();
+    }
+}
+
+bool DistinctValues::MergeEncoded(const char* data, uint32_t size) {
+    if (size < sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t cnt = *reinterpret_cast<const uint32_t*>(data);
+    uint32_t pos = sizeof(uint32_t);
+    if (cnt == kOverflowTag) {
+        // the buckets written as a sketch by the earlier versions carry more bytes, they are overflowed too
+        Overflow();
+        return true;
+    }
+    for (uint32_t i = 0; i < cnt; i++) {
+        if (size - pos < sizeof(uint32_t)) {
+            return false;
+        }
+        uint32_t len = *reinterpret_cast<const uint32_t*>(data + pos);
+        pos += sizeof(uint32_t);
+        if (size - pos < len) {
+            return false;
+        }
+        Add(data + pos, len);
+        pos += len;
+    }
+    return pos == size;
+}
+
+void DistinctValues::Encode(std::string* output) const {
+    if (overflowed_) {
+        uint32_t tag = kOverflowTag;
+        output->assign(reinterpret_cast<const char*>(&tag), sizeof(uint32_t));
+        return;
+    }
+    uint32_t cnt = vals_.size();
+    output->assign(reinterpret_cast<const char*>(&cnt), sizeof(uint32_t));
+    for (const auto& val : vals_) {
+        uint32_t len = val.size();
+        output->append(reinterpret_cast<const char*>(&len), sizeof(uint32_t));
+        output->append(val);
+    }
+}
+
+bool DistinctValues::IsOverflowed(const char* data, uint32_t size) {
+    return size >= sizeof(uint32_t) && *reinterpret_cast<const uint32_t*>(data) == kOverflowTag;
+}
+
+void DistinctValues::Clear() {
+    overflowed_ = false;
+    vals_.clear();
+}
+
+void DistinctValues::Overflow() {
+    overflowed_ = true;
+    // release the memory of the set
+    std::unordered_set<std::string>().swap(vals_);
+}
+
+}  // namespace codec
+}  // namespace hybridse
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/distinct_values.h"
+#include <string>
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace codec {
+
+class DistinctValuesTest : public ::testing::Test {};
+
+TEST_F(DistinctValuesTest, ExactEncode) {
+    DistinctValues vals;
+    for (int64_t i = 0; i < 100; i++) {
+        int64_t val = i % 10;
+        vals.Add(reinterpret_cast<char*>(&val), sizeof(int64_t));
+    }
+    vals.Add("", 0);
+    ASSERT_FALSE(vals.IsOverflowed());
+    ASSERT_EQ(11u, vals.Count());
+    std::string encoded;
+    vals.Encode(&encoded);
+    // uint32 count, then uint32 length and bytes of every value
+    ASSERT_EQ(11u, *reinterpret_cast<const uint32_t*>(encoded.data()));
+    ASSERT_EQ(sizeof(uint32_t) + 11 * sizeof(uint32_t) + 10 * sizeof(int64_t), encoded.size());
+
+    DistinctValues merged;
+    int64_t other = 100;
+    merged.Add(reinterpret_cast<char*>(&other), sizeof(int64_t));
+    ASSERT_TRUE(merged.MergeEncoded(encoded.data(), encoded.size()));
+    ASSERT_TRUE(merged.MergeEncoded(encoded.data(), encoded.size()));
+    ASSERT_EQ(12u, merged.Count());
+
+    ASSERT_FALSE(merged.MergeEncoded(encoded.data(), 2));
+    ASSERT_FALSE(merged.MergeEncoded(encoded.data(), encoded.size() - 1));
+    std::string tail = encoded + "x";
+    ASSERT_FALSE(merged.MergeEncoded(tail.data(), tail.size()));
+}
+
+TEST_F(DistinctValuesTest, Overflow) {
+    // no limit by default
+    DistinctValues unlimited;
+    for (int i = 0; i < 10000; i++) {
+        std::string val = "key" + std::to_string(i);
+        unlimited.Add(val.data(), val.size());
+    }
+    ASSERT_FALSE(unlimited.IsOverflowed());
+    ASSERT_EQ(10000u, unlimited.Count());
+
+    DistinctValues vals(100);
+    for (int i = 0; i < 200; i++) {
+        std::string val = "key" + std::to_string(i % 100);
+        vals.Add(val.data(), val.size());
+    }
+    ASSERT_FALSE(vals.IsOverflowed());
+    ASSERT_EQ(100u, vals.Count());
+    std::string val = "key100";
+    vals.Add(val.data(), val.size());
+    ASSERT_TRUE(vals.IsOverflowed());
+    std::string encoded;
+    vals.Encode(&encoded);
+    ASSERT_EQ(sizeof(uint32_t), encoded.size());
+    ASSERT_TRUE(DistinctValues::IsOverflowed(encoded.data(), encoded.size()));
+
+    std::string exact_encoded;
+    unlimited.Encode(&exact_encoded);
+    ASSERT_FALSE(DistinctValues::IsOverflowed(exact_encoded.data(), exact_encoded.size()));
+    DistinctValues merged;
+    ASSERT_TRUE(merged.MergeEncoded(exact_encoded.data(), exact_encoded.size()));
+    ASSERT_FALSE(merged.IsOverflowed());
+    ASSERT_TRUE(merged.MergeEncoded(encoded.data(), encoded.size()));
+    ASSERT_TRUE(merged.IsOverflowed());
+    // stays overflowed until cleared
+    ASSERT_TRUE(merged.MergeEncoded(exact_encoded.data(), exact_encoded.size()));
+    merged.Encode(&encoded);
+    ASSERT_TRUE(DistinctValues::IsOverflowed(encoded.data(), encoded.size()));
+    merged.Clear();
+    ASSERT_FALSE(merged.IsOverflowed());
+    ASSERT_EQ(0u, merged.Count());
+
+    // the sketch buckets of the earlier versions are taken as overflowed
+    std::string sketch = encoded + std::string(1 + 4096, '\0');
+    DistinctValues old;
+    ASSERT_TRUE(old.MergeEncoded(sketch.data(), sketch.size()));
+    ASSERT_TRUE(old.IsOverflowed());
+}
+
+}  // namespace codec
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
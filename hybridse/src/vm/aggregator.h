@@ -21,8 +21,10 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/algorithm/string/compare.hpp>
 
+#include "codec/distinct_values.h"
 #include "codec/fe_row_codec.h"
 #include "codec/row.h"
 #include "proto/fe_type.pb.h"
@@ -83,6 +85,13 @@ class Aggregator : public BaseAggregator {
 
     virtual void UpdateValue(const T& val) = 0;
 
+    // update by a span of not null values, subclasses override it with a loop the compiler can vectorize
+    virtual void UpdateValues(const T* vals, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            UpdateValue(vals[i]);
+        }
+    }
+
     void Update(const std::string& bval) override {
         UpdateInternal(bval);
     }
@@ -218,6 +227,15 @@ class SumAggregator : public Aggregator<T> {
         DLOG(INFO) << "Update " << Type_Name(this->type_) << " val " << val << ", sum = " << this->val_;
     }
 
+    void UpdateValues(const T* vals, size_t n) override {
+        T sum = this->val_;
+        for (size_t i = 0; i < n; i++) {
+            sum += vals[i];
+        }
+        this->val_ = sum;
+        this->counter_ += n;
+    }
+
     type::Type GetRepType() const override {
         switch (this->type()) {
             case type::kInt16:
@@ -262,6 +280,15 @@ class AvgAggregator : public Aggregator<double> {
         UpdateAvgValue(sum_val, 1);
     }
 
+    void UpdateValues(const double* vals, size_t n) override {
+        double sum = this->val_;
+        for (size_t i = 0; i < n; i++) {
+            sum += vals[i];
+        }
+        this->val_ = sum;
+        this->counter_ += n;
+    }
+
     // val is assumed to be not null
     void UpdateAvgValue(const double& sum_val, int64_t count) {
         this->val_ += sum_val;
@@ -318,6 +345,19 @@ class MinAggregator : public Aggregator<T> {
         DLOG(INFO) << "Update " << Type_Name(this->type_) << " val " << val << ", min = " << this->val_;
     }
 
+    void UpdateValues(const T* vals, size_t n) override {
+        if constexpr (std::is_arithmetic_v<T>) {
+            T min_val = this->val_;
+            for (size_t i = 0; i < n; i++) {
+                min_val = vals[i] < min_val ? vals[i] : min_val;
+            }
+            this->val_ = min_val;
+            this->counter_ += n;
+        } else {
+            Aggregator<T>::UpdateValues(vals, n);
+        }
+    }
+
  protected:
     template <class TT = T>
     void UpdateInternal(const TT& val, std::enable_if_t<std::is_arithmetic<TT>{}>* = nullptr) {
@@ -349,6 +389,19 @@ class MaxAggregator : public Aggregator<T> {
         DLOG(INFO) << "Update " << Type_Name(this->type_) << " val " << val << ", min = " << this->val_;
     }
 
+    void UpdateValues(const T* vals, size_t n) override {
+        if constexpr (std::is_arithmetic_v<T>) {
+            T max_val = this->val_;
+            for (size_t i = 0; i < n; i++) {
+                max_val = vals[i] > max_val ? vals[i] : max_val;
+            }
+            this->val_ = max_val;
+            this->counter_ += n;
+        } else {
+            Aggregator<T>::UpdateValues(vals, n);
+        }
+    }
+
  protected:
     // val is assumed to be not null
     template <class TT = T>
@@ -368,6 +421,60 @@ class MaxAggregator : public Aggregator<T> {
     }
 };
 
+// distinct_count by merging the distinct values of the pre-aggr buckets, which are encoded by codec::DistinctValues.
+// the values of an overflowed bucket are not kept, the caller updates the values of its base rows instead
+template <class T>
+class DistinctCountAggregator : public Aggregator<T> {
+ public:
+    DistinctCountAggregator(type::Type type, const Schema& output_schema)
+        : Aggregator<T>(type, output_schema, T()) {}
+
+    // val is assumed to be not null
+    void UpdateValue(const T& val) override {
+        if constexpr (std::is_arithmetic_v<T>) {
+            vals_.Add(reinterpret_cast<const char*>(&val), sizeof(T));
+        } else {
+            vals_.Add(val.data(), val.size());
+        }
+        this->counter_++;
+    }
+
+    // merge the values of a bucket
+    void Update(const std::string& bval) override {
+        if (codec::DistinctValues::IsOverflowed(bval.data(), bval.size())) {
+            LOG(ERROR) << "the values of an overflowed bucket can not be merged";
+            return;
+        }
+        if (!vals_.MergeEncoded(bval.data(), bval.size())) {
+            LOG(ERROR) << "encoded aggr val is not valid";
+            return;
+        }
+        this->counter_++;
+    }
+
+    Row Output() override {
+        uint32_t total_len = this->row_builder_.CalTotalLength(0);
+        int8_t* buf = static_cast<int8_t*>(malloc(total_len));
+        this->row_builder_.SetBuffer(buf, total_len);
+        this->row_builder_.AppendInt64(vals_.Count());
+        Reset();
+        return Row(base::RefCountedSlice::CreateManaged(buf, total_len));
+    }
+
+    bool IsNull() const override {
+        return false;
+    }
+
+    void Reset() override {
+        Aggregator<T>::Reset();
+        vals_.Clear();
+    }
+
+ private:
+    // the values are kept as their bytes, so that they can be merged with the bucket values directly
+    codec::DistinctValues vals_;
+};
+
 template <template<class> class AggregatorClass>
 std::unique_ptr<BaseAggregator> MakeOverflowAggregator(type::Type agg_col_type, const Schema& output_schema) {
     switch (agg_col_type) {
@@ -456,6 +563,85 @@ std::enable_if_t<!std::is_arithmetic<T>{}> AggregatorUpdate(BaseAggregator* aggr
     }
 }
 
+// Buffer the not null values of the aggregate column in a window span and reduce them with
+// Aggregator::UpdateValues, instead of a type dispatch and a virtual call for every row.
+// The values are converted to the representative type of the aggregator when appended.
+// Flush must be called before the aggregator is updated by other ways or output.
+class AggregatorBatchUpdater {
+ public:
+    explicit AggregatorBatchUpdater(BaseAggregator* aggregator, size_t batch_size = 1024)
+        : aggregator_(aggregator), rep_type_(aggregator->GetRepType()), batch_size_(batch_size) {}
+
+    template <class T>
+    std::enable_if_t<std::is_arithmetic<T>{}> Append(const T& val) {
+        switch (rep_type_) {
+            case type::kInt16:
+                Push(&i16_vals_, val);
+                break;
+            case type::kDate:
+            case type::kInt32:
+                Push(&i32_vals_, val);
+                break;
+            case type::kTimestamp:
+            case type::kInt64:
+                Push(&i64_vals_, val);
+                break;
+            case type::kFloat:
+                Push(&float_vals_, val);
+                break;
+            case type::kDouble:
+                Push(&double_vals_, val);
+                break;
+            default:
+                LOG(ERROR) << "ERROR: unsupport type " << Type_Name(rep_type_);
+                break;
+        }
+    }
+
+    // for count, the aggregator must be a CountAggregator
+    void AppendCount() { count_++; }
+
+    void Flush() {
+        FlushValues(&i16_vals_);
+        FlushValues(&i32_vals_);
+        FlushValues(&i64_vals_);
+        FlushValues(&float_vals_);
+        FlushValues(&double_vals_);
+        if (count_ > 0) {
+            dynamic_cast<Aggregator<int64_t>*>(aggregator_)->UpdateValue(count_);
+            count_ = 0;
+        }
+    }
+
+ private:
+    template <class V, class T>
+    void Push(std::vector<V>* vals, const T& val) {
+        vals->push_back(static_cast<V>(val));
+        if (vals->size() >= batch_size_) {
+            FlushValues(vals);
+        }
+    }
+
+    template <class V>
+    void FlushValues(std::vector<V>* vals) {
+        if (vals->empty()) {
+            return;
+        }
+        dynamic_cast<Aggregator<V>*>(aggregator_)->UpdateValues(vals->data(), vals->size());
+        vals->clear();
+    }
+
+    BaseAggregator* aggregator_;
+    type::Type rep_type_;
+    size_t batch_size_;
+    std::vector<int16_t> i16_vals_;
+    std::vector<int32_t> i32_vals_;
+    std::vector<int64_t> i64_vals_;
+    std::vector<float> float_vals_;
+    std::vector<double> double_vals_;
+    int64_t count_ = 0;
+};
+
 }  // namespace vm
 }  // namespace hybridse
 
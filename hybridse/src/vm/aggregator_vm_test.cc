@@ -17,6 +17,7 @@
 #include "gtest/gtest.h"
 #include "proto/fe_type.pb.h"
 #include "vm/aggregator.h"
+#include "codec/distinct_values.h"
 #include "codec/fe_row_codec.h"
 
 namespace hybridse {
@@ -550,6 +551,107 @@ TEST_F(AggregatorVMTest, NullTest) {
     check_null(aggregator.get());
 }
 
+TEST_F(AggregatorVMTest, BatchUpdateTest) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt32);
+    column->set_name("val");
+
+    // small batch size to flush in the middle
+    auto sum_aggregator = MakeOverflowAggregator<SumAggregator>(type::kInt32, schema);
+    auto min_aggregator = MakeSameTypeAggregator<MinAggregator>(type::kInt32, schema);
+    auto max_aggregator = MakeSameTypeAggregator<MaxAggregator>(type::kInt32, schema);
+    auto avg_aggregator = std::make_unique<AvgAggregator>(type::kInt32, schema);
+    auto count_aggregator = std::make_unique<CountAggregator>(type::kInt32, schema);
+    AggregatorBatchUpdater sum_updater(sum_aggregator.get(), 7);
+    AggregatorBatchUpdater min_updater(min_aggregator.get(), 7);
+    AggregatorBatchUpdater max_updater(max_aggregator.get(), 7);
+    AggregatorBatchUpdater avg_updater(avg_aggregator.get(), 7);
+    AggregatorBatchUpdater count_updater(count_aggregator.get(), 7);
+
+    int64_t sum = 0;
+    for (int32_t i = 0; i < 100; i++) {
+        int32_t val = (i % 2 == 0) ? i : -i;
+        sum += val;
+        sum_updater.Append(val);
+        min_updater.Append(val);
+        max_updater.Append(val);
+        avg_updater.Append(val);
+        count_updater.AppendCount();
+    }
+    sum_updater.Flush();
+    min_updater.Flush();
+    max_updater.Flush();
+    avg_updater.Flush();
+    count_updater.Flush();
+
+    EXPECT_EQ(sum, dynamic_cast<Aggregator<int64_t>*>(sum_aggregator.get())->val());
+    EXPECT_EQ(-99, dynamic_cast<Aggregator<int32_t>*>(min_aggregator.get())->val());
+    EXPECT_EQ(98, dynamic_cast<Aggregator<int32_t>*>(max_aggregator.get())->val());
+    EXPECT_DOUBLE_EQ(static_cast<double>(sum) / 100, avg_aggregator->val());
+    EXPECT_EQ(100, count_aggregator->val());
+    EXPECT_FALSE(min_aggregator->IsNull());
+}
+
+TEST_F(AggregatorVMTest, DistinctCountTest) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("val");
+    codec::RowView row_view(schema);
+
+    // encode the distinct values of a bucket as the pre-aggr table does
+    auto encode_state = [](const std::vector<std::string>& vals, uint32_t max_exact) {
+        codec::DistinctValues distinct_vals(max_exact);
+        for (const auto& val : vals) {
+            distinct_vals.Add(val.data(), val.size());
+        }
+        std::string state;
+        distinct_vals.Encode(&state);
+        return state;
+    };
+    auto exact_state = [&](const std::vector<std::string>& vals) {
+        return encode_state(vals, codec::DistinctValues::kDefaultMaxExact);
+    };
+    auto int_bytes = [](int32_t val) { return std::string(reinterpret_cast<char*>(&val), sizeof(int32_t)); };
+
+    auto aggregator = MakeSameTypeAggregator<DistinctCountAggregator>(type::kInt32, schema);
+    ASSERT_TRUE(aggregator != nullptr);
+    EXPECT_FALSE(aggregator->IsNull());
+    AggregatorBatchUpdater updater(aggregator.get(), 7);
+    for (int32_t i = 0; i < 100; i++) {
+        updater.Append(i % 10);
+    }
+    updater.Flush();
+    aggregator->Update(exact_state({int_bytes(5), int_bytes(10), int_bytes(11)}));
+    aggregator->Update(exact_state({int_bytes(11), int_bytes(12)}));
+    Row row = aggregator->Output();
+    row_view.Reset(row.buf());
+    EXPECT_EQ(13, row_view.GetInt64Unsafe(0));
+
+    // an overflowed bucket is not merged, its base rows are updated by the caller
+    updater.Append(1);
+    updater.Flush();
+    aggregator->Update(encode_state({int_bytes(2), int_bytes(3), int_bytes(5)}, 2));
+    aggregator->Update(exact_state({int_bytes(3), int_bytes(4)}));
+    row = aggregator->Output();
+    row_view.Reset(row.buf());
+    EXPECT_EQ(3, row_view.GetInt64Unsafe(0));
+
+    // reset after output
+    row = aggregator->Output();
+    row_view.Reset(row.buf());
+    EXPECT_EQ(0, row_view.GetInt64Unsafe(0));
+
+    auto str_aggregator = MakeSameTypeAggregator<DistinctCountAggregator>(type::kVarchar, schema);
+    AggregatorUpdate(str_aggregator.get(), std::string("abc"));
+    AggregatorUpdate(str_aggregator.get(), std::string("abc"));
+    str_aggregator->Update(exact_state({"abc", "hello"}));
+    row = str_aggregator->Output();
+    row_view.Reset(row.buf());
+    EXPECT_EQ(2, row_view.GetInt64Unsafe(0));
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -28,6 +28,7 @@
 #include "gflags/gflags.h"
 #include "llvm-c/Target.h"
 #include "udf/default_udf_library.h"
+#include "vm/jit_object_cache.h"
 #include "vm/local_tablet_handler.h"
 #include "vm/mem_catalog.h"
 #include "vm/sql_compiler.h"
@@ -47,14 +48,33 @@ EngineOptions::EngineOptions()
       batch_request_optimized_(true),
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
+      batch_window_parallel_thread_num_(0),
+      enable_batch_window_incremental_agg_(false),
       enable_window_column_pruning_(false),
       max_sql_cache_size_(50) {
 }
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+Engine::Engine(const std::shared_ptr<Catalog>& catalog)
+    : cl_(catalog), options_(), mu_(), lru_cache_(), compiling_(), pre_compile_tasks_(), stopped_(false) {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
-Engine::~Engine() {}
+    : cl_(catalog), options_(options), mu_(), lru_cache_(), compiling_(), pre_compile_tasks_(), stopped_(false) {}
+Engine::~Engine() {
+    std::deque<PreCompileTask> tasks;
+    {
+        std::lock_guard<std::mutex> lock(pre_compile_mu_);
+        stopped_ = true;
+        tasks.swap(pre_compile_tasks_);
+    }
+    pre_compile_cv_.notify_all();
+    if (pre_compile_thread_.joinable()) {
+        pre_compile_thread_.join();
+    }
+    for (auto& task : tasks) {
+        if (task.callback) {
+            task.callback(Status(common::kEngineCacheError, "engine is stopped before the pre-compile"));
+        }
+    }
+}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
     LLVMInitializeNativeTarget();
@@ -66,6 +86,18 @@ void Engine::InitializeUnsafeRowOptFlag(bool isUnsafeRowOpt) {
     FLAGS_enable_spark_unsaferow_format = isUnsafeRowOpt;
 }
 
+bool Engine::GetJitObjectCacheStats(const std::string& dir, uint64_t* hit_cnt, uint64_t* miss_cnt,
+                                    uint64_t* size) {
+    auto cache = JitObjectCache::Get(dir);
+    if (cache == nullptr) {
+        return false;
+    }
+    *hit_cnt = cache->GetHitCount();
+    *miss_cnt = cache->GetMissCount();
+    *size = cache->GetSize();
+    return true;
+}
+
 bool Engine::GetDependentTables(const std::string& sql, const std::string& db, EngineMode engine_mode,
                                 std::set<std::pair<std::string, std::string>>* db_tables, base::Status& status) {
     auto info = std::make_shared<hybridse::vm::SqlCompileInfo>();
@@ -212,6 +244,61 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
         LOG(WARNING) << status;
         status = base::Status::OK();
     }
+    auto key = std::make_tuple(session.engine_mode(), db, sql);
+    std::shared_ptr<CompileFlight> flight;
+    bool leader = false;
+    {
+        std::lock_guard<std::mutex> lock(compile_mu_);
+        auto iter = compiling_.find(key);
+        if (iter != compiling_.end()) {
+            flight = iter->second;
+        } else {
+            // the compilation may have finished after the lookup above
+            cached_info = GetCacheLocked(db, sql, session.engine_mode());
+            if (cached_info && IsCompatibleCache(session, cached_info, status)) {
+                session.SetCompileInfo(cached_info);
+                return true;
+            }
+            status = base::Status::OK();
+            flight = std::make_shared<CompileFlight>();
+            compiling_.emplace(key, flight);
+            leader = true;
+        }
+    }
+    if (!leader) {
+        std::shared_ptr<CompileInfo> info;
+        {
+            std::unique_lock<std::mutex> lock(flight->mu);
+            flight->cv.wait(lock, [&flight] { return flight->done; });
+            info = flight->info;
+        }
+        if (info && IsCompatibleCache(session, info, status)) {
+            session.SetCompileInfo(info);
+            return true;
+        }
+        // the first caller failed or compiled with other parameters
+        status = base::Status::OK();
+        return Compile(sql, db, session, status);
+    }
+    bool ok = Compile(sql, db, session, status);
+    {
+        // erase after the results are cached, so the later callers hit the cache
+        std::lock_guard<std::mutex> lock(compile_mu_);
+        compiling_.erase(key);
+    }
+    {
+        std::lock_guard<std::mutex> lock(flight->mu);
+        flight->done = true;
+        if (ok) {
+            flight->info = session.GetCompileInfo();
+        }
+    }
+    flight->cv.notify_all();
+    return ok;
+}
+
+bool Engine::Compile(const std::string& sql, const std::string& db, RunSession& session,
+                     base::Status& status) {  // NOLINT (runtime/references)
     DLOG(INFO) << "Compile Engine ...";
     status = base::Status::OK();
     std::shared_ptr<SqlCompileInfo> info = std::make_shared<SqlCompileInfo>();
@@ -222,6 +309,8 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.is_cluster_optimized = options_.IsClusterOptimzied();
     sql_context.is_batch_request_optimized = options_.IsBatchRequestOptimized();
     sql_context.enable_batch_window_parallelization = options_.IsEnableBatchWindowParallelization();
+    sql_context.batch_window_parallel_thread_num = options_.GetBatchWindowParallelThreadNum();
+    sql_context.enable_batch_window_incremental_agg = options_.IsEnableBatchWindowIncrementalAgg();
     sql_context.enable_window_column_pruning = options_.IsEnableWindowColumnPruning();
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
     sql_context.jit_options = options_.jit_options();
@@ -262,6 +351,55 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     return true;
 }
 
+void Engine::PreCompile(const std::string& sql, const std::string& db, std::shared_ptr<RunSession> session,
+                        std::function<void(const base::Status&)> callback) {
+    if (!session) {
+        if (callback) {
+            callback(Status(common::kNullInputPointer, "run session is null"));
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pre_compile_mu_);
+        if (!stopped_) {
+            pre_compile_tasks_.push_back({sql, db, std::move(session), std::move(callback)});
+            if (!pre_compile_thread_.joinable()) {
+                pre_compile_thread_ = std::thread(&Engine::PreCompileLoop, this);
+            }
+            pre_compile_cv_.notify_one();
+            return;
+        }
+    }
+    if (callback) {
+        callback(Status(common::kEngineCacheError, "engine is stopped before the pre-compile"));
+    }
+}
+
+void Engine::PreCompileLoop() {
+    while (true) {
+        PreCompileTask task;
+        {
+            std::unique_lock<std::mutex> lock(pre_compile_mu_);
+            pre_compile_cv_.wait(lock, [this] { return stopped_ || !pre_compile_tasks_.empty(); });
+            if (stopped_) {
+                return;
+            }
+            task = std::move(pre_compile_tasks_.front());
+            pre_compile_tasks_.pop_front();
+        }
+        base::Status status;
+        if (!Get(task.sql, task.db, *task.session, status)) {
+            if (status.isOK()) {
+                status = Status(common::kEngineCacheError, "fail to pre-compile sql");
+            }
+            LOG(WARNING) << "fail to pre-compile sql in db " << task.db << ": " << status;
+        }
+        if (task.callback) {
+            task.callback(status);
+        }
+    }
+}
+
 base::Status Engine::RegisterExternalFunction(const std::string& name, node::DataType return_type,
                                          const std::vector<node::DataType>& arg_types, bool is_aggregate,
                                          const std::string& file) {
@@ -452,8 +590,17 @@ int32_t RequestRunSession::Run(const uint32_t task_id, const Row& in_row, Row* o
         return -2;
     }
     DLOG(INFO) << "Request Row Run with task_id " << task_id;
-    RunnerContext ctx(&std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job, in_row,
-                      sp_name_, is_debug_);
+    auto& cluster_job = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job;
+    RunnerContext ctx(&cluster_job, in_row, sp_name_, is_debug_);
+    // send the independent subqueries together, their results are joined
+    // lazily when the task reads them
+    for (auto runner : cluster_job.GetPrefetchRunners(task_id)) {
+        // a failed subquery fails the request instead of being sent again by the task
+        if (!runner->RunWithCache(ctx)) {
+            LOG(WARNING) << "fail to prefetch the subquery of runner " << runner->id_;
+            return -1;
+        }
+    }
     auto output = task->RunWithCache(ctx);
     if (!output) {
         LOG(WARNING) << "Run request plan output is null";
@@ -480,6 +627,14 @@ int32_t BatchRequestRunSession::Run(const uint32_t id, const std::vector<Row>& r
         LOG(WARNING) << "Fail to run request plan: taskid" << id << " not exist!";
         return -2;
     }
+    for (auto runner : std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)
+                           ->get_sql_context()
+                           .cluster_job.GetPrefetchRunners(id)) {
+        if (!runner->BatchRequestRun(ctx)) {
+            LOG(WARNING) << "fail to prefetch the subquery of runner " << runner->id_;
+            return -1;
+        }
+    }
     auto handler = task->BatchRequestRun(ctx);
     if (!handler) {
         LOG(WARNING) << "Run request plan output is null";
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <future>  // NOLINT
+#include <thread>  // NOLINT
+
 #include "case/case_data_mock.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
@@ -663,6 +666,61 @@ TEST_F(EngineCompileTest, ExternalFunctionTest) {
     std::string sql2 = "select cut2(col0) from t1;";
     ASSERT_TRUE(engine.Get(sql2, "simple_db", session, get_status));
 }
+
+TEST_F(EngineCompileTest, EngineSingleFlightAndPreCompileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    Engine engine(catalog, options);
+
+    // the concurrent gets share one compilation
+    std::string sql = "select col1, col2 + 1 as c2 from t1;";
+    std::vector<std::shared_ptr<CompileInfo>> infos(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < infos.size(); i++) {
+        threads.emplace_back([&engine, &sql, &infos, i] {
+            base::Status status;
+            BatchRunSession session;
+            if (engine.Get(sql, "simple_db", session, status)) {
+                infos[i] = session.GetCompileInfo();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& info : infos) {
+        ASSERT_TRUE(info != nullptr);
+        ASSERT_EQ(infos[0].get(), info.get());
+    }
+
+    // pre-compile fills the cache without blocking the caller
+    std::string sql2 = "select col1, col2 + 2 as c2 from t1;";
+    auto session = std::make_shared<BatchRunSession>();
+    std::promise<base::Status> promise;
+    auto future = promise.get_future();
+    engine.PreCompile(sql2, "simple_db", session, [&promise](const base::Status& status) { promise.set_value(status); });
+    ASSERT_TRUE(future.get().isOK());
+    BatchRunSession session2;
+    base::Status get_status;
+    ASSERT_TRUE(engine.Get(sql2, "simple_db", session2, get_status));
+    ASSERT_EQ(session->GetCompileInfo().get(), session2.GetCompileInfo().get());
+
+    std::promise<base::Status> fail_promise;
+    auto fail_future = fail_promise.get_future();
+    engine.PreCompile("select not_exist from t1;", "simple_db", std::make_shared<BatchRunSession>(),
+                      [&fail_promise](const base::Status& status) { fail_promise.set_value(status); });
+    ASSERT_FALSE(fail_future.get().isOK());
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -0,0 +1,465 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/incremental_window_agg.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "absl/strings/ascii.h"
+#include "glog/logging.h"
+
+namespace hybridse {
+namespace vm {
+
+static bool IsIntegerType(type::Type type) {
+    switch (type) {
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+        case type::kTimestamp:
+        case type::kDate:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool IsFloatType(type::Type type) { return type == type::kFloat || type == type::kDouble; }
+
+static inline const int8_t* GetSliceBuf(const codec::Row& row, size_t schema_idx) {
+    return static_cast<int32_t>(schema_idx) < row.GetRowPtrCnt() ? row.buf(schema_idx) : nullptr;
+}
+
+static bool CheckAggregate(IncrementalWindowAgg::ProjectKind kind, type::Type input_type, type::Type output_type) {
+    switch (kind) {
+        case IncrementalWindowAgg::kSum:
+            // the sums of float types depend on the adding order
+            return input_type != type::kDate && IsIntegerType(input_type) && output_type == input_type;
+        case IncrementalWindowAgg::kCount:
+            return output_type == type::kInt64;
+        case IncrementalWindowAgg::kAvg:
+            // the double sum of small integers is exact in any order
+            return (input_type == type::kInt16 || input_type == type::kInt32) && output_type == type::kDouble;
+        case IncrementalWindowAgg::kMin:
+        case IncrementalWindowAgg::kMax:
+            return (IsIntegerType(input_type) || IsFloatType(input_type)) && output_type == input_type;
+        default:
+            return false;
+    }
+}
+
+static IncrementalWindowAgg::ProjectKind GetAggregateKind(const std::string& name, bool* ok) {
+    *ok = true;
+    std::string lower = absl::AsciiStrToLower(name);
+    if (lower == "sum") {
+        return IncrementalWindowAgg::kSum;
+    } else if (lower == "count") {
+        return IncrementalWindowAgg::kCount;
+    } else if (lower == "avg") {
+        return IncrementalWindowAgg::kAvg;
+    } else if (lower == "min") {
+        return IncrementalWindowAgg::kMin;
+    } else if (lower == "max") {
+        return IncrementalWindowAgg::kMax;
+    }
+    *ok = false;
+    return IncrementalWindowAgg::kColumn;
+}
+
+static bool ResolveColumn(const node::ExprNode* expr, const SchemasContext* schemas_ctx, size_t* schema_idx,
+                          size_t* col_idx, type::Type* type) {
+    if (expr == nullptr ||
+        (expr->GetExprType() != node::kExprColumnRef && expr->GetExprType() != node::kExprColumnId)) {
+        return false;
+    }
+    size_t column_id = 0;
+    if (!schemas_ctx->ResolveColumnID(expr, &column_id).isOK() ||
+        !schemas_ctx->ResolveColumnIndexByID(column_id, schema_idx, col_idx).isOK()) {
+        return false;
+    }
+    auto schema = schemas_ctx->GetSchemaSource(*schema_idx)->GetSchema();
+    if (schema == nullptr || static_cast<int>(*col_idx) >= schema->size()) {
+        return false;
+    }
+    *type = schema->Get(*col_idx).type();
+    return true;
+}
+
+std::unique_ptr<IncrementalWindowAgg> IncrementalWindowAgg::Build(const ColumnProjects& projects,
+                                                                  const SchemasContext* input_schemas_ctx,
+                                                                  const SchemasContext* output_schemas_ctx) {
+    if (input_schemas_ctx == nullptr || output_schemas_ctx == nullptr) {
+        return nullptr;
+    }
+    const codec::Schema* output_schema = output_schemas_ctx->GetOutputSchema();
+    if (output_schema == nullptr || static_cast<size_t>(output_schema->size()) != projects.size()) {
+        return nullptr;
+    }
+    const node::FrameNode* primary_frame = projects.GetPrimaryFrame();
+    std::vector<Project> project_vec;
+    bool has_aggregate = false;
+    for (size_t i = 0; i < projects.size(); i++) {
+        const node::ExprNode* expr = projects.GetExpr(i);
+        const node::FrameNode* frame = projects.GetFrame(i);
+        if (expr == nullptr) {
+            return nullptr;
+        }
+        if (frame != nullptr && primary_frame != nullptr && !frame->Equals(primary_frame)) {
+            return nullptr;
+        }
+        Project project;
+        project.output_type = output_schema->Get(i).type();
+        const node::ExprNode* column = expr;
+        if (expr->GetExprType() == node::kExprCall) {
+            auto call = dynamic_cast<const node::CallExprNode*>(expr);
+            if (call == nullptr || call->GetFnDef() == nullptr || call->GetChildNum() != 1) {
+                return nullptr;
+            }
+            bool ok = false;
+            project.kind = GetAggregateKind(call->GetFnDef()->GetName(), &ok);
+            if (!ok) {
+                return nullptr;
+            }
+            column = call->GetChild(0);
+            has_aggregate = true;
+        } else {
+            project.kind = kColumn;
+        }
+        if (!ResolveColumn(column, input_schemas_ctx, &project.schema_idx, &project.col_idx, &project.input_type)) {
+            return nullptr;
+        }
+        if (project.kind == kColumn) {
+            if (project.input_type != project.output_type) {
+                return nullptr;
+            }
+        } else if (!CheckAggregate(project.kind, project.input_type, project.output_type)) {
+            return nullptr;
+        }
+        project_vec.push_back(project);
+    }
+    if (!has_aggregate) {
+        return nullptr;
+    }
+    return std::unique_ptr<IncrementalWindowAgg>(
+        new IncrementalWindowAgg(input_schemas_ctx, *output_schema, std::move(project_vec)));
+}
+
+IncrementalWindowAgg::IncrementalWindowAgg(const SchemasContext* input_schemas_ctx,
+                                           const codec::Schema& output_schema, std::vector<Project>&& projects)
+    : input_views_(), output_schema_(output_schema), projects_(std::move(projects)) {
+    for (size_t i = 0; i < input_schemas_ctx->GetSchemaSourceSize(); i++) {
+        input_views_.emplace_back(*input_schemas_ctx->GetSchemaSource(i)->GetSchema());
+    }
+}
+
+IncrementalWindowAggState::IncrementalWindowAggState(const IncrementalWindowAgg* agg)
+    : agg_(agg), states_(agg->projects_.size()), head_seq_(0), tail_seq_(0), count_(0) {}
+
+IncrementalWindowAggState::Value IncrementalWindowAggState::GetValue(
+    const codec::Row& row, const IncrementalWindowAgg::Project& project) const {
+    Value value;
+    const int8_t* buf = GetSliceBuf(row, project.schema_idx);
+    if (buf == nullptr) {
+        return value;
+    }
+    const codec::RowView& view = agg_->input_views_[project.schema_idx];
+    if (view.IsNULL(buf, project.col_idx)) {
+        return value;
+    }
+    int32_t ret = 0;
+    switch (project.input_type) {
+        case type::kInt16: {
+            int16_t v = 0;
+            ret = view.GetValue(buf, project.col_idx, project.input_type, &v);
+            value.i = v;
+            break;
+        }
+        case type::kInt32:
+        case type::kDate: {
+            int32_t v = 0;
+            ret = view.GetValue(buf, project.col_idx, project.input_type, &v);
+            value.i = v;
+            break;
+        }
+        case type::kInt64:
+        case type::kTimestamp: {
+            ret = view.GetValue(buf, project.col_idx, project.input_type, &value.i);
+            break;
+        }
+        case type::kFloat: {
+            float v = 0;
+            ret = view.GetValue(buf, project.col_idx, project.input_type, &v);
+            value.d = v;
+            break;
+        }
+        case type::kDouble: {
+            ret = view.GetValue(buf, project.col_idx, project.input_type, &value.d);
+            break;
+        }
+        default:
+            // count only needs to know the value is not null
+            break;
+    }
+    value.is_null = ret != 0;
+    return value;
+}
+
+// return true if lhs is the better candidate than rhs, and the equal older one is replaced
+// by the newer one, as the compiled function visits the newer rows first
+static bool IsBetter(IncrementalWindowAgg::ProjectKind kind, bool is_float, double lhs_d, int64_t lhs_i,
+                     double rhs_d, int64_t rhs_i) {
+    if (is_float) {
+        return kind == IncrementalWindowAgg::kMin ? lhs_d <= rhs_d : lhs_d >= rhs_d;
+    }
+    return kind == IncrementalWindowAgg::kMin ? lhs_i <= rhs_i : lhs_i >= rhs_i;
+}
+
+void IncrementalWindowAggState::Add(const codec::Row& row) {
+    const auto& projects = agg_->projects_;
+    for (size_t i = 0; i < projects.size(); i++) {
+        const auto& project = projects[i];
+        if (project.kind == IncrementalWindowAgg::kColumn) {
+            continue;
+        }
+        State& state = states_[i];
+        Value value = GetValue(row, project);
+        state.values.push_back(value);
+        if (value.is_null) {
+            continue;
+        }
+        state.not_null_cnt++;
+        switch (project.kind) {
+            case IncrementalWindowAgg::kSum:
+            case IncrementalWindowAgg::kAvg:
+                // wrap around like the compiled sum of the output type
+                state.sum = static_cast<int64_t>(static_cast<uint64_t>(state.sum) + static_cast<uint64_t>(value.i));
+                break;
+            case IncrementalWindowAgg::kMin:
+            case IncrementalWindowAgg::kMax: {
+                bool is_float = IsFloatType(project.input_type);
+                // nan is never picked by the compiled min and max
+                if (is_float && value.d != value.d) {
+                    break;
+                }
+                while (!state.candidates.empty() &&
+                       IsBetter(project.kind, is_float, value.d, value.i, state.candidates.back().second.d,
+                                state.candidates.back().second.i)) {
+                    state.candidates.pop_back();
+                }
+                state.candidates.emplace_back(tail_seq_, value);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    tail_seq_++;
+    count_++;
+}
+
+void IncrementalWindowAggState::Evict() {
+    if (count_ == 0) {
+        return;
+    }
+    const auto& projects = agg_->projects_;
+    for (size_t i = 0; i < projects.size(); i++) {
+        const auto& project = projects[i];
+        if (project.kind == IncrementalWindowAgg::kColumn) {
+            continue;
+        }
+        State& state = states_[i];
+        Value value = state.values.front();
+        state.values.pop_front();
+        if (!state.candidates.empty() && state.candidates.front().first == head_seq_) {
+            state.candidates.pop_front();
+        }
+        if (value.is_null) {
+            continue;
+        }
+        state.not_null_cnt--;
+        if (project.kind == IncrementalWindowAgg::kSum || project.kind == IncrementalWindowAgg::kAvg) {
+            state.sum = static_cast<int64_t>(static_cast<uint64_t>(state.sum) - static_cast<uint64_t>(value.i));
+        }
+    }
+    head_seq_++;
+    count_--;
+}
+
+codec::Row IncrementalWindowAggState::Output(const codec::Row& row) const {
+    const auto& projects = agg_->projects_;
+    uint32_t str_len = 0;
+    for (const auto& project : projects) {
+        if (project.kind == IncrementalWindowAgg::kColumn && project.input_type == type::kVarchar) {
+            const int8_t* buf = GetSliceBuf(row, project.schema_idx);
+            const char* str = nullptr;
+            uint32_t len = 0;
+            if (buf != nullptr &&
+                agg_->input_views_[project.schema_idx].GetValue(buf, project.col_idx, &str, &len) == 0) {
+                str_len += len;
+            }
+        }
+    }
+    codec::RowBuilder builder(agg_->output_schema_);
+    uint32_t total_len = builder.CalTotalLength(str_len);
+    int8_t* out = static_cast<int8_t*>(malloc(total_len));
+    builder.SetBuffer(out, total_len);
+    for (size_t i = 0; i < projects.size(); i++) {
+        const auto& project = projects[i];
+        const State& state = states_[i];
+        switch (project.kind) {
+            case IncrementalWindowAgg::kColumn: {
+                const int8_t* buf = GetSliceBuf(row, project.schema_idx);
+                const auto& view = agg_->input_views_[project.schema_idx];
+                if (buf == nullptr || view.IsNULL(buf, project.col_idx)) {
+                    builder.AppendNULL();
+                    break;
+                }
+                switch (project.input_type) {
+                    case type::kBool: {
+                        bool v = false;
+                        view.GetValue(buf, project.col_idx, project.input_type, &v);
+                        builder.AppendBool(v);
+                        break;
+                    }
+                    case type::kVarchar: {
+                        const char* str = nullptr;
+                        uint32_t len = 0;
+                        view.GetValue(buf, project.col_idx, &str, &len);
+                        builder.AppendString(str, len);
+                        break;
+                    }
+                    default: {
+                        Value value = GetValue(row, project);
+                        switch (project.output_type) {
+                            case type::kInt16:
+                                builder.AppendInt16(static_cast<int16_t>(value.i));
+                                break;
+                            case type::kInt32:
+                                builder.AppendInt32(static_cast<int32_t>(value.i));
+                                break;
+                            case type::kDate:
+                                builder.AppendDate(static_cast<int32_t>(value.i));
+                                break;
+                            case type::kInt64:
+                                builder.AppendInt64(value.i);
+                                break;
+                            case type::kTimestamp:
+                                builder.AppendTimestamp(value.i);
+                                break;
+                            case type::kFloat:
+                                builder.AppendFloat(static_cast<float>(value.d));
+                                break;
+                            case type::kDouble:
+                                builder.AppendDouble(value.d);
+                                break;
+                            default:
+                                builder.AppendNULL();
+                                break;
+                        }
+                    }
+                }
+                break;
+            }
+            case IncrementalWindowAgg::kCount:
+                builder.AppendInt64(state.not_null_cnt);
+                break;
+            case IncrementalWindowAgg::kAvg:
+                if (state.not_null_cnt == 0) {
+                    builder.AppendNULL();
+                } else {
+                    builder.AppendDouble(static_cast<double>(state.sum) / state.not_null_cnt);
+                }
+                break;
+            case IncrementalWindowAgg::kSum:
+                if (state.not_null_cnt == 0) {
+                    builder.AppendNULL();
+                } else if (project.output_type == type::kInt16) {
+                    builder.AppendInt16(static_cast<int16_t>(state.sum));
+                } else if (project.output_type == type::kInt32) {
+                    builder.AppendInt32(static_cast<int32_t>(state.sum));
+                } else if (project.output_type == type::kTimestamp) {
+                    builder.AppendTimestamp(state.sum);
+                } else {
+                    builder.AppendInt64(state.sum);
+                }
+                break;
+            case IncrementalWindowAgg::kMin:
+            case IncrementalWindowAgg::kMax: {
+                if (state.not_null_cnt == 0) {
+                    builder.AppendNULL();
+                    break;
+                }
+                bool is_min = project.kind == IncrementalWindowAgg::kMin;
+                const Value* best = state.candidates.empty() ? nullptr : &state.candidates.front().second;
+                // the compiled functions start from the initial value below
+                switch (project.output_type) {
+                    case type::kInt16: {
+                        int64_t init = is_min ? std::numeric_limits<int16_t>::max()
+                                              : std::numeric_limits<int16_t>::lowest();
+                        int64_t v = best == nullptr ? init : (is_min ? std::min(init, best->i) : std::max(init, best->i));
+                        builder.AppendInt16(static_cast<int16_t>(v));
+                        break;
+                    }
+                    case type::kInt32:
+                    case type::kDate: {
+                        int64_t init = is_min ? std::numeric_limits<int32_t>::max()
+                                              : (project.output_type == type::kDate
+                                                     ? 0
+                                                     : std::numeric_limits<int32_t>::lowest());
+                        int64_t v = best == nullptr ? init : (is_min ? std::min(init, best->i) : std::max(init, best->i));
+                        project.output_type == type::kDate ? builder.AppendDate(static_cast<int32_t>(v))
+                                                           : builder.AppendInt32(static_cast<int32_t>(v));
+                        break;
+                    }
+                    case type::kInt64:
+                    case type::kTimestamp: {
+                        int64_t init = is_min ? std::numeric_limits<int64_t>::max()
+                                              : (project.output_type == type::kTimestamp
+                                                     ? 0
+                                                     : std::numeric_limits<int64_t>::lowest());
+                        int64_t v = best == nullptr ? init : (is_min ? std::min(init, best->i) : std::max(init, best->i));
+                        project.output_type == type::kTimestamp ? builder.AppendTimestamp(v) : builder.AppendInt64(v);
+                        break;
+                    }
+                    case type::kFloat: {
+                        double init = is_min ? std::numeric_limits<float>::max() : std::numeric_limits<float>::lowest();
+                        double v = best == nullptr ? init : (is_min ? std::min(init, best->d) : std::max(init, best->d));
+                        builder.AppendFloat(static_cast<float>(v));
+                        break;
+                    }
+                    case type::kDouble: {
+                        double init =
+                            is_min ? std::numeric_limits<double>::max() : std::numeric_limits<double>::lowest();
+                        double v = best == nullptr ? init : (is_min ? std::min(init, best->d) : std::max(init, best->d));
+                        builder.AppendDouble(v);
+                        break;
+                    }
+                    default:
+                        builder.AppendNULL();
+                        break;
+                }
+                break;
+            }
+        }
+    }
+    return codec::Row(base::RefCountedSlice::CreateManaged(out, total_len));
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_INCREMENTAL_WINDOW_AGG_H_
+#define HYBRIDSE_SRC_VM_INCREMENTAL_WINDOW_AGG_H_
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "codec/row.h"
+#include "vm/physical_op.h"
+#include "vm/schemas_context.h"
+
+namespace hybridse {
+namespace vm {
+
+/**
+ * Compute the window projects of a batch window aggregation without the
+ * compiled function, by keeping aggregate states that slide with the window.
+ *
+ * sum and count add the incoming rows and subtract the evicted rows, min and max
+ * keep a monotonic deque. Only the projects made of column references and
+ * `sum/count/avg/min/max` over a column can be computed this way. The results are
+ * the same as the compiled udafs, so sum and avg over float types, whose results
+ * depend on the adding order, are left to the compiled function.
+ */
+class IncrementalWindowAgg {
+ public:
+    enum ProjectKind {
+        kColumn,
+        kSum,
+        kCount,
+        kAvg,
+        kMin,
+        kMax,
+    };
+
+    struct Project {
+        ProjectKind kind;
+        size_t schema_idx;
+        size_t col_idx;
+        type::Type input_type;
+        type::Type output_type;
+    };
+
+    /**
+     * Return nullptr if any of the projects can not be computed incrementally.
+     */
+    static std::unique_ptr<IncrementalWindowAgg> Build(const ColumnProjects& projects,
+                                                       const SchemasContext* input_schemas_ctx,
+                                                       const SchemasContext* output_schemas_ctx);
+
+    const std::vector<Project>& projects() const { return projects_; }
+
+ private:
+    friend class IncrementalWindowAggState;
+
+    IncrementalWindowAgg(const SchemasContext* input_schemas_ctx, const codec::Schema& output_schema,
+                         std::vector<Project>&& projects);
+
+    std::vector<codec::RowView> input_views_;
+    codec::Schema output_schema_;
+    std::vector<Project> projects_;
+};
+
+/**
+ * The aggregate states of one partition key. Rows enter the window at the newest end,
+ * and leave it from the oldest end.
+ */
+class IncrementalWindowAggState {
+ public:
+    explicit IncrementalWindowAggState(const IncrementalWindowAgg* agg);
+
+    // add the newest row of the window
+    void Add(const codec::Row& row);
+
+    // evict the oldest row of the window
+    void Evict();
+
+    // output the projects of the current row with the states of the window
+    codec::Row Output(const codec::Row& row) const;
+
+    size_t GetCount() const { return count_; }
+
+ private:
+    struct Value {
+        bool is_null = true;
+        int64_t i = 0;
+        double d = 0;
+    };
+
+    struct State {
+        int64_t sum = 0;
+        int64_t not_null_cnt = 0;
+        // the values of the window from the oldest one to be subtracted on eviction
+        std::deque<Value> values;
+        // the candidates of min or max with their sequences, the values are monotonic
+        // from the oldest one, so the front is the result
+        std::deque<std::pair<uint64_t, Value>> candidates;
+    };
+
+    Value GetValue(const codec::Row& row, const IncrementalWindowAgg::Project& project) const;
+
+    const IncrementalWindowAgg* agg_;
+    std::vector<State> states_;
+    // the sequence of the oldest row in window and the next row
+    uint64_t head_seq_;
+    uint64_t tail_seq_;
+    size_t count_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_INCREMENTAL_WINDOW_AGG_H_
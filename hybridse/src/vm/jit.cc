@@ -40,6 +40,7 @@ extern "C" {
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
+#include "vm/jit_object_cache.h"
 #ifdef LLVM_EXT_ENABLE
 #include "llvm_ext/symbol_resolve.h"
 #endif
@@ -150,8 +151,21 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
 
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    if (!jit_options_.GetObjectCacheDir().empty()) {
+        auto cache = JitObjectCache::GetOrCreate(jit_options_.GetObjectCacheDir(),
+                                                 jit_options_.GetObjectCacheMaxSize());
+        if (cache != nullptr) {
+            // load the compiled objects from cache, or compile and store them
+            builder.setCompileFunctionCreator(
+                [cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                    -> ::llvm::Expected<::llvm::orc::IRCompileLayer::CompileFunction> {
+                    return ::llvm::orc::IRCompileLayer::CompileFunction(
+                        ::llvm::orc::ConcurrentIRCompiler(std::move(jtmb), cache));
+                });
+        }
+    }
+    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
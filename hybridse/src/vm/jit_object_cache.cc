@@ -0,0 +1,248 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/jit_object_cache.h"
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "glog/logging.h"
+#include "hybridse_version.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace hybridse {
+namespace vm {
+
+#define HYBRIDSE_STR_(x) #x
+#define HYBRIDSE_STR(x) HYBRIDSE_STR_(x)
+
+// bump the suffix when the generated code or the runtime functions it calls
+// change within a release, so the objects compiled by the old code are not loaded
+static const char CODEGEN_VERSION[] = HYBRIDSE_STR(HYBRIDSE_VERSION_MAJOR) "." HYBRIDSE_STR(
+    HYBRIDSE_VERSION_MINOR) "." HYBRIDSE_STR(HYBRIDSE_VERSION_BUG) "-1";
+
+static const char OBJECT_SUFFIX[] = ".o";
+
+// a stream that only feeds the written bytes to the md5
+class MD5Ostream : public ::llvm::raw_ostream {
+ public:
+    explicit MD5Ostream(::llvm::MD5* hash) : hash_(hash), pos_(0) {}
+    ~MD5Ostream() override { flush(); }
+
+ private:
+    void write_impl(const char* ptr, size_t size) override {
+        hash_->update(::llvm::StringRef(ptr, size));
+        pos_ += size;
+    }
+    uint64_t current_pos() const override { return pos_; }
+
+    ::llvm::MD5* hash_;
+    uint64_t pos_;
+};
+
+static std::mutex caches_mu;
+static std::map<std::string, std::unique_ptr<JitObjectCache>> caches;
+
+JitObjectCache::JitObjectCache(const std::string& dir, uint64_t max_size)
+    : dir_(dir), max_size_(max_size), size_(0), hit_cnt_(0), miss_cnt_(0) {}
+
+JitObjectCache* JitObjectCache::GetOrCreate(const std::string& dir,
+                                            uint64_t max_size) {
+    std::lock_guard<std::mutex> lock(caches_mu);
+    auto it = caches.find(dir);
+    if (it != caches.end()) {
+        return it->second.get();
+    }
+    std::error_code ec = ::llvm::sys::fs::create_directories(dir);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object cache dir " << dir << ": "
+                     << ec.message();
+        return nullptr;
+    }
+    auto cache = std::make_unique<JitObjectCache>(dir, max_size);
+    cache->LoadObjects();
+    LOG(INFO) << "jit object cache dir " << dir << ", max size " << max_size
+              << ", size " << cache->GetSize();
+    auto cache_ptr = cache.get();
+    caches.emplace(dir, std::move(cache));
+    return cache_ptr;
+}
+
+JitObjectCache* JitObjectCache::Get(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(caches_mu);
+    auto it = caches.find(dir);
+    return it == caches.end() ? nullptr : it->second.get();
+}
+
+uint64_t JitObjectCache::GetSize() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return size_;
+}
+
+void JitObjectCache::LoadObjects() {
+    // (modification time, key, size)
+    std::vector<std::tuple<::llvm::sys::TimePoint<>, std::string, uint64_t>> files;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator it(dir_, ec), end; it != end && !ec; it.increment(ec)) {
+        ::llvm::StringRef name = ::llvm::sys::path::filename(it->path());
+        if (!name.endswith(OBJECT_SUFFIX)) {
+            continue;
+        }
+        ::llvm::sys::fs::file_status status;
+        if (::llvm::sys::fs::status(it->path(), status) || status.type() != ::llvm::sys::fs::file_type::regular_file) {
+            continue;
+        }
+        files.emplace_back(status.getLastModificationTime(),
+                           name.drop_back(sizeof(OBJECT_SUFFIX) - 1).str(), status.getSize());
+    }
+    if (ec) {
+        LOG(WARNING) << "fail to list jit object cache dir " << dir_ << ": " << ec.message();
+    }
+    std::sort(files.begin(), files.end());
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto& file : files) {
+        Touch(std::get<1>(file), std::get<2>(file));
+    }
+}
+
+void JitObjectCache::Touch(const std::string& key, uint64_t size) {
+    Remove(key);
+    lru_.push_front(key);
+    objects_.emplace(key, std::make_pair(size, lru_.begin()));
+    size_ += size;
+    // keep the object just used even if it is larger than max_size_ alone
+    while (max_size_ > 0 && size_ > max_size_ && lru_.size() > 1) {
+        std::string evicted = lru_.back();
+        Remove(evicted);
+        std::error_code ec = ::llvm::sys::fs::remove(GetPath(evicted));
+        if (ec) {
+            LOG(WARNING) << "fail to remove jit object cache file " << GetPath(evicted) << ": " << ec.message();
+        } else {
+            DLOG(INFO) << "jit object cache evict " << evicted;
+        }
+    }
+}
+
+void JitObjectCache::Remove(const std::string& key) {
+    auto it = objects_.find(key);
+    if (it == objects_.end()) {
+        return;
+    }
+    size_ -= it->second.first;
+    lru_.erase(it->second.second);
+    objects_.erase(it);
+}
+
+std::string JitObjectCache::GetKey(const ::llvm::Module* m) const {
+    ::llvm::MD5 hash;
+    hash.update(LLVM_VERSION_STRING);
+    hash.update(CODEGEN_VERSION);
+    hash.update(::llvm::sys::getHostCPUName());
+    hash.update(m->getTargetTriple());
+    {
+        // the bitcode is much cheaper to write than the ir text
+        MD5Ostream os(&hash);
+        ::llvm::WriteBitcodeToFile(*m, os);
+    }
+    ::llvm::MD5::MD5Result result;
+    hash.final(result);
+    ::llvm::SmallString<32> key;
+    ::llvm::MD5::stringifyResult(result, key);
+    return key.str().str();
+}
+
+std::string JitObjectCache::GetPath(const std::string& key) const {
+    return dir_ + "/" + key + OBJECT_SUFFIX;
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(
+    const ::llvm::Module* m) {
+    std::string key = GetKey(m);
+    auto buf = ::llvm::MemoryBuffer::getFile(GetPath(key));
+    if (buf) {
+        hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+        DLOG(INFO) << "jit object cache hit " << key;
+        std::lock_guard<std::mutex> lock(mu_);
+        Touch(key, buf.get()->getBufferSize());
+        return std::move(buf.get());
+    }
+    miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+    DLOG(INFO) << "jit object cache miss " << key;
+    std::lock_guard<std::mutex> lock(mu_);
+    // removed by another process sharing the dir
+    Remove(key);
+    compiling_[m] = key;
+    return nullptr;
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* m,
+                                          ::llvm::MemoryBufferRef obj) {
+    std::string key;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = compiling_.find(m);
+        if (it != compiling_.end()) {
+            key = std::move(it->second);
+            compiling_.erase(it);
+        }
+    }
+    if (key.empty()) {
+        key = GetKey(m);
+    }
+    // write to a temp file and rename, so the readers never see a partial
+    // object even if several processes share the dir
+    std::string path = GetPath(key);
+    int fd = -1;
+    ::llvm::SmallString<128> tmp_path;
+    std::error_code ec = ::llvm::sys::fs::createUniqueFile(
+        path + ".tmp-%%%%%%", fd, tmp_path);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object cache file for " << path
+                     << ": " << ec.message();
+        return;
+    }
+    {
+        ::llvm::raw_fd_ostream os(fd, true);
+        os << obj.getBuffer();
+        os.close();
+        if (os.has_error()) {
+            LOG(WARNING) << "fail to write jit object cache file "
+                         << tmp_path.str().str();
+            os.clear_error();
+            ::llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    ec = ::llvm::sys::fs::rename(tmp_path, path);
+    if (ec) {
+        LOG(WARNING) << "fail to rename jit object cache file to " << path
+                     << ": " << ec.message();
+        ::llvm::sys::fs::remove(tmp_path);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    Touch(key, obj.getBufferSize());
+}
+
+}  // namespace vm
+}  // namespace hybridse
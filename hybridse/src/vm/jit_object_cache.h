@@ -0,0 +1,104 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+#define HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace hybridse {
+namespace vm {
+
+/// On-disk cache of the native objects compiled from the codegen modules.
+///
+/// The key is the md5 of the llvm and codegen versions, the host cpu and the
+/// module bitcode. The module is generated from the sql, the db, the schemas
+/// of the catalog and the engine options, so a schema change produces a new
+/// key and the stale objects are never loaded again.
+///
+/// The objects beyond `max_size` bytes are removed in the least recently used
+/// order. The order of the objects found in the directory at start is their
+/// modification time.
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    JitObjectCache(const std::string& dir, uint64_t max_size);
+    ~JitObjectCache() override {}
+
+    /// Return the cache of the directory, which is shared by all the jit
+    /// instances of the process. Return nullptr if the directory can not be
+    /// created. `max_size` is only used by the first call of the directory,
+    /// 0 for no limit.
+    static JitObjectCache* GetOrCreate(const std::string& dir,
+                                       uint64_t max_size = 0);
+
+    /// Return the cache of the directory if it has been created, or nullptr
+    static JitObjectCache* Get(const std::string& dir);
+
+    void notifyObjectCompiled(const ::llvm::Module* m,
+                              ::llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(
+        const ::llvm::Module* m) override;
+
+    const std::string& dir() const { return dir_; }
+
+    uint64_t GetHitCount() const {
+        return hit_cnt_.load(std::memory_order_relaxed);
+    }
+    uint64_t GetMissCount() const {
+        return miss_cnt_.load(std::memory_order_relaxed);
+    }
+    /// The bytes of the objects in the directory
+    uint64_t GetSize();
+
+ private:
+    std::string GetKey(const ::llvm::Module* m) const;
+    std::string GetPath(const std::string& key) const;
+    // index the objects already in the directory
+    void LoadObjects();
+    // mark the object of the key as the most recently used, and remove the
+    // least recently used ones beyond max_size_. must hold mu_
+    void Touch(const std::string& key, uint64_t size);
+    // must hold mu_
+    void Remove(const std::string& key);
+
+    std::string dir_;
+    const uint64_t max_size_;
+    std::mutex mu_;
+    // the keys of the modules missed in getObject and being compiled
+    std::map<const ::llvm::Module*, std::string> compiling_;
+    // the keys of the objects, the most recently used first
+    std::list<std::string> lru_;
+    // key -> the object size and the position in lru_
+    std::unordered_map<std::string, std::pair<uint64_t, std::list<std::string>::iterator>> objects_;
+    uint64_t size_;
+    std::atomic<uint64_t> hit_cnt_;
+    std::atomic<uint64_t> miss_cnt_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
@@ -15,10 +15,16 @@
  */
 
 #include "vm/jit_wrapper.h"
+#include <unistd.h>
+#include <string>
+#include <utility>
+#include <vector>
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
+#include "llvm/Support/FileSystem.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
+#include "vm/jit_object_cache.h"
 #include "vm/simple_catalog.h"
 #include "vm/sql_compiler.h"
 
@@ -162,6 +168,85 @@ TEST_F(JitWrapperTest, test_window) {
     delete jit;
 }
 
+TEST_F(JitWrapperTest, test_object_cache) {
+    EngineOptions options;
+    options.SetKeepIr(true);
+    auto catalog = GetTestCatalog();
+    auto compile_info = Compile("select col_1, col_2 from t1;", options, catalog);
+    auto &sql_context = compile_info->get_sql_context();
+    std::string ir_str = sql_context.ir;
+    ASSERT_FALSE(ir_str.empty());
+    auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+
+    std::string dir = "/tmp/hybridse_jit_object_cache_" + std::to_string(getpid());
+    JitOptions jit_options;
+    jit_options.SetObjectCacheDir(dir);
+    auto cache = JitObjectCache::GetOrCreate(dir);
+    ASSERT_TRUE(cache != nullptr);
+    for (int i = 0; i < 2; i++) {
+        HybridSeJitWrapper *jit = HybridSeJitWrapper::Create(jit_options);
+        ASSERT_TRUE(jit->Init());
+        HybridSeJitWrapper::InitJitSymbols(jit);
+        base::RawBuffer ir_buf(const_cast<char *>(ir_str.data()), ir_str.size());
+        ASSERT_TRUE(jit->AddModuleFromBuffer(ir_buf));
+        ASSERT_TRUE(jit->FindFunction(fn_name) != nullptr);
+        delete jit;
+    }
+    // the second jit loads the object compiled by the first one
+    ASSERT_EQ(1u, cache->GetMissCount());
+    ASSERT_EQ(1u, cache->GetHitCount());
+    ::llvm::sys::fs::remove_directories(dir);
+}
+
+TEST_F(JitWrapperTest, test_object_cache_evict) {
+    EngineOptions options;
+    options.SetKeepIr(true);
+    auto catalog = GetTestCatalog();
+    std::vector<std::pair<std::string, std::string>> modules;
+    for (auto sql : {"select col_1 from t1;", "select col_2 + 1 from t1;"}) {
+        auto compile_info = Compile(sql, options, catalog);
+        ASSERT_TRUE(compile_info != nullptr);
+        auto &sql_context = compile_info->get_sql_context();
+        modules.emplace_back(sql_context.ir, sql_context.physical_plan->GetFnInfos()[0]->fn_name());
+    }
+
+    std::string dir = "/tmp/hybridse_jit_object_cache_evict_" + std::to_string(getpid());
+    JitOptions jit_options;
+    jit_options.SetObjectCacheDir(dir);
+    // only the most recent object is kept
+    jit_options.SetObjectCacheMaxSize(1);
+    auto add_module = [&](const std::pair<std::string, std::string> &module) {
+        HybridSeJitWrapper *jit = HybridSeJitWrapper::Create(jit_options);
+        ASSERT_TRUE(jit->Init());
+        HybridSeJitWrapper::InitJitSymbols(jit);
+        base::RawBuffer ir_buf(const_cast<char *>(module.first.data()), module.first.size());
+        ASSERT_TRUE(jit->AddModuleFromBuffer(ir_buf));
+        ASSERT_TRUE(jit->FindFunction(module.second) != nullptr);
+        delete jit;
+    };
+    add_module(modules[0]);
+    add_module(modules[0]);
+    // evicts the first object
+    add_module(modules[1]);
+    add_module(modules[0]);
+
+    uint64_t hit_cnt = 0;
+    uint64_t miss_cnt = 0;
+    uint64_t size = 0;
+    ASSERT_TRUE(Engine::GetJitObjectCacheStats(dir, &hit_cnt, &miss_cnt, &size));
+    ASSERT_EQ(1u, hit_cnt);
+    ASSERT_EQ(3u, miss_cnt);
+    ASSERT_LT(0u, size);
+    uint32_t file_cnt = 0;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator it(dir, ec), end; it != end && !ec; it.increment(ec)) {
+        file_cnt++;
+    }
+    ASSERT_EQ(1u, file_cnt);
+    ASSERT_FALSE(Engine::GetJitObjectCacheStats(dir + "_none", &hit_cnt, &miss_cnt, &size));
+    ::llvm::sys::fs::remove_directories(dir);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
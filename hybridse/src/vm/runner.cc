@@ -16,8 +16,10 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -248,6 +250,16 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                                                   op->project().fn_info(), op->instance_not_in_window(),
                                                   op->exclude_current_time(), op->exclude_current_row(),
                                                   op->need_append_input());
+                    runner->SetParallelism(window_agg_parallelism_);
+                    if (enable_window_incremental_agg_ && op->window_unions_.Empty() &&
+                        op->window_joins_.Empty() && runner->IsSlidingWindow()) {
+                        std::shared_ptr<IncrementalWindowAgg> incremental_agg =
+                            IncrementalWindowAgg::Build(op->project(), node->producers().at(0)->schemas_ctx(),
+                                                        node->schemas_ctx());
+                        if (incremental_agg) {
+                            runner->SetIncrementalAgg(incremental_agg);
+                        }
+                    }
                     size_t input_slices =
                         input->output_schemas()->GetSchemaSourceSize();
                     if (!op->window_unions_.Empty()) {
@@ -884,6 +896,56 @@ ClusterTask RunnerBuilder::BuildProxyRunnerForClusterTask(
     LOG(WARNING) << "Fail to build proxy runner for cluster job";
     return ClusterTask();
 }
+
+// return true if the output of the runner depends on any remote subquery,
+// the proxy runners depending on local inputs only are collected
+static bool CollectPrefetchRunners(Runner* runner,
+                                   std::unordered_map<Runner*, bool>* visited,
+                                   std::vector<Runner*>* prefetch_runners) {
+    auto iter = visited->find(runner);
+    if (iter != visited->cend()) {
+        return iter->second;
+    }
+    std::vector<Runner*> inputs;
+    runner->GetInputs(&inputs);
+    bool depend_remote = false;
+    for (auto input : inputs) {
+        if (nullptr != input &&
+            CollectPrefetchRunners(input, visited, prefetch_runners)) {
+            depend_remote = true;
+        }
+    }
+    if (kRunnerRequestRunProxy == runner->type_) {
+        if (!depend_remote) {
+            prefetch_runners->push_back(runner);
+        }
+        depend_remote = true;
+    }
+    visited->insert(std::make_pair(runner, depend_remote));
+    return depend_remote;
+}
+
+void ClusterJob::BuildPrefetchRunners() {
+    prefetch_runners_.clear();
+    for (size_t id = 0; id < tasks_.size(); id++) {
+        auto root = tasks_[id].GetRoot();
+        if (nullptr == root) {
+            continue;
+        }
+        std::unordered_map<Runner*, bool> visited;
+        std::vector<Runner*> prefetch_runners;
+        CollectPrefetchRunners(root, &visited, &prefetch_runners);
+        // nothing to overlap with a single subquery
+        if (prefetch_runners.size() < 2) {
+            continue;
+        }
+        for (auto runner : prefetch_runners) {
+            // the prefetched output is picked up from the context cache
+            runner->EnableCache();
+        }
+        prefetch_runners_[id] = prefetch_runners;
+    }
+}
 ClusterTask RunnerBuilder::UnCompletedClusterTask(
     Runner* runner, const std::shared_ptr<TableHandler> table_handler,
     std::string index) {
@@ -1448,15 +1510,77 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
 
     // Compute output
     std::shared_ptr<MemTableHandler> output_table = std::make_shared<MemTableHandler>();
+    if (parallelism_ <= 1) {
+        while (instance_partition_iter->Valid()) {
+            if (limit_cnt_.has_value() && output_table->GetCount() >= static_cast<uint64_t>(limit_cnt_.value())) {
+                break;
+            }
+            auto key = instance_partition_iter->GetKey().ToString();
+            RunWindowAggOnKey(parameter, instance_partition, union_partitions,
+                              join_right_tables, key, output_table);
+            instance_partition_iter->Next();
+        }
+        return output_table;
+    }
+
+    std::vector<std::string> keys;
     while (instance_partition_iter->Valid()) {
-        auto key = instance_partition_iter->GetKey().ToString();
-        RunWindowAggOnKey(parameter, instance_partition, union_partitions,
-                          join_right_tables, key, output_table);
+        keys.push_back(instance_partition_iter->GetKey().ToString());
         instance_partition_iter->Next();
     }
+    // every shard takes a contiguous range of keys, so the outputs concatenated
+    // in the shard order are the same as the serial output
+    size_t shard_cnt = std::min(static_cast<size_t>(parallelism_),
+                                keys.size() / std::max(min_keys_per_thread_, 1u));
+    auto run_shard = [&](size_t begin, size_t end, std::shared_ptr<MemTableHandler> table) {
+        for (size_t pos = begin; pos < end; pos++) {
+            if (limit_cnt_.has_value() && table->GetCount() >= static_cast<uint64_t>(limit_cnt_.value())) {
+                break;
+            }
+            RunWindowAggOnKey(parameter, instance_partition, union_partitions,
+                              join_right_tables, keys[pos], table);
+        }
+    };
+    if (shard_cnt <= 1) {
+        run_shard(0, keys.size(), output_table);
+        return output_table;
+    }
+    // the first shard runs on the calling thread
+    std::vector<std::shared_ptr<MemTableHandler>> shard_tables(shard_cnt);
+    std::vector<std::thread> threads;
+    threads.reserve(shard_cnt - 1);
+    for (size_t shard = 0; shard < shard_cnt; shard++) {
+        shard_tables[shard] = std::make_shared<MemTableHandler>();
+        size_t begin = keys.size() * shard / shard_cnt;
+        size_t end = keys.size() * (shard + 1) / shard_cnt;
+        if (shard > 0) {
+            threads.emplace_back(run_shard, begin, end, shard_tables[shard]);
+        }
+    }
+    run_shard(0, keys.size() / shard_cnt, shard_tables[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& shard_table : shard_tables) {
+        auto iter = shard_table->GetIterator();
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            if (limit_cnt_.has_value() &&
+                output_table->GetCount() >= static_cast<uint64_t>(limit_cnt_.value())) {
+                return output_table;
+            }
+            output_table->AddRow(iter->GetValue());
+        }
+    }
     return output_table;
 }
 
+bool WindowAggRunner::IsSlidingWindow() const {
+    const auto& range = instance_window_gen_.range_gen_.window_range_;
+    return windows_union_gen_.inputs_cnt_ == 0 && !windows_join_gen_.Valid() && !need_append_input_ &&
+           !instance_not_in_window_ && !exclude_current_time_ && !exclude_current_row_ &&
+           0 == range.end_offset_ && 0 == range.end_row_;
+}
+
 // Run Window Aggeregation on given key
 void WindowAggRunner::RunWindowAggOnKey(
     const Row& parameter,
@@ -1516,6 +1640,10 @@ void WindowAggRunner::RunWindowAggOnKey(
     window.set_instance_not_in_window(instance_not_in_window_);
     window.set_exclude_current_time(exclude_current_time_);
     window.set_exclude_current_row(exclude_current_row_);
+    std::unique_ptr<IncrementalWindowAggState> incremental_state;
+    if (incremental_agg_) {
+        incremental_state = std::make_unique<IncrementalWindowAggState>(incremental_agg_.get());
+    }
 
     while (instance_segment_iter->Valid()) {
         if (limit_cnt_.has_value() && cnt >= limit_cnt_) {
@@ -1547,7 +1675,20 @@ void WindowAggRunner::RunWindowAggOnKey(
             min_union_pos = IteratorStatus::FindLastIteratorWithMininumKey(union_segment_status);
         }
 
-        if (windows_join_gen_.Valid()) {
+        if (incremental_state) {
+            // the window evicts its oldest rows only, so the states follow with the count
+            size_t window_cnt = window.GetCount();
+            if (!window.BufferData(instance_order, instance_row)) {
+                LOG(WARNING) << "fail to buffer data";
+                output_table->AddRow(Row());
+            } else {
+                incremental_state->Add(instance_row);
+                for (size_t i = window.GetCount(); i < window_cnt + 1; i++) {
+                    incremental_state->Evict();
+                }
+                output_table->AddRow(incremental_state->Output(instance_row));
+            }
+        } else if (windows_join_gen_.Valid()) {
             Row row = windows_join_gen_.Join(instance_row, join_right_tables, parameter);
             output_table->AddRow(
                 window_project_gen_.Gen(instance_order, row, parameter, true, append_slices_, &window));
@@ -2706,6 +2847,9 @@ std::unique_ptr<BaseAggregator> RequestAggUnionRunner::CreateAggregator() const
         case kMax:
         case kMaxWhere:
             return MakeSameTypeAggregator<MaxAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+        case kDistinctCount:
+            return MakeSameTypeAggregator<DistinctCountAggregator>(agg_col_type_,
+                                                                   *output_schemas_->GetOutputSchema());
         default:
             LOG(ERROR) << "RequestAggUnionRunner does not support for op " << func_->GetName();
             return nullptr;
@@ -2822,9 +2966,22 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     int64_t request_key = ts_gen > 0 ? ts_gen : 0;
 
     auto aggregator = CreateAggregator();
-    auto update_base_aggregator = [aggregator = aggregator.get(), row_parser = base_row_parser, this](const Row& row) {
+    // the values of base rows are unpacked into the batch updater and reduced in batch
+    AggregatorBatchUpdater batch_updater(aggregator.get());
+    size_t agg_col_schema_idx = 0;
+    size_t agg_col_idx = 0;
+    if (!agg_col_name_.empty()) {
+        auto status = base_row_parser->ResolveColumn(agg_col_name_, &agg_col_schema_idx, &agg_col_idx);
+        if (!status.isOK()) {
+            LOG(ERROR) << status;
+            return nullptr;
+        }
+    }
+    auto update_base_aggregator = [aggregator = aggregator.get(), updater = &batch_updater,
+                                   row_parser = base_row_parser, agg_col_schema_idx, agg_col_idx,
+                                   this](const Row& row) {
         DLOG(INFO) << "[Update Base]\n" << GetPrettyRow(row_parser->schema_ctx(), row);
-        if (!agg_col_name_.empty() && row_parser->IsNull(row, agg_col_name_)) {
+        if (!agg_col_name_.empty() && row_parser->IsNull(row, agg_col_schema_idx, agg_col_idx)) {
             return;
         }
 
@@ -2846,7 +3003,7 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
 
         auto type = aggregator->type();
         if (agg_type_ == kCount || agg_type_ == kCountWhere) {
-            dynamic_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(1);
+            updater->AppendCount();
             return;
         }
 
@@ -2856,34 +3013,34 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         switch (type) {
             case type::Type::kInt16: {
                 int16_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
+                row_parser->GetValue(row, agg_col_schema_idx, agg_col_idx, type, &val);
+                updater->Append(val);
                 break;
             }
             case type::Type::kDate:
             case type::Type::kInt32: {
                 int32_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
+                row_parser->GetValue(row, agg_col_schema_idx, agg_col_idx, type, &val);
+                updater->Append(val);
                 break;
             }
             case type::Type::kTimestamp:
             case type::Type::kInt64: {
                 int64_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
+                row_parser->GetValue(row, agg_col_schema_idx, agg_col_idx, type, &val);
+                updater->Append(val);
                 break;
             }
             case type::Type::kFloat: {
                 float val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
+                row_parser->GetValue(row, agg_col_schema_idx, agg_col_idx, type, &val);
+                updater->Append(val);
                 break;
             }
             case type::Type::kDouble: {
                 double val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
+                row_parser->GetValue(row, agg_col_schema_idx, agg_col_idx, type, &val);
+                updater->Append(val);
                 break;
             }
             case type::Type::kVarchar: {
@@ -2898,7 +3055,8 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         }
     };
 
-    auto update_agg_aggregator = [aggregator = aggregator.get(), row_parser = agg_row_parser, this](const Row& row) {
+    auto update_agg_aggregator = [aggregator = aggregator.get(), row_parser = agg_row_parser,
+                                  base_segment = union_segments[0], &update_base_aggregator, this](const Row& row) {
         DLOG(INFO) << "[Update Agg]\n" << GetPrettyRow(row_parser->schema_ctx(), row);
         if (row_parser->IsNull(row, "agg_val")) {
             return;
@@ -2919,6 +3077,23 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
 
         std::string agg_val;
         row_parser->GetString(row, "agg_val", &agg_val);
+        if (agg_type_ == kDistinctCount && codec::DistinctValues::IsOverflowed(agg_val.data(), agg_val.size())) {
+            // the bucket has too many distinct values to keep, update the base rows of its range instead
+            int64_t ts_start = -1;
+            int64_t ts_end = -1;
+            row_parser->GetValue(row, "ts_start", type::Type::kTimestamp, &ts_start);
+            row_parser->GetValue(row, "ts_end", type::Type::kTimestamp, &ts_end);
+            auto bucket_it = base_segment->GetIterator();
+            if (!bucket_it) {
+                return;
+            }
+            bucket_it->Seek(ts_end);
+            while (bucket_it->Valid() && static_cast<int64_t>(bucket_it->GetKey()) >= ts_start) {
+                update_base_aggregator(bucket_it->GetValue());
+                bucket_it->Next();
+            }
+            return;
+        }
         aggregator->Update(agg_val);
     };
 
@@ -2936,6 +3111,7 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     auto base_it = union_segments[0]->GetIterator();
     if (!base_it) {
         LOG(WARNING) << "Base window is empty.";
+        batch_updater.Flush();
         window_table->AddRow(start, aggregator->Output());
         DLOG(INFO) << "REQUEST AGG UNION cnt = " << window_table->GetCount();
         return window_table;
@@ -3016,6 +3192,8 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
             base_it->Next();
         }
     }
+    // keep the update order of base rows and agg rows
+    batch_updater.Flush();
 
     // 2. iterate over agg table from end_base until start_base (both inclusive)
     int64_t prev_ts_start = INT64_MAX;
@@ -3145,6 +3323,7 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         }
     }
 
+    batch_updater.Flush();
     window_table->AddRow(start, aggregator->Output());
     DLOG(INFO) << "REQUEST AGG UNION cnt = " << window_table->GetCount();
     return window_table;
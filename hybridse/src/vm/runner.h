@@ -34,6 +34,7 @@
 #include "vm/catalog.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
+#include "vm/incremental_window_agg.h"
 #include "vm/mem_catalog.h"
 #include "vm/physical_op.h"
 namespace hybridse {
@@ -454,6 +455,11 @@ class Runner : public node::NodeBase<Runner> {
         return true;
     }
     const std::vector<Runner*>& GetProducers() const { return producers_; }
+    // collect the runners whose outputs are read by this runner, including the
+    // ones held by the union and join generators
+    virtual void GetInputs(std::vector<Runner*>* inputs) const {
+        inputs->insert(inputs->end(), producers_.begin(), producers_.end());
+    }
     virtual void PrintRunnerInfo(std::ostream& output,
                                  const std::string& tab) const {
         output << tab << "[" << id_ << "]" << RunnerTypeName(type_);
@@ -943,6 +949,25 @@ class WindowAggRunner : public Runner {
     void AddWindowUnion(const WindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
+    // run the partition keys on up to `parallelism` threads, the keys are independent.
+    // every thread takes at least `min_keys_per_thread` keys, so that a small input does not pay
+    // for starting the threads
+    void SetParallelism(uint32_t parallelism, uint32_t min_keys_per_thread = kMinKeysPerThread) {
+        parallelism_ = parallelism;
+        min_keys_per_thread_ = min_keys_per_thread;
+    }
+    // compute the projects with the sliding aggregate states instead of the compiled function
+    void SetIncrementalAgg(std::shared_ptr<IncrementalWindowAgg> agg) { incremental_agg_ = agg; }
+    // whether the window of the runner only grows at the newest end and shrinks at the oldest end,
+    // which the incremental aggregation relies on
+    bool IsSlidingWindow() const;
+    void GetInputs(std::vector<Runner*>* inputs) const override {
+        Runner::GetInputs(inputs);
+        inputs->insert(inputs->end(), windows_union_gen_.input_runners_.begin(),
+                       windows_union_gen_.input_runners_.end());
+        inputs->insert(inputs->end(), windows_join_gen_.input_runners_.begin(),
+                       windows_join_gen_.input_runners_.end());
+    }
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
@@ -963,6 +988,10 @@ class WindowAggRunner : public Runner {
     WindowUnionGenerator windows_union_gen_;
     WindowJoinGenerator windows_join_gen_;
     WindowProjectGenerator window_project_gen_;
+    static constexpr uint32_t kMinKeysPerThread = 64;
+    uint32_t parallelism_ = 1;
+    uint32_t min_keys_per_thread_ = kMinKeysPerThread;
+    std::shared_ptr<IncrementalWindowAgg> incremental_agg_;
 };
 
 class RequestUnionRunner : public Runner {
@@ -987,6 +1016,11 @@ class RequestUnionRunner : public Runner {
     void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
+    void GetInputs(std::vector<Runner*>* inputs) const override {
+        Runner::GetInputs(inputs);
+        inputs->insert(inputs->end(), windows_union_gen_.input_runners_.begin(),
+                       windows_union_gen_.input_runners_.end());
+    }
     RequestWindowUnionGenerator windows_union_gen_;
     RangeGenerator range_gen_;
     bool exclude_current_time_;
@@ -1027,6 +1061,11 @@ class RequestAggUnionRunner : public Runner {
     void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
+    void GetInputs(std::vector<Runner*>* inputs) const override {
+        Runner::GetInputs(inputs);
+        inputs->insert(inputs->end(), windows_union_gen_.input_runners_.begin(),
+                       windows_union_gen_.input_runners_.end());
+    }
 
     static std::string PrintEvalValue(const absl::StatusOr<std::optional<bool>>& val);
 
@@ -1042,6 +1081,7 @@ class RequestAggUnionRunner : public Runner {
         kAvgWhere,
         kMinWhere,
         kMaxWhere,
+        kDistinctCount,
     };
 
     RequestWindowUnionGenerator windows_union_gen_;
@@ -1074,7 +1114,8 @@ class RequestAggUnionRunner : public Runner {
         {"sum_where", kSumWhere},
         {"avg_where", kAvgWhere},
         {"min_where", kMinWhere},
-        {"max_where", kMaxWhere}};
+        {"max_where", kMaxWhere},
+        {"distinct_count", kDistinctCount}};
 };
 
 class PostRequestUnionRunner : public Runner {
@@ -1174,6 +1215,12 @@ class ProxyRequestRunner : public Runner {
         is_lazy_ = true;
     }
     ~ProxyRequestRunner() {}
+    void GetInputs(std::vector<Runner*>* inputs) const override {
+        Runner::GetInputs(inputs);
+        if (nullptr != index_input_) {
+            inputs->push_back(index_input_);
+        }
+    }
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs) override;
@@ -1438,7 +1485,23 @@ class ClusterJob {
     }
 
     void AddMainTask(const ClusterTask& task) { main_task_id_ = AddTask(task); }
-    void Reset() { tasks_.clear(); }
+    void Reset() {
+        tasks_.clear();
+        prefetch_runners_.clear();
+    }
+    // the proxy runners of the task which read no result of other remote
+    // subqueries. they are dispatched together before running the task, so
+    // the task waits for the slowest subquery instead of the sum of them
+    const std::vector<Runner*>& GetPrefetchRunners(int32_t id) const {
+        static const std::vector<Runner*> empty;
+        auto iter = prefetch_runners_.find(id);
+        return iter == prefetch_runners_.cend() ? empty : iter->second;
+    }
+    void SetPrefetchRunners(int32_t id, const std::vector<Runner*>& runners) {
+        prefetch_runners_[id] = runners;
+    }
+    // collect the prefetch runners of every task which has 2 of them at least
+    void BuildPrefetchRunners();
     const size_t GetTaskSize() const { return tasks_.size(); }
     const bool IsValid() const { return !tasks_.empty(); }
     const int32_t main_task_id() const { return main_task_id_; }
@@ -1470,6 +1533,7 @@ class ClusterJob {
     std::string sql_;
     std::string db_;
     std::set<size_t> common_column_indices_;
+    std::map<int32_t, std::vector<Runner*>> prefetch_runners_;
 };
 class RunnerBuilder {
     enum TaskBiasType { kLeftBias, kRightBias, kNoBias };
@@ -1486,8 +1550,13 @@ class RunnerBuilder {
           cluster_job_(sql, db, common_column_indices),
           task_map_(),
           proxy_runner_map_(),
-          batch_common_node_set_(batch_common_node_set) {}
+          batch_common_node_set_(batch_common_node_set),
+          window_agg_parallelism_(1),
+          enable_window_incremental_agg_(false) {}
     virtual ~RunnerBuilder() {}
+    // the number of threads the window aggregations of a batch mode job run on
+    void SetWindowAggParallelism(uint32_t parallelism) { window_agg_parallelism_ = parallelism; }
+    void SetEnableWindowIncrementalAgg(bool flag) { enable_window_incremental_agg_ = flag; }
     ClusterTask RegisterTask(PhysicalOpNode* node, ClusterTask task) {
         task_map_[node] = task;
         if (batch_common_node_set_.find(node->node_id()) !=
@@ -1527,6 +1596,7 @@ class RunnerBuilder {
         } else {
             cluster_job_.AddMainTask(task);
         }
+        cluster_job_.BuildPrefetchRunners();
         return cluster_job_;
     }
 
@@ -1549,6 +1619,8 @@ class RunnerBuilder {
     std::unordered_map<hybridse::vm::Runner*, ::hybridse::vm::Runner*>
         proxy_runner_map_;
     std::set<size_t> batch_common_node_set_;
+    uint32_t window_agg_parallelism_;
+    bool enable_window_incremental_agg_;
     ClusterTask MultipleInherit(const std::vector<const ClusterTask*>& children, Runner* runner,
                                                 const Key& index_key, const TaskBiasType bias);
     ClusterTask BinaryInherit(const ClusterTask& left, const ClusterTask& right,
@@ -15,7 +15,9 @@
  */
 
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 #include "boost/algorithm/string.hpp"
 #include "case/sql_case.h"
 #include "gtest/gtest.h"
@@ -375,6 +377,190 @@ TEST_F(RunnerTest, KeyGeneratorTest) {
     ASSERT_EQ("5|55", group_runner->partition_gen_.GetKey(rows[4], empty_parameter));
 }
 
+// compile the sql of `sql_context` on db "db" and return its first window aggregation runner,
+// which is owned by `sql_context`
+WindowAggRunner* CompileWindowAggRunner(std::shared_ptr<SimpleCatalog> catalog, SqlContext* sql_context) {
+    SqlCompiler sql_compiler(catalog);
+    sql_context->db = "db";
+    base::Status compile_status;
+    EXPECT_TRUE(sql_compiler.Compile(*sql_context, compile_status)) << compile_status;
+    EXPECT_TRUE(sql_compiler.BuildClusterJob(*sql_context, compile_status)) << compile_status;
+    return dynamic_cast<WindowAggRunner*>(
+        GetFirstRunnerOfType(sql_context->cluster_job.GetMainTask().GetRoot(), kRunnerWindowAgg));
+}
+
+// the catalog of table db.t1 indexed on col1 and col5
+std::shared_ptr<SimpleCatalog> BuildWindowAggCatalog(hybridse::type::TableDef* table_def) {
+    BuildTableDef(*table_def);
+    table_def->set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def->add_indexes();
+    index->set_name("index1");
+    index->add_first_keys("col1");
+    index->set_second_key("col5");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, *table_def);
+    return BuildSimpleCatalog(db);
+}
+
+TEST_F(RunnerTest, WindowAggParallelismTest) {
+    std::string sqlstr =
+        "select col1, sum(col2) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 2 preceding and current row);";
+    hybridse::type::TableDef table_def;
+    auto catalog = BuildWindowAggCatalog(&table_def);
+
+    auto get_parallelism = [&](EngineMode mode, bool enable_parallelization, uint32_t thread_num) -> uint32_t {
+        SqlContext sql_context;
+        sql_context.sql = sqlstr;
+        sql_context.engine_mode = mode;
+        sql_context.enable_batch_window_parallelization = enable_parallelization;
+        sql_context.batch_window_parallel_thread_num = thread_num;
+        auto runner = CompileWindowAggRunner(catalog, &sql_context);
+        return runner == nullptr ? 0 : runner->parallelism_;
+    };
+    ASSERT_EQ(4u, get_parallelism(kBatchMode, true, 4));
+    ASSERT_EQ(1u, get_parallelism(kBatchMode, false, 4));
+    ASSERT_LE(1u, get_parallelism(kBatchMode, true, 0));
+}
+
+TEST_F(RunnerTest, PrefetchRunnersTest) {
+    SchemasContext schemas_ctx;
+    RequestRunner request(0, &schemas_ctx);
+    ProxyRequestRunner proxy1(1, 1, &schemas_ctx);
+    proxy1.AddProducer(&request);
+    ProxyRequestRunner proxy2(2, 2, &schemas_ctx);
+    proxy2.AddProducer(&request);
+    // picks its tablet by the output of proxy1
+    ProxyRequestRunner proxy3(3, 3, &proxy1, &schemas_ctx);
+    proxy3.AddProducer(&request);
+
+    // two independent proxy runners
+    ConcatRunner independent(4, &schemas_ctx, std::nullopt);
+    independent.AddProducer(&proxy1);
+    independent.AddProducer(&proxy2);
+    // the proxy runner depending on another one is left to the task
+    ConcatRunner dependent(5, &schemas_ctx, std::nullopt);
+    dependent.AddProducer(&independent);
+    dependent.AddProducer(&proxy3);
+    // nothing to overlap with a single proxy runner
+    ConcatRunner single(6, &schemas_ctx, std::nullopt);
+    single.AddProducer(&request);
+    single.AddProducer(&proxy3);
+
+    ClusterJob job;
+    ASSERT_EQ(0, job.AddTask(ClusterTask(&independent)));
+    ASSERT_EQ(1, job.AddTask(ClusterTask(&dependent)));
+    ASSERT_EQ(2, job.AddTask(ClusterTask(&single)));
+    job.BuildPrefetchRunners();
+    ASSERT_EQ(std::vector<Runner*>({&proxy1, &proxy2}), job.GetPrefetchRunners(0));
+    ASSERT_EQ(std::vector<Runner*>({&proxy1, &proxy2}), job.GetPrefetchRunners(1));
+    ASSERT_TRUE(job.GetPrefetchRunners(2).empty());
+    ASSERT_TRUE(proxy1.need_cache());
+    ASSERT_TRUE(proxy2.need_cache());
+    ASSERT_FALSE(proxy3.need_cache());
+}
+
+TEST_F(RunnerTest, WindowAggParallelRunTest) {
+    hybridse::type::TableDef table_def;
+    auto catalog = BuildWindowAggCatalog(&table_def);
+    // 20 partitions of 10 rows, inserted out of the key order
+    std::vector<Row> rows;
+    for (int32_t i = 0; i < 200; i++) {
+        codec::RowBuilder builder(table_def.columns());
+        std::string str = "v" + std::to_string(i);
+        uint32_t total_size = builder.CalTotalLength(1 + str.size());
+        int8_t* ptr = static_cast<int8_t*>(malloc(total_size));
+        builder.SetBuffer(ptr, total_size);
+        builder.AppendString("0", 1);
+        builder.AppendInt32(i * 7 % 20);
+        builder.AppendInt16(i % 5);
+        builder.AppendFloat(1.1f * i);
+        builder.AppendDouble(2.2 * i);
+        builder.AppendInt64(1000 + i);
+        builder.AppendString(str.c_str(), str.size());
+        rows.push_back(Row(base::RefCountedSlice::Create(ptr, total_size)));
+    }
+    ASSERT_TRUE(catalog->InsertRows("db", "t1", rows));
+
+    EngineOptions options;
+    Engine engine(catalog, options);
+    auto run = [&](const std::string& sqlstr, uint32_t parallelism, std::vector<Row>* outputs) {
+        base::Status status;
+        BatchRunSession session;
+        ASSERT_TRUE(engine.Get(sqlstr, "db", session, status)) << status;
+        auto info = std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo());
+        ASSERT_TRUE(info != nullptr);
+        auto runner = dynamic_cast<WindowAggRunner*>(
+            GetFirstRunnerOfType(info->get_sql_context().cluster_job.GetMainTask().GetRoot(), kRunnerWindowAgg));
+        ASSERT_TRUE(runner != nullptr);
+        runner->SetParallelism(parallelism, 1);
+        ASSERT_EQ(0, session.Run(*outputs));
+    };
+    auto check = [&](const std::string& sqlstr, size_t expect_cnt) {
+        std::vector<Row> serial;
+        run(sqlstr, 1, &serial);
+        ASSERT_EQ(expect_cnt, serial.size());
+        for (uint32_t parallelism : {2u, 3u, 4u, 32u}) {
+            std::vector<Row> parallel;
+            run(sqlstr, parallelism, &parallel);
+            ASSERT_EQ(serial.size(), parallel.size()) << "parallelism " << parallelism;
+            for (size_t i = 0; i < serial.size(); i++) {
+                ASSERT_EQ(0, serial[i].compare(parallel[i])) << "parallelism " << parallelism << ", row " << i;
+            }
+        }
+    };
+    std::string sqlstr =
+        "select col1, col5, sum(col2) over w1, count(col6) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 2 preceding and current row)";
+    check(sqlstr + ";", 200);
+    // the limit ends inside the second of the 4 shards
+    check(sqlstr + " limit 70;", 70);
+    check(sqlstr + " limit 3;", 3);
+}
+
+TEST_F(RunnerTest, WindowIncrementalAggTest) {
+    hybridse::type::TableDef table_def;
+    auto catalog = BuildWindowAggCatalog(&table_def);
+
+    auto is_incremental = [&](const std::string& sqlstr, EngineMode mode, bool enable) -> bool {
+        SqlContext sql_context;
+        sql_context.sql = sqlstr;
+        sql_context.engine_mode = mode;
+        sql_context.enable_batch_window_incremental_agg = enable;
+        auto runner = CompileWindowAggRunner(catalog, &sql_context);
+        return runner != nullptr && runner->incremental_agg_ != nullptr;
+    };
+    std::string rows_sql =
+        "select col1, col0, sum(col1) over w1, count(col3) over w1, min(col5) over w1, max(col4) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 2 preceding and current row);";
+    ASSERT_TRUE(is_incremental(rows_sql, kBatchMode, true));
+    ASSERT_FALSE(is_incremental(rows_sql, kBatchMode, false));
+    ASSERT_TRUE(is_incremental(
+        "select col1, avg(col1) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows_range between 3s preceding and current row);",
+        kBatchMode, true));
+    // float sum depends on the adding order
+    ASSERT_FALSE(is_incremental(
+        "select col1, sum(col3) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 2 preceding and current row);",
+        kBatchMode, true));
+    // the window does not end at the current row
+    ASSERT_FALSE(is_incremental(
+        "select col1, sum(col1) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 2 preceding and 1 preceding);",
+        kBatchMode, true));
+    ASSERT_FALSE(is_incremental(
+        "select col1, sum(col1) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 2 preceding and current row "
+        "EXCLUDE CURRENT_ROW);",
+        kBatchMode, true));
+    ASSERT_FALSE(is_incremental(
+        "select col1, sum(col1) over w1, lag(col1, 1) over w1 from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 2 preceding and current row);",
+        kBatchMode, true));
+}
+
 TEST_F(RunnerTest, RunnerPrintDataTest) {
     hybridse::type::TableDef table_def;
     BuildTableDef(table_def);
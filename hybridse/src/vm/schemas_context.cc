@@ -809,6 +809,18 @@ int32_t RowParser::GetString(const Row& row, const node::ColumnRefNode& col, std
     return 0;
 }
 
+base::Status RowParser::ResolveColumn(const std::string& col, size_t* schema_idx, size_t* col_idx) const {
+    return schema_ctx_->ResolveColumnIndexByName("", "", col, schema_idx, col_idx);
+}
+
+bool RowParser::IsNull(const Row& row, size_t schema_idx, size_t col_idx) const {
+    return row_view_list_[schema_idx].IsNULL(row.buf(schema_idx), col_idx);
+}
+
+int32_t RowParser::GetValue(const Row& row, size_t schema_idx, size_t col_idx, type::Type type, void* val) const {
+    return row_view_list_[schema_idx].GetValue(row.buf(schema_idx), col_idx, type, val);
+}
+
 type::Type RowParser::GetType(const std::string& col) const {
     size_t schema_idx, col_idx;
     schema_ctx_->ResolveColumnIndexByName("", "", col, &schema_idx, &col_idx);
@@ -15,7 +15,9 @@
  */
 
 #include "vm/sql_compiler.h"
+#include <algorithm>
 #include <memory>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 #include "boost/filesystem.hpp"
@@ -308,6 +310,15 @@ bool SqlCompiler::BuildClusterJob(SqlContext& ctx, Status& status) {  // NOLINT
                                  ctx.is_cluster_optimized && is_request_mode,
                                  ctx.batch_request_info.common_column_indices,
                                  ctx.batch_request_info.common_node_set);
+    if (vm::kBatchMode == ctx.engine_mode && ctx.enable_batch_window_parallelization) {
+        uint32_t thread_num = ctx.batch_window_parallel_thread_num;
+        if (thread_num == 0) {
+            thread_num = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        runner_builder.SetWindowAggParallelism(thread_num);
+    }
+    runner_builder.SetEnableWindowIncrementalAgg(vm::kBatchMode == ctx.engine_mode &&
+                                                 ctx.enable_batch_window_incremental_agg);
     ctx.cluster_job = runner_builder.BuildClusterJob(ctx.physical_plan, status);
     return status.isOK();
 }
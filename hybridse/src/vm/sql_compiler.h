@@ -44,6 +44,9 @@ struct SqlContext {
     bool is_batch_request_optimized = false;
     bool enable_expr_optimize = false;
     bool enable_batch_window_parallelization = true;
+    // 0 for the number of cores
+    uint32_t batch_window_parallel_thread_num = 0;
+    bool enable_batch_window_incremental_agg = false;
     bool enable_window_column_pruning = false;
 
     // the sql content
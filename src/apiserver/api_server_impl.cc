@@ -16,13 +16,21 @@
 
 #include "apiserver/api_server_impl.h"
 
+#include <algorithm>
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
 
 #include "apiserver/interface_provider.h"
+#include "boost/algorithm/string.hpp"
 #include "brpc/server.h"
+#include "gflags/gflags.h"
+#include "sdk/result_set_sql.h"
+
+DECLARE_int32(request_timeout_ms);
+DECLARE_uint32(deployment_binary_max_inflight);
 
 namespace openmldb {
 namespace apiserver {
@@ -80,7 +88,17 @@ void APIServerImpl::Process(google::protobuf::RpcController* cntl_base, const Ht
     const butil::IOBuf& req_body = cntl->request_attachment();
 
     JsonWriter writer;
-    provider_.handle(unresolved_path, method, req_body, writer);
+    if (IsBinaryRowContentType(cntl->http_request().content_type())) {
+        butil::IOBuf resp_body;
+        provider_.handle_binary(unresolved_path, method, req_body, &resp_body, writer);
+        if (!resp_body.empty()) {
+            cntl->http_response().set_content_type(kBinaryRowContentType);
+            cntl->response_attachment().swap(resp_body);
+            return;
+        }
+    } else {
+        provider_.handle(unresolved_path, method, req_body, writer);
+    }
 
     cntl->response_attachment().append(writer.GetString());
 }
@@ -340,12 +358,186 @@ void APIServerImpl::RegisterPut() {
         sql_router_->ExecuteInsert(db, insert_placeholder, row, &status);
         writer << resp.Set(status.code, status.msg);
     });
+
+    provider_.put_binary("/dbs/:db_name/tables/:table_name",
+                         [this](const InterfaceProvider::Params& param, const butil::IOBuf& req_body,
+                                butil::IOBuf* resp_body, JsonWriter& writer) {
+        auto resp = GeneralResp();
+        auto db_it = param.find("db_name");
+        auto table_it = param.find("table_name");
+        if (db_it == param.end() || table_it == param.end()) {
+            writer << resp.Set("Invalid path");
+            return;
+        }
+        auto db = db_it->second;
+        auto table = table_it->second;
+
+        // the body may have several rows, they are put in one insert
+        std::vector<std::string> encoded_rows;
+        if (!SplitEncodedRows(req_body, &encoded_rows) || encoded_rows.empty()) {
+            writer << resp.Set("Invalid rows in body");
+            return;
+        }
+        auto table_info = cluster_sdk_->GetTableInfo(db, table);
+        if (!table_info) {
+            writer << resp.Set("Table " + table + " does not exist in db " + db);
+            return;
+        }
+        std::string holders;
+        int cnt = table_info->column_desc_size() + table_info->added_column_desc_size();
+        for (int i = 0; i < cnt; ++i) {
+            holders += ((i == 0) ? "?" : ",?");
+        }
+        hybridse::sdk::Status status;
+        std::string insert_placeholder = "insert into " + table + " values(" + holders + ");";
+        auto rows = sql_router_->GetInsertRows(db, insert_placeholder, &status);
+        if (!rows) {
+            writer << resp.Set(status.msg);
+            return;
+        }
+        auto schema = std::dynamic_pointer_cast<hybridse::sdk::SchemaImpl>(rows->GetSchema());
+        if (!schema) {
+            writer << resp.Set("Invalid table schema");
+            return;
+        }
+        for (const auto& encoded_row : encoded_rows) {
+            if (!AppendEncodedRow(schema->GetSchema(), encoded_row, rows->NewRow())) {
+                writer << resp.Set("Translate to insert row failed");
+                return;
+            }
+        }
+
+        sql_router_->ExecuteInsert(db, insert_placeholder, rows, &status);
+        writer << resp.Set(status.code, status.msg);
+    });
+}
+
+bool APIServerImpl::IsBinaryRowContentType(const std::string& content_type) {
+    // the parameters like "; charset=binary" are ignored, the media type is case insensitive
+    std::string media_type = content_type.substr(0, content_type.find(';'));
+    boost::algorithm::trim(media_type);
+    return boost::algorithm::iequals(media_type, kBinaryRowContentType);
+}
+
+bool APIServerImpl::SplitEncodedRows(const butil::IOBuf& body, std::vector<std::string>* rows) {
+    size_t pos = 0;
+    while (pos < body.size()) {
+        if (body.size() - pos <= hybridse::codec::HEADER_LENGTH) {
+            return false;
+        }
+        uint32_t size = 0;
+        body.copy_to(&size, hybridse::codec::SIZE_LENGTH, pos + hybridse::codec::VERSION_LENGTH);
+        if (size <= hybridse::codec::HEADER_LENGTH || size > body.size() - pos) {
+            return false;
+        }
+        std::string row;
+        body.copy_to(&row, size, pos);
+        rows->push_back(std::move(row));
+        pos += size;
+    }
+    return true;
+}
+
+template <typename T>
+bool APIServerImpl::AppendEncodedRow(const hybridse::codec::Schema& schema, const std::string& encoded, T row) {
+    const auto* buf = reinterpret_cast<const int8_t*>(encoded.data());
+    uint32_t size = encoded.size();
+    hybridse::codec::RowView view(schema);
+    if (!view.Reset(buf, size)) {
+        return false;
+    }
+    // the row comes from the client, so check the fixed fields and the strings are inside the row before reading
+    uint32_t fixed_end = hybridse::codec::GetStartOffset(schema.size());
+    uint32_t str_cnt = 0;
+    const auto& type_size = hybridse::codec::GetTypeSizeMap();
+    for (int i = 0; i < schema.size(); ++i) {
+        if (schema.Get(i).type() == hybridse::type::kVarchar) {
+            ++str_cnt;
+            continue;
+        }
+        auto it = type_size.find(schema.Get(i).type());
+        if (it == type_size.end()) {
+            return false;
+        }
+        fixed_end += it->second;
+    }
+    fixed_end += str_cnt * hybridse::codec::GetAddrLength(size);
+    if (fixed_end > size) {
+        return false;
+    }
+    uint32_t str_len_sum = 0;
+    for (int i = 0; i < schema.size(); ++i) {
+        if (schema.Get(i).type() != hybridse::type::kVarchar || view.IsNULL(i)) {
+            continue;
+        }
+        const char* val = nullptr;
+        uint32_t len = 0;
+        if (view.GetString(i, &val, &len) != 0 || val < encoded.data() + fixed_end ||
+            val + len > encoded.data() + size) {
+            return false;
+        }
+        str_len_sum += len;
+    }
+    row->Init(static_cast<int>(str_len_sum));
+
+    for (int i = 0; i < schema.size(); ++i) {
+        if (view.IsNULL(i)) {
+            if (schema.Get(i).is_not_null() || !row->AppendNULL()) {
+                return false;
+            }
+            continue;
+        }
+        bool ok = false;
+        switch (schema.Get(i).type()) {
+            case hybridse::type::kBool:
+                ok = row->AppendBool(view.GetBoolUnsafe(i));
+                break;
+            case hybridse::type::kInt16:
+                ok = row->AppendInt16(view.GetInt16Unsafe(i));
+                break;
+            case hybridse::type::kInt32:
+                ok = row->AppendInt32(view.GetInt32Unsafe(i));
+                break;
+            case hybridse::type::kInt64:
+                ok = row->AppendInt64(view.GetInt64Unsafe(i));
+                break;
+            case hybridse::type::kFloat:
+                ok = row->AppendFloat(view.GetFloatUnsafe(i));
+                break;
+            case hybridse::type::kDouble:
+                ok = row->AppendDouble(view.GetDoubleUnsafe(i));
+                break;
+            case hybridse::type::kTimestamp:
+                ok = row->AppendTimestamp(view.GetTimestampUnsafe(i));
+                break;
+            case hybridse::type::kDate: {
+                int32_t year = 0, month = 0, day = 0;
+                ok = view.GetDate(i, &year, &month, &day) == 0 && row->AppendDate(year, month, day);
+                break;
+            }
+            case hybridse::type::kVarchar: {
+                const char* val = nullptr;
+                uint32_t len = 0;
+                ok = view.GetString(i, &val, &len) == 0 && row->AppendString(val, len);
+                break;
+            }
+            default:
+                break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void APIServerImpl::RegisterExecDeployment() {
     provider_.post("/dbs/:db_name/deployments/:sp_name",
                    std::bind(&APIServerImpl::ExecuteProcedure, this, false, std::placeholders::_1,
                              std::placeholders::_2, std::placeholders::_3));
+    provider_.post_binary("/dbs/:db_name/deployments/:sp_name",
+                          std::bind(&APIServerImpl::ExecuteDeploymentBinary, this, std::placeholders::_1,
+                                    std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
 }
 
 void APIServerImpl::RegisterExecSP() {
@@ -459,6 +651,73 @@ void APIServerImpl::ExecuteProcedure(bool has_common_col, const InterfaceProvide
     writer << sp_resp;
 }
 
+void APIServerImpl::ExecuteDeploymentBinary(const InterfaceProvider::Params& param, const butil::IOBuf& req_body,
+                                            butil::IOBuf* resp_body, JsonWriter& writer) {
+    auto resp = GeneralResp();
+    auto db_it = param.find("db_name");
+    auto sp_it = param.find("sp_name");
+    if (db_it == param.end() || sp_it == param.end()) {
+        writer << resp.Set("Invalid path");
+        return;
+    }
+    auto db = db_it->second;
+    auto sp = sp_it->second;
+
+    std::vector<std::string> encoded_rows;
+    if (!SplitEncodedRows(req_body, &encoded_rows) || encoded_rows.empty()) {
+        writer << resp.Set("Invalid input");
+        return;
+    }
+
+    hybridse::sdk::Status status;
+    auto sp_info = sql_router_->ShowProcedure(db, sp, &status);
+    if (!sp_info) {
+        writer << resp.Set(status.msg);
+        return;
+    }
+    const auto& schema_impl = dynamic_cast<const ::hybridse::sdk::SchemaImpl&>(sp_info->GetInputSchema());
+    auto input_schema = std::make_shared<::hybridse::sdk::SchemaImpl>(schema_impl.GetSchema());
+
+    // every row is a request of its own, up to deployment_binary_max_inflight of them run concurrently.
+    // the result rows are in the row format already, they are returned as they are in the order of the input
+    butil::IOBuf result;
+    std::deque<std::shared_ptr<sdk::QueryFuture>> futures;
+    auto append_result = [&]() {
+        auto rs = std::dynamic_pointer_cast<sdk::ResultSetSQL>(futures.front()->GetResultSet(&status));
+        futures.pop_front();
+        if (!rs) {
+            writer << (status.IsOK() ? resp.Set("Unexpected result set") : resp.Set(status.code, status.msg));
+            return false;
+        }
+        rs->AppendEncodedRows(&result);
+        return true;
+    };
+    uint32_t max_inflight = std::max(FLAGS_deployment_binary_max_inflight, 1u);
+    std::set<std::string> col_set;
+    for (const auto& encoded_row : encoded_rows) {
+        if (futures.size() >= max_inflight && !append_result()) {
+            return;
+        }
+        auto row = std::make_shared<sdk::SQLRequestRow>(input_schema, col_set);
+        if (!AppendEncodedRow(input_schema->GetSchema(), encoded_row, row) || !row->Build()) {
+            writer << resp.Set("Translate to request row failed");
+            return;
+        }
+        auto future = sql_router_->CallProcedure(db, sp, FLAGS_request_timeout_ms, row, &status);
+        if (!future) {
+            writer << resp.Set(status.msg);
+            return;
+        }
+        futures.push_back(future);
+    }
+    while (!futures.empty()) {
+        if (!append_result()) {
+            return;
+        }
+    }
+    resp_body->swap(result);
+}
+
 void APIServerImpl::RegisterGetSP() {
     provider_.get("/dbs/:db_name/procedures/:sp_name",
                   [this](const InterfaceProvider::Params& param, const butil::IOBuf& req_body, JsonWriter& writer) {
@@ -25,6 +25,7 @@
 
 #include "apiserver/interface_provider.h"
 #include "apiserver/json_helper.h"
+#include "codec/fe_row_codec.h"
 #include "json2pb/rapidjson.h"  // rapidjson's DOM-style API
 #include "proto/api_server.pb.h"
 #include "sdk/sql_cluster_router.h"
@@ -42,6 +43,9 @@ using butil::rapidjson::Writer;
 // InterfaceProvider's url parser supports to parse urls like "/a/:arg1/b/:arg2/:arg3", but doesn't support wildcards.
 // Methods should be registered in `InterfaceProvider` in the init phase.
 // Both input and output are json data. We use rapidjson to handle it.
+// Put and deployment requests can also be sent in the binary content type `kBinaryRowContentType`, the body is the
+// rows encoded in the row format one after another, so the rows are not converted to and from text. The result rows
+// of a deployment are returned in the same format, and the errors are returned in json.
 class APIServerImpl : public APIServer {
  public:
     APIServerImpl() = default;
@@ -51,6 +55,12 @@ class APIServerImpl : public APIServer {
     void Process(google::protobuf::RpcController* cntl_base, const HttpRequest*, HttpResponse*,
                  google::protobuf::Closure* done) override;
     static std::string InnerTypeTransform(const std::string& s);
+    // split the body into the encoded rows, the size of a row is in its header
+    static bool SplitEncodedRows(const butil::IOBuf& body, std::vector<std::string>* rows);
+
+    static constexpr const char* kBinaryRowContentType = "application/x-openmldb-row";
+    // whether the media type of content_type is kBinaryRowContentType, whatever its parameters are
+    static bool IsBinaryRowContentType(const std::string& content_type);
 
     void Refresh();
 
@@ -68,6 +78,13 @@ class APIServerImpl : public APIServer {
     void ExecuteProcedure(bool has_common_col, const InterfaceProvider::Params& param, const butil::IOBuf& req_body,
                           JsonWriter& writer);  // NOLINT
 
+    void ExecuteDeploymentBinary(const InterfaceProvider::Params& param, const butil::IOBuf& req_body,
+                                 butil::IOBuf* resp_body, JsonWriter& writer);  // NOLINT
+
+    // init the row and append the values of the encoded row, return false if the encoded row is malformed
+    template <typename T>
+    static bool AppendEncodedRow(const hybridse::codec::Schema& schema, const std::string& encoded, T row);
+
     static bool Json2SQLRequestRow(const butil::rapidjson::Value& non_common_cols_v,
                                    const butil::rapidjson::Value& common_cols_v,
                                    std::shared_ptr<openmldb::sdk::SQLRequestRow> row);
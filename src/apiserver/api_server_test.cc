@@ -16,6 +16,8 @@
 
 #include <memory>
 #include <random>
+#include <string>
+#include <vector>
 
 #include "apiserver/api_server_impl.h"
 #include "brpc/channel.h"
@@ -27,6 +29,8 @@
 #include "json2pb/rapidjson.h"
 #include "sdk/mini_cluster.h"
 
+DECLARE_uint32(deployment_binary_max_inflight);
+
 namespace openmldb::apiserver {
 
 class APIServerTestEnv : public testing::Environment {
@@ -725,6 +729,132 @@ TEST_F(APIServerTest, no_common) {
     ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop table trans;", &status));
 }
 
+TEST_F(APIServerTest, binaryRowContentType) {
+    ASSERT_TRUE(APIServerImpl::IsBinaryRowContentType("application/x-openmldb-row"));
+    ASSERT_TRUE(APIServerImpl::IsBinaryRowContentType("application/x-openmldb-row; charset=binary"));
+    ASSERT_TRUE(APIServerImpl::IsBinaryRowContentType(" Application/X-OpenMLDB-Row ;v=1"));
+    ASSERT_FALSE(APIServerImpl::IsBinaryRowContentType("application/json"));
+    ASSERT_FALSE(APIServerImpl::IsBinaryRowContentType("application/x-openmldb-rows"));
+    ASSERT_FALSE(APIServerImpl::IsBinaryRowContentType(""));
+}
+
+TEST_F(APIServerTest, binaryRows) {
+    const auto env = APIServerTestEnv::Instance();
+
+    std::string table = "trans_bin";
+    std::string ddl = "create table " + table +
+                      "(c1 string, c3 int, c4 bigint, c5 float, c6 double, c7 timestamp, c8 date, "
+                      "index(key=c1, ts=c7));";
+    hybridse::sdk::Status status;
+    env->cluster_remote->ExecuteDDL(env->db, "drop table " + table + ";", &status);
+    ASSERT_TRUE(env->cluster_sdk->Refresh());
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, ddl, &status)) << status.msg;
+    ASSERT_TRUE(env->cluster_sdk->Refresh());
+
+    std::string sp_name = "sp_bin";
+    std::string sql = "SELECT c1, c3, sum(c4) OVER w1 as w1_c4_sum FROM " + table + " WINDOW w1 AS" +
+                      " (PARTITION BY c1 ORDER BY c7 ROWS BETWEEN 2 PRECEDING AND CURRENT ROW);";
+    std::string sp_ddl = "create procedure " + sp_name +
+                         " (c1 string, c3 int, c4 bigint, c5 float, c6 double, c7 timestamp, c8 date)" +
+                         " begin " + sql + " end;";
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, sp_ddl, &status)) << status.msg;
+    ASSERT_TRUE(env->cluster_sdk->Refresh());
+
+    // the input schema of the deployment is the same as the table
+    auto encode = [&](int64_t c4) {
+        auto row = env->cluster_remote->GetRequestRowByProcedure(env->db, sp_name, &status);
+        EXPECT_TRUE(row) << status.msg;
+        row->Init(2);
+        row->AppendString("bb");
+        row->AppendInt32(23);
+        row->AppendInt64(c4);
+        row->AppendFloat(5.1);
+        row->AppendDouble(6.1);
+        row->AppendTimestamp(1590738994000 + c4);
+        row->AppendDate(2021, 8, 1);
+        EXPECT_TRUE(row->Build());
+        return row->GetRow();
+    };
+
+    // put two rows in one request
+    {
+        brpc::Controller cntl;
+        cntl.http_request().set_method(brpc::HTTP_METHOD_PUT);
+        cntl.http_request().uri() = "http://127.0.0.1:8010/dbs/" + env->db + "/tables/" + table;
+        cntl.http_request().set_content_type(APIServerImpl::kBinaryRowContentType);
+        cntl.request_attachment().append(encode(10));
+        cntl.request_attachment().append(encode(20));
+        env->http_channel.CallMethod(NULL, &cntl, NULL, NULL, NULL);
+        ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+        GeneralResp resp;
+        JsonReader reader(cntl.response_attachment().to_string().c_str());
+        reader >> resp;
+        ASSERT_EQ(0, resp.code) << resp.msg;
+    }
+    auto rs = env->cluster_remote->ExecuteSQL(env->db, "select * from " + table + ";", &status);
+    ASSERT_TRUE(rs) << status.msg;
+    ASSERT_EQ(2, rs->Size());
+
+    // a truncated row is rejected with a json error
+    {
+        brpc::Controller cntl;
+        cntl.http_request().set_method(brpc::HTTP_METHOD_PUT);
+        cntl.http_request().uri() = "http://127.0.0.1:8010/dbs/" + env->db + "/tables/" + table;
+        cntl.http_request().set_content_type(APIServerImpl::kBinaryRowContentType);
+        auto row = encode(30);
+        cntl.request_attachment().append(row.substr(0, row.size() - 1));
+        env->http_channel.CallMethod(NULL, &cntl, NULL, NULL, NULL);
+        ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+        GeneralResp resp;
+        JsonReader reader(cntl.response_attachment().to_string().c_str());
+        reader >> resp;
+        ASSERT_NE(0, resp.code);
+    }
+
+    // call the deployment with two rows, one call in flight at a time, the response is the encoded output rows.
+    // the parameters of the content type are ignored
+    uint32_t old_max_inflight = FLAGS_deployment_binary_max_inflight;
+    FLAGS_deployment_binary_max_inflight = 1;
+    {
+        brpc::Controller cntl;
+        cntl.http_request().set_method(brpc::HTTP_METHOD_POST);
+        cntl.http_request().uri() = "http://127.0.0.1:8010/dbs/" + env->db + "/deployments/" + sp_name;
+        cntl.http_request().set_content_type(std::string(APIServerImpl::kBinaryRowContentType) + "; charset=binary");
+        cntl.request_attachment().append(encode(30));
+        cntl.request_attachment().append(encode(40));
+        env->http_channel.CallMethod(NULL, &cntl, NULL, NULL, NULL);
+        ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+        ASSERT_EQ(APIServerImpl::kBinaryRowContentType, cntl.http_response().content_type())
+            << cntl.response_attachment().to_string();
+
+        std::vector<std::string> out_rows;
+        ASSERT_TRUE(APIServerImpl::SplitEncodedRows(cntl.response_attachment(), &out_rows));
+        ASSERT_EQ(2u, out_rows.size());
+        hybridse::codec::Schema out_schema;
+        auto add_col = [&out_schema](const std::string& name, hybridse::type::Type type) {
+            auto col = out_schema.Add();
+            col->set_name(name);
+            col->set_type(type);
+        };
+        add_col("c1", hybridse::type::kVarchar);
+        add_col("c3", hybridse::type::kInt32);
+        add_col("w1_c4_sum", hybridse::type::kInt64);
+        hybridse::codec::RowView view(out_schema);
+        // request rows are not inserted, so each window is the two put rows and the request row
+        std::vector<int64_t> expect_sums = {60, 70};
+        for (size_t i = 0; i < out_rows.size(); i++) {
+            ASSERT_TRUE(view.Reset(reinterpret_cast<const int8_t*>(out_rows[i].data()), out_rows[i].size()));
+            ASSERT_EQ("bb", view.GetStringUnsafe(0));
+            ASSERT_EQ(23, view.GetInt32Unsafe(1));
+            ASSERT_EQ(expect_sums[i], view.GetInt64Unsafe(2));
+        }
+    }
+    FLAGS_deployment_binary_max_inflight = old_max_inflight;
+
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop procedure " + sp_name + ";", &status)) << status.msg;
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop table " + table + ";", &status)) << status.msg;
+}
+
 TEST_F(APIServerTest, no_common_not_first_string) {
     const auto env = APIServerTestEnv::Instance();
 
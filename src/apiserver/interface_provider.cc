@@ -98,17 +98,27 @@ bool ReducedUrlParser::parse(std::string const& urlString, Url* url) {
 }
 
 InterfaceProvider& InterfaceProvider::get(const std::string& path, std::function<func> callback) {
-    registerRequest(brpc::HttpMethod::HTTP_METHOD_GET, path, std::move(callback));
+    registerRequest(brpc::HttpMethod::HTTP_METHOD_GET, path, std::move(callback), &requests_);
     return *this;
 }
 
 InterfaceProvider& InterfaceProvider::put(const std::string& path, std::function<func> callback) {
-    registerRequest(brpc::HttpMethod::HTTP_METHOD_PUT, path, std::move(callback));
+    registerRequest(brpc::HttpMethod::HTTP_METHOD_PUT, path, std::move(callback), &requests_);
     return *this;
 }
 
 InterfaceProvider& InterfaceProvider::post(const std::string& path, std::function<func> callback) {
-    registerRequest(brpc::HttpMethod::HTTP_METHOD_POST, path, std::move(callback));
+    registerRequest(brpc::HttpMethod::HTTP_METHOD_POST, path, std::move(callback), &requests_);
+    return *this;
+}
+
+InterfaceProvider& InterfaceProvider::put_binary(const std::string& path, std::function<binary_func> callback) {
+    registerRequest(brpc::HttpMethod::HTTP_METHOD_PUT, path, std::move(callback), &binary_requests_);
+    return *this;
+}
+
+InterfaceProvider& InterfaceProvider::post_binary(const std::string& path, std::function<binary_func> callback) {
+    registerRequest(brpc::HttpMethod::HTTP_METHOD_POST, path, std::move(callback), &binary_requests_);
     return *this;
 }
 
@@ -147,45 +157,59 @@ std::unordered_map<std::string, std::string> InterfaceProvider::extractParameter
     return map;
 }
 
-void InterfaceProvider::registerRequest(brpc::HttpMethod type, std::string const& url, std::function<func>&& callback) {
+template <typename F>
+void InterfaceProvider::registerRequest(brpc::HttpMethod type, std::string const& url, std::function<F>&& callback,
+                                        RequestMap<F>* requests) {
     Url parsed;
     if (!ReducedUrlParser::parse(url, &parsed)) {
         LOG(ERROR) << "Fail to parse url " << url;
         return;
     }
-    BuiltRequest req{parsed, callback};
-    requests_[type].push_back(req);
+    BuiltRequest<F> req{parsed, callback};
+    (*requests)[type].push_back(req);
 }
 
-bool InterfaceProvider::handle(const std::string& path, const brpc::HttpMethod& method, const butil::IOBuf& req_body,
-                               JsonWriter& writer) {
+template <typename F>
+const InterfaceProvider::BuiltRequest<F>* InterfaceProvider::find(const RequestMap<F>& requests,
+                                                                  const brpc::HttpMethod& method, const Url& url,
+                                                                  JsonWriter& writer) {
     auto err = GeneralResp();
-    Url url;
-
-    if (!ReducedUrlParser::parse(path, &url)) {
-        writer << err.Set("invalid url");
-        return false;
-    }
-
-    auto requestList = requests_.find(method);
+    auto requestList = requests.find(method);
 
     // is there any request matching the request type?
-    if (requestList == std::end(requests_)) {
+    if (requestList == std::end(requests)) {
         if (strncmp(HttpMethod2Str(method), "UNKNOWN", 7) != 0) {
             writer << err.Set("unsupported method");
-            return false;
+            return nullptr;
         }
 
         writer << err.Set("invalid method");
-        return false;
+        return nullptr;
     }
 
     // is there a registered request, that matches the url?
     auto request = std::find_if(std::begin(requestList->second), std::end(requestList->second),
-                                [&, this](BuiltRequest const& request) { return matching(url, request.url); });
+                                [&](BuiltRequest<F> const& request) { return matching(url, request.url); });
 
     if (request == std::end(requestList->second)) {
         writer << err.Set("no match method");
+        return nullptr;
+    }
+    return &(*request);
+}
+
+bool InterfaceProvider::handle(const std::string& path, const brpc::HttpMethod& method, const butil::IOBuf& req_body,
+                               JsonWriter& writer) {
+    auto err = GeneralResp();
+    Url url;
+
+    if (!ReducedUrlParser::parse(path, &url)) {
+        writer << err.Set("invalid url");
+        return false;
+    }
+
+    auto request = find(requests_, method, url, writer);
+    if (request == nullptr) {
         return false;
     }
 
@@ -193,5 +217,25 @@ bool InterfaceProvider::handle(const std::string& path, const brpc::HttpMethod&
     request->callback(params, req_body, writer);
     return true;
 }
+
+bool InterfaceProvider::handle_binary(const std::string& path, const brpc::HttpMethod& method,
+                                      const butil::IOBuf& req_body, butil::IOBuf* resp_body, JsonWriter& writer) {
+    auto err = GeneralResp();
+    Url url;
+
+    if (!ReducedUrlParser::parse(path, &url)) {
+        writer << err.Set("invalid url");
+        return false;
+    }
+
+    auto request = find(binary_requests_, method, url, writer);
+    if (request == nullptr) {
+        return false;
+    }
+
+    auto params = extractParameters(url, request->url);
+    request->callback(params, req_body, resp_body, writer);
+    return true;
+}
 }  // namespace apiserver
 }  // namespace openmldb
@@ -117,6 +117,10 @@ class InterfaceProvider {
 
     typedef std::unordered_map<std::string, std::string> Params;
     using func = void(const Params& params, const butil::IOBuf& req_body, JsonWriter& writer);  // NOLINT
+    // a binary handler writes the result to `resp_body`, or writes the json response to `writer` if there is no
+    // binary result, e.g. an error
+    using binary_func = void(const Params& params, const butil::IOBuf& req_body, butil::IOBuf* resp_body,  // NOLINT
+                             JsonWriter& writer);  // NOLINT
     /**
      *  Registers a new get request handler.
      *
@@ -144,23 +148,48 @@ class InterfaceProvider {
      */
     InterfaceProvider& post(std::string const& path, std::function<func> callback);
 
+    /**
+     *  Registers a new put request handler for the binary request body.
+     */
+    InterfaceProvider& put_binary(std::string const& path, std::function<binary_func> callback);
+
+    /**
+     *  Registers a new post request handler for the binary request body.
+     */
+    InterfaceProvider& post_binary(std::string const& path, std::function<binary_func> callback);
+
     bool handle(const std::string& path, const brpc::HttpMethod& method, const butil::IOBuf& req_body,
                 JsonWriter& writer);  // NOLINT
 
+    bool handle_binary(const std::string& path, const brpc::HttpMethod& method, const butil::IOBuf& req_body,
+                       butil::IOBuf* resp_body, JsonWriter& writer);  // NOLINT
+
  private:
+    template <typename F>
     struct BuiltRequest {
         Url url;
-        std::function<func> callback;
+        std::function<F> callback;
     };
 
+    template <typename F>
+    using RequestMap = std::unordered_map<int, std::vector<BuiltRequest<F>>>;
+
+    // find the registered request matching the url, or write the error to `writer` and return nullptr
+    template <typename F>
+    static const BuiltRequest<F>* find(const RequestMap<F>& requests, const brpc::HttpMethod& method, const Url& url,
+                                       JsonWriter& writer);  // NOLINT
+
     static bool matching(const Url& received, const Url& registered);
     static std::unordered_map<std::string, std::string> extractParameters(const Url& received, const Url& registered);
 
  private:
-    void registerRequest(brpc::HttpMethod, const std::string& path, std::function<func>&& callback);
+    template <typename F>
+    static void registerRequest(brpc::HttpMethod, const std::string& path, std::function<F>&& callback,
+                                RequestMap<F>* requests);
 
  private:
-    std::unordered_map<int, std::vector<BuiltRequest>> requests_;
+    RequestMap<func> requests_;
+    RequestMap<binary_func> binary_requests_;
 };
 
 struct GeneralResp {
@@ -15,15 +15,243 @@
  */
 
 #include "catalog/distribute_iterator.h"
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>  // NOLINT
+#include <utility>
+
 #include "gflags/gflags.h"
 
+DECLARE_int32(request_max_retry);
+DECLARE_int32(request_timeout_ms);
 DECLARE_uint32(traverse_cnt_limit);
+DECLARE_uint32(traverse_prefetch_depth);
+DECLARE_uint32(traverse_prefetch_concurrency);
 
 namespace openmldb {
 namespace catalog {
 
 constexpr uint32_t INVALID_PID = UINT32_MAX;
 
+struct TraversePrefetcher::Context {
+    struct Partition {
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        std::deque<std::shared_ptr<::openmldb::base::TraverseKvIterator>> pages;
+        std::string pk;
+        uint64_t ts = 0;
+        bool skip_current_pk = false;
+        bool finished = false;
+        // the controller of the request in flight, null if the partition is not being fetched
+        std::shared_ptr<brpc::Controller> cntl;
+    };
+
+    struct Fetch {
+        uint32_t pid;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        std::shared_ptr<brpc::Controller> cntl;
+        ::openmldb::api::TraverseRequest request;
+    };
+
+    Context(uint32_t table_id, const std::string& index, bool next_by_pk, uint32_t max_pages, uint32_t max_inflight)
+        : tid(table_id), index_name(index), by_pk(next_by_pk), depth(std::max(max_pages, 1u)),
+        concurrency(std::max(max_inflight, 1u)), mu(), page_cv(), partitions(), inflight(0), stop(false) {}
+
+    // start the requests of the partitions with the smallest pids which need more pages, must hold mu
+    void PickFetches(std::vector<Fetch>* fetches);
+    // send the requests without holding mu, the callback may run before AsyncTraverse returns
+    void Send(const std::shared_ptr<Context>& self, std::vector<Fetch>* fetches);
+    void OnPage(uint32_t pid, const brpc::Controller& cntl,
+            const std::shared_ptr<::openmldb::api::TraverseResponse>& response, std::vector<Fetch>* fetches);
+    // finish a partition whose request is not sent, must hold mu
+    void Abort(uint32_t pid);
+
+    const uint32_t tid;
+    const std::string index_name;
+    const bool by_pk;
+    const uint32_t depth;
+    const uint32_t concurrency;
+    std::mutex mu;
+    // NextPage waits on it for the fetched pages
+    std::condition_variable page_cv;
+    std::map<uint32_t, Partition> partitions;
+    uint32_t inflight;
+    bool stop;
+};
+
+class TraversePrefetcher::Callback : public ::openmldb::RpcCallback<::openmldb::api::TraverseResponse> {
+ public:
+    Callback(const std::shared_ptr<Context>& ctx, uint32_t pid, const std::shared_ptr<brpc::Controller>& cntl)
+        : RpcCallback(std::make_shared<::openmldb::api::TraverseResponse>(), cntl), ctx_(ctx), pid_(pid) {}
+
+    void Run() override {
+        std::vector<Context::Fetch> fetches;
+        ctx_->OnPage(pid_, *GetController(), GetResponse(), &fetches);
+        ctx_->Send(ctx_, &fetches);
+        RpcCallback::Run();
+    }
+
+ private:
+    std::shared_ptr<Context> ctx_;
+    uint32_t pid_;
+};
+
+void TraversePrefetcher::Context::PickFetches(std::vector<Fetch>* fetches) {
+    for (auto& kv : partitions) {
+        if (stop || inflight >= concurrency) {
+            return;
+        }
+        auto& partition = kv.second;
+        if (partition.cntl || partition.finished || partition.pages.size() >= depth) {
+            continue;
+        }
+        partition.cntl = std::make_shared<brpc::Controller>();
+        partition.cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+        partition.cntl->set_max_retry(FLAGS_request_max_retry);
+        inflight++;
+        Fetch fetch;
+        fetch.pid = kv.first;
+        fetch.client = partition.client;
+        fetch.cntl = partition.cntl;
+        fetch.request.set_tid(tid);
+        fetch.request.set_pid(kv.first);
+        fetch.request.set_limit(FLAGS_traverse_cnt_limit);
+        if (!index_name.empty()) {
+            fetch.request.set_idx_name(index_name);
+        }
+        if (!partition.pk.empty()) {
+            fetch.request.set_pk(partition.pk);
+            fetch.request.set_ts(partition.ts);
+        }
+        fetch.request.set_skip_current_pk(partition.skip_current_pk);
+        fetches->push_back(std::move(fetch));
+    }
+}
+
+void TraversePrefetcher::Context::Send(const std::shared_ptr<Context>& self, std::vector<Fetch>* fetches) {
+    for (auto& fetch : *fetches) {
+        DLOG(INFO) << "prefetch pid " << fetch.pid << " last pk " << fetch.request.pk() << " key "
+                   << fetch.request.ts();
+        auto callback = new Callback(self, fetch.pid, fetch.cntl);
+        if (!fetch.client->AsyncTraverse(fetch.request, callback)) {
+            LOG(WARNING) << "fail to send traverse request. tid " << tid << " pid " << fetch.pid;
+            callback->UnRef();
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                Abort(fetch.pid);
+            }
+            page_cv.notify_all();
+        }
+    }
+    fetches->clear();
+}
+
+void TraversePrefetcher::Context::Abort(uint32_t pid) {
+    auto& partition = partitions[pid];
+    partition.cntl.reset();
+    partition.finished = true;
+    inflight--;
+}
+
+void TraversePrefetcher::Context::OnPage(uint32_t pid, const brpc::Controller& cntl,
+        const std::shared_ptr<::openmldb::api::TraverseResponse>& response, std::vector<Fetch>* fetches) {
+    std::shared_ptr<::openmldb::base::TraverseKvIterator> it;
+    if (cntl.Failed()) {
+        if (cntl.ErrorCode() != ECANCELED) {
+            LOG(WARNING) << "fail to traverse tid " << tid << " pid " << pid << ": " << cntl.ErrorText();
+        }
+    } else if (response->code() != 0) {
+        LOG(WARNING) << "fail to traverse tid " << tid << " pid " << pid << ": " << response->msg();
+    } else {
+        it = std::make_shared<::openmldb::base::TraverseKvIterator>(response);
+    }
+    bool valid = it && it->Valid();
+    std::string last_pk;
+    if (valid && by_pk) {
+        // walk a copy of the page, `it` has to stay at the first record
+        ::openmldb::base::TraverseKvIterator tail(response);
+        while (tail.Valid()) {
+            last_pk = tail.GetPK();
+            tail.Next();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto& partition = partitions[pid];
+        partition.cntl.reset();
+        inflight--;
+        if (valid) {
+            partition.pages.push_back(it);
+            partition.finished = it->IsFinish();
+            if (by_pk) {
+                partition.pk = last_pk;
+                partition.skip_current_pk = true;
+            } else {
+                partition.pk = it->GetLastPK();
+            }
+            partition.ts = it->GetLastTS();
+        } else {
+            partition.finished = true;
+        }
+        PickFetches(fetches);
+    }
+    page_cv.notify_all();
+}
+
+TraversePrefetcher::TraversePrefetcher(uint32_t tid, const std::string& index_name, bool by_pk,
+        const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+        uint32_t depth, uint32_t concurrency)
+    : ctx_(std::make_shared<Context>(tid, index_name, by_pk, depth, concurrency)) {
+    std::vector<Context::Fetch> fetches;
+    {
+        std::lock_guard<std::mutex> lock(ctx_->mu);
+        for (const auto& kv : tablet_clients) {
+            ctx_->partitions[kv.first].client = kv.second;
+        }
+        ctx_->PickFetches(&fetches);
+    }
+    ctx_->Send(ctx_, &fetches);
+}
+
+TraversePrefetcher::~TraversePrefetcher() {
+    std::vector<brpc::CallId> calls;
+    {
+        std::lock_guard<std::mutex> lock(ctx_->mu);
+        ctx_->stop = true;
+        for (const auto& kv : ctx_->partitions) {
+            if (kv.second.cntl) {
+                calls.push_back(kv.second.cntl->call_id());
+            }
+        }
+    }
+    for (const auto& call : calls) {
+        brpc::StartCancel(call);
+    }
+}
+
+std::shared_ptr<::openmldb::base::TraverseKvIterator> TraversePrefetcher::NextPage(uint32_t pid) {
+    std::shared_ptr<::openmldb::base::TraverseKvIterator> it;
+    std::vector<Context::Fetch> fetches;
+    {
+        std::unique_lock<std::mutex> lock(ctx_->mu);
+        auto iter = ctx_->partitions.find(pid);
+        if (iter == ctx_->partitions.end()) {
+            return it;
+        }
+        auto& partition = iter->second;
+        ctx_->page_cv.wait(lock, [&partition] { return !partition.pages.empty() || partition.finished; });
+        if (partition.pages.empty()) {
+            return it;
+        }
+        it = partition.pages.front();
+        partition.pages.pop_front();
+        ctx_->PickFetches(&fetches);
+    }
+    ctx_->Send(ctx_, &fetches);
+    return it;
+}
+
 FullTableIterator::FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
         const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
     : tid_(tid), tables_(tables), tablet_clients_(tablet_clients), in_local_(true), cur_pid_(INVALID_PID),
@@ -51,6 +279,12 @@ void FullTableIterator::Reset() {
     kv_it_.reset();
     cur_pid_ = INVALID_PID;
     in_local_ = true;
+    prefetcher_.reset();
+    if (FLAGS_traverse_prefetch_depth > 0 && !tablet_clients_.empty()) {
+        // fetch the remote partitions while the local ones are traversed
+        prefetcher_ = std::make_unique<TraversePrefetcher>(tid_, "", false, tablet_clients_,
+                FLAGS_traverse_prefetch_depth, FLAGS_traverse_prefetch_concurrency);
+    }
 }
 
 void FullTableIterator::EndLocal() {
@@ -114,6 +348,9 @@ bool FullTableIterator::NextFromRemote() {
             return true;
         }
     }
+    if (prefetcher_) {
+        return NextFromPrefetcher();
+    }
     auto iter = tablet_clients_.begin();
     if (cur_pid_ == INVALID_PID) {
         cur_pid_ = iter->first;
@@ -154,6 +391,21 @@ bool FullTableIterator::NextFromRemote() {
     return true;
 }
 
+bool FullTableIterator::NextFromPrefetcher() {
+    auto iter = cur_pid_ == INVALID_PID ? tablet_clients_.begin() : tablet_clients_.find(cur_pid_);
+    for (; iter != tablet_clients_.end(); iter++) {
+        cur_pid_ = iter->first;
+        kv_it_ = prefetcher_->NextPage(cur_pid_);
+        if (kv_it_ && kv_it_->Valid()) {
+            response_vec_.emplace_back(kv_it_->GetResponse());
+            key_ = kv_it_->GetKey();
+            return true;
+        }
+    }
+    kv_it_.reset();
+    return false;
+}
+
 const ::hybridse::codec::Row& FullTableIterator::GetValue() {
     if (it_ && it_->Valid()) {
         value_ = ::hybridse::codec::Row(
@@ -181,6 +433,7 @@ void DistributeWindowIterator::Reset() {
     it_.reset();
     kv_it_.reset();
     cur_pid_ = INVALID_PID;
+    prefetcher_.reset();
 }
 
 // seek to the pos where key = `key` on success
@@ -217,12 +470,31 @@ DistributeWindowIterator::ItStat DistributeWindowIterator::SeekToFirstRemote() c
     return {INVALID_PID, nullptr, {}};
 }
 
+void DistributeWindowIterator::NextFromPrefetcher(
+        std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>>::const_iterator iter) {
+    for (; iter != tablet_clients_.end(); iter++) {
+        auto it = prefetcher_->NextPage(iter->first);
+        if (it && it->Valid()) {
+            response_vec_.emplace_back(it->GetResponse());
+            kv_it_ = it;
+            cur_pid_ = iter->first;
+            return;
+        }
+    }
+    kv_it_.reset();
+}
+
 void DistributeWindowIterator::SeekToFirst() {
     DLOG(INFO) << "seek to first";
     Reset();
     if (!tables_) {
         return;
     }
+    if (FLAGS_traverse_prefetch_depth > 0 && !tablet_clients_.empty()) {
+        // fetch the remote partitions while the local ones are traversed
+        prefetcher_ = std::make_unique<TraversePrefetcher>(tid_, index_name_, true, tablet_clients_,
+                FLAGS_traverse_prefetch_depth, FLAGS_traverse_prefetch_concurrency);
+    }
     for (const auto& kv : *tables_) {
         auto it = kv.second->NewWindowIterator(index_);
         if (it != nullptr) {
@@ -236,6 +508,10 @@ void DistributeWindowIterator::SeekToFirst() {
             delete it;
         }
     }
+    if (prefetcher_) {
+        NextFromPrefetcher(tablet_clients_.cbegin());
+        return;
+    }
     const auto& stat = SeekToFirstRemote();
     if (stat.kv_it) {
         response_vec_.push_back(stat.kv_it->GetResponse());
@@ -313,6 +589,10 @@ void DistributeWindowIterator::Next() {
         if (iter == tablet_clients_.end()) {
             return;
         }
+        if (prefetcher_ && traverse_it) {
+            NextFromPrefetcher(iter);
+            return;
+        }
         uint32_t count = 0;
         kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", cur_pk, last_ts, FLAGS_traverse_cnt_limit, true, count);
         DLOG(INFO) << "pid " << cur_pid_ << " last pk " << cur_pk << " key " << last_ts << " count " << count;
@@ -335,6 +615,8 @@ void DistributeWindowIterator::Next() {
             }
             kv_it_.reset();
         } while (true);
+    } else if (prefetcher_) {
+        NextFromPrefetcher(tablet_clients_.cbegin());
     } else {
         const auto& stat = SeekToFirstRemote();
         if (stat.kv_it) {
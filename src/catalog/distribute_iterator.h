@@ -33,6 +33,32 @@ namespace catalog {
 
 using Tables = std::map<uint32_t, std::shared_ptr<::openmldb::storage::Table>>;
 
+// Traverse the remote partitions of a table concurrently with async requests, at most `concurrency` of
+// them in flight. Every partition keeps at most `depth` pages fetched ahead and the pages of one partition
+// are returned in order, so the caller can walk the partitions in pid order just like the sequential traverse.
+class TraversePrefetcher {
+ public:
+    // by_pk: the next page starts after the last pk of the previous page, which is what the window
+    // iterator needs. otherwise it goes on from the last pk and ts of the previous page
+    TraversePrefetcher(uint32_t tid, const std::string& index_name, bool by_pk,
+            const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+            uint32_t depth, uint32_t concurrency);
+    // cancel the requests in flight without waiting for them, their callbacks keep the state alive
+    ~TraversePrefetcher();
+
+    TraversePrefetcher(const TraversePrefetcher&) = delete;
+    TraversePrefetcher& operator=(const TraversePrefetcher&) = delete;
+
+    // block until the next page of pid is fetched. return null if there is no more page
+    std::shared_ptr<::openmldb::base::TraverseKvIterator> NextPage(uint32_t pid);
+
+ private:
+    struct Context;
+    class Callback;
+
+    std::shared_ptr<Context> ctx_;
+};
+
 class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hybridse::codec::Row> {
  public:
     FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
@@ -52,6 +78,7 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
  private:
     bool NextFromLocal();
     bool NextFromRemote();
+    bool NextFromPrefetcher();
     void Reset();
     void EndLocal();
 
@@ -68,6 +95,8 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
     std::string last_pk_;
     ::hybridse::codec::Row value_;
     std::vector<std::shared_ptr<::google::protobuf::Message>> response_vec_;
+    // non-null only if the remote pages are prefetched
+    std::unique_ptr<TraversePrefetcher> prefetcher_;
 };
 
 class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
@@ -145,6 +174,10 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
 
     ItStat SeekToFirstRemote() const;
 
+    // move kv_it_ to the first prefetched page from the partition `iter` on
+    void NextFromPrefetcher(
+            std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>>::const_iterator iter);
+
  private:
     const uint32_t tid_;
     const uint32_t pid_num_;
@@ -160,6 +193,8 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
     KV_IT kv_it_;
     // underlaying data pointed by `kv_it_`
     std::vector<std::shared_ptr<::google::protobuf::Message>> response_vec_;
+    // non-null only if the remote pages are prefetched from SeekToFirst
+    std::unique_ptr<TraversePrefetcher> prefetcher_;
 };
 
 }  // namespace catalog
@@ -16,6 +16,7 @@
 
 #include "catalog/distribute_iterator.h"
 
+#include <set>
 #include <string>
 #include <vector>
 #include <utility>
@@ -32,6 +33,7 @@
 
 DECLARE_string(db_root_path);
 DECLARE_uint32(traverse_cnt_limit);
+DECLARE_uint32(traverse_prefetch_depth);
 
 namespace openmldb {
 namespace catalog {
@@ -362,6 +364,82 @@ TEST_F(DistributeIteratorTest, WindowIterator) {
     ASSERT_EQ(count, 10);
 }
 
+TEST_F(DistributeIteratorTest, TraversePrefetch) {
+    uint32_t old_limit = FLAGS_traverse_cnt_limit;
+    uint32_t old_depth = FLAGS_traverse_prefetch_depth;
+    FLAGS_traverse_cnt_limit = 7;
+    FLAGS_traverse_prefetch_depth = 2;
+    uint32_t tid = 3;
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    auto tables = std::make_shared<Tables>();
+    auto table1 = CreateTable(tid, 0);
+    auto table2 = CreateTable(tid, 2);
+    tables->emplace(0, table1);
+    tables->emplace(2, table2);
+    std::vector<std::string> endpoints = {"127.0.0.1:9230", "127.0.0.1:9231"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    brpc::Server tablet2;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[1], &tablet2));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    auto client2 = std::make_shared<openmldb::client::TabletClient>(endpoints[1], endpoints[1]);
+    ASSERT_EQ(client2->Init(), 0);
+    std::vector<::openmldb::api::TableMeta> metas = {CreateTableMeta(tid, 1), CreateTableMeta(tid, 3)};
+    ASSERT_TRUE(client1->CreateTable(metas[0]));
+    ASSERT_TRUE(client2->CreateTable(metas[1]));
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients = {{1, client1}, {3, client2}};
+    for (int i = 0; i < 20; i++) {
+        std::string key = "card" + std::to_string(i);
+        uint32_t pid = static_cast<uint32_t>(::openmldb::base::hash64(key)) % 4;
+        if (pid % 2 == 0) {
+            PutKey(key, (*tables)[pid]);
+        } else {
+            PutKey(key, metas[pid == 1 ? 0 : 1], tablet_clients[pid]);
+        }
+    }
+    FullTableIterator it(tid, tables, tablet_clients);
+    it.SeekToFirst();
+    int count = 0;
+    while (it.Valid()) {
+        count++;
+        it.Next();
+    }
+    ASSERT_EQ(count, 200);
+    // the iterator can be rewound while the pages are being fetched
+    it.SeekToFirst();
+    ASSERT_TRUE(it.Valid());
+    it.SeekToFirst();
+    count = 0;
+    while (it.Valid()) {
+        count++;
+        it.Next();
+    }
+    ASSERT_EQ(count, 200);
+
+    DistributeWindowIterator w_it(tid, 4, tables, 0, "card", tablet_clients);
+    w_it.SeekToFirst();
+    count = 0;
+    std::set<std::string> keys;
+    while (w_it.Valid()) {
+        keys.insert(w_it.GetKey().ToString());
+        auto row_it = w_it.GetValue();
+        row_it->SeekToFirst();
+        int row_cnt = 0;
+        while (row_it->Valid()) {
+            row_cnt++;
+            row_it->Next();
+        }
+        ASSERT_EQ(row_cnt, 10);
+        count++;
+        w_it.Next();
+    }
+    ASSERT_EQ(count, 20);
+    ASSERT_EQ(keys.size(), 20u);
+    FLAGS_traverse_cnt_limit = old_limit;
+    FLAGS_traverse_prefetch_depth = old_depth;
+}
+
 TEST_F(DistributeIteratorTest, RemoteIterator) {
     uint32_t old_limit = FLAGS_traverse_cnt_limit;
     FLAGS_traverse_cnt_limit = 7;
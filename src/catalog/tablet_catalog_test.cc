@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "base/fe_status.h"
+#include "codec/distinct_values.h"
 #include "codec/fe_row_codec.h"
 #include "codec/schema_codec.h"
 #include "gtest/gtest.h"
@@ -216,6 +217,70 @@ TestArgs PrepareAggTable(const std::string &tname, int num_pk, uint64_t num_ts,
     return args;
 }
 
+// the buckets of distinct_count(col2), a bucket of more than max_exact values is overflowed
+TestArgs PrepareDistinctAggTable(const std::string &tname, int num_pk, uint64_t num_ts, int bucket_size,
+                                 uint32_t max_exact) {
+    TestArgs args;
+    ::openmldb::api::TableMeta meta;
+    meta.set_name(tname);
+    meta.set_db("aggr_db");
+    meta.set_tid(2);
+    meta.set_pid(0);
+    meta.set_seg_cnt(8);
+    meta.add_table_partition();
+    meta.set_mode(::openmldb::api::TableMode::kTableLeader);
+
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "key", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_start", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_end", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "num_rows", openmldb::type::DataType::kInt);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "agg_val", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "binlog_offset", openmldb::type::DataType::kBigInt);
+    SchemaCodec::SetIndex(meta.add_column_key(), "index0", "key", "ts_start", ::openmldb::type::kAbsoluteTime, 0, 0);
+
+    ::openmldb::storage::MemTable *table = new ::openmldb::storage::MemTable(meta);
+    table->Init();
+    ::hybridse::vm::Schema fe_schema;
+    schema::SchemaAdapter::ConvertSchema(meta.column_desc(), &fe_schema);
+    ::hybridse::codec::RowBuilder rb(fe_schema);
+    for (int i = 0; i < num_pk; i++) {
+        int count = 0;
+        uint64_t ts_start = 0;
+        ::hybridse::codec::DistinctValues vals(max_exact);
+        for (uint64_t ts = 1; ts <= num_ts; ts++) {
+            int64_t val = ts;
+            vals.Add(reinterpret_cast<const char *>(&val), sizeof(int64_t));
+            count++;
+
+            if (count % bucket_size == 0) {
+                std::string agg_val;
+                vals.Encode(&agg_val);
+                std::string value;
+                std::string pk = "pk" + std::to_string(i);
+                uint32_t size = rb.CalTotalLength(pk.size() + agg_val.size());
+                value.resize(size);
+                rb.SetBuffer(reinterpret_cast<int8_t *>(&(value[0])), size);
+                rb.AppendString(pk.c_str(), pk.size());
+                rb.AppendTimestamp(ts_start);
+                rb.AppendTimestamp(ts);
+                rb.AppendInt32(count);
+                rb.AppendString(agg_val.c_str(), agg_val.size());
+                rb.AppendInt64(i * num_ts + ts);
+                table->Put(pk, ts_start, value.c_str(), value.size());
+
+                ts_start = ts + 1;
+                count = 0;
+                vals.Clear();
+            }
+        }
+    }
+
+    auto mtable = std::shared_ptr<::openmldb::storage::MemTable>(table);
+    args.tables.push_back(mtable);
+    args.meta.push_back(meta);
+    return args;
+}
+
 TestArgs PrepareMultiPartitionTable(const std::string &tname, int partition_num) {
     TestArgs args;
     ::openmldb::api::TableMeta meta;
@@ -1229,6 +1294,43 @@ TEST_F(TabletCatalogTest, long_window_empty) {
     }
 }
 
+TEST_F(TabletCatalogTest, long_window_distinct_count_overflow_test) {
+    int num_pk = 2, num_ts = 9, bucket_size = 2;
+    TestArgs args = PrepareTable("t1", num_pk, num_ts);
+    ::hybridse::codec::Row request_row(::hybridse::base::RefCountedSlice::Create(args.row.c_str(), args.row.size()));
+    // the buckets of exact values are merged, the overflowed ones are counted from the base rows
+    for (uint32_t max_exact : {0u, 1u}) {
+        std::shared_ptr<TabletCatalog> catalog(new TabletCatalog());
+        ASSERT_TRUE(catalog->Init());
+        ASSERT_TRUE(catalog->AddTable(args.meta[0], args.tables[0]));
+        TestArgs args2 = PrepareDistinctAggTable("aggr_t1", num_pk, num_ts, bucket_size, max_exact);
+        ASSERT_TRUE(catalog->AddTable(args2.meta[0], args2.tables[0]));
+        ::hybridse::vm::AggrTableInfo info1 = {"aggr_t1", "aggr_db", "db1", "t1", "distinct_count",
+                                               "col2", "col1", "col2", "2", ""};
+        catalog->RefreshAggrTables({info1});
+
+        ::hybridse::vm::Engine engine(catalog);
+        auto options = std::make_shared<std::unordered_map<std::string, std::string>>();
+        (*options)[::hybridse::vm::LONG_WINDOWS] = "w1";
+        ::hybridse::vm::RequestRunSession session;
+        session.SetOptions(options);
+        ::hybridse::base::Status status;
+        std::string sql =
+            "SELECT col1, distinct_count(col2) OVER w1 FROM t1 "
+            "WINDOW w1 AS (PARTITION BY col1 ORDER BY col2 ROWS_RANGE BETWEEN 6 PRECEDING AND CURRENT ROW);";
+        engine.Get(sql, "db1", session, status);
+        ASSERT_EQ(::hybridse::common::kOk, status.code) << status.msg;
+        hybridse::codec::Row output;
+        ASSERT_EQ(0, session.Run(request_row, &output));
+        ::hybridse::codec::RowView rv(session.GetSchema());
+        rv.Reset(output.buf(), output.size());
+        int64_t val = 0;
+        ASSERT_EQ(0, rv.GetInt64(1, &val));
+        // col2 of [ts - 6, ts]
+        ASSERT_EQ(7, val) << "max_exact " << max_exact;
+    }
+}
+
 }  // namespace catalog
 }  // namespace openmldb
 
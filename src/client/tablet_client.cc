@@ -97,6 +97,53 @@ bool TabletClient::Query(const std::string& db, const std::string& sql,
     return true;
 }
 
+bool TabletClient::AsyncQuery(const std::string& db, const std::string& sql,
+                              const std::vector<openmldb::type::DataType>& parameter_types,
+                              const std::string& parameter_row, bool is_debug,
+                              openmldb::RpcCallback<openmldb::api::QueryResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    ::openmldb::api::QueryRequest request;
+    request.set_sql(sql);
+    request.set_db(db);
+    request.set_is_batch(true);
+    request.set_is_debug(is_debug);
+    request.set_parameter_row_size(parameter_row.size());
+    request.set_parameter_row_slices(1);
+    for (auto& type : parameter_types) {
+        request.add_parameter_types(type);
+    }
+    auto& io_buf = callback->GetController()->request_attachment();
+    if (!codec::EncodeRpcRow(reinterpret_cast<const int8_t*>(parameter_row.data()), parameter_row.size(), &io_buf)) {
+        LOG(WARNING) << "Encode parameter buffer failed";
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Query, callback->GetController().get(), &request,
+                               callback->GetResponse().get(), callback);
+}
+
+bool TabletClient::AsyncQuery(const std::string& db, const std::string& sql, const std::string& row, bool is_debug,
+                              openmldb::RpcCallback<openmldb::api::QueryResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    ::openmldb::api::QueryRequest request;
+    request.set_sql(sql);
+    request.set_db(db);
+    request.set_is_batch(false);
+    request.set_is_debug(is_debug);
+    request.set_row_size(row.size());
+    request.set_row_slices(1);
+    auto& io_buf = callback->GetController()->request_attachment();
+    if (!codec::EncodeRpcRow(reinterpret_cast<const int8_t*>(row.data()), row.size(), &io_buf)) {
+        LOG(WARNING) << "Encode row buffer failed";
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Query, callback->GetController().get(), &request,
+                               callback->GetResponse().get(), callback);
+}
+
 /**
  * Utility function to encode row batch data into rpc attachment buffer
  */
@@ -263,6 +310,57 @@ bool TabletClient::Put(uint32_t tid, uint32_t pid, uint64_t time, const std::str
     return false;
 }
 
+bool TabletClient::PutBatch(const ::openmldb::api::PutBatchRequest& request, std::string* msg, bool* unsupported) {
+    ::openmldb::api::PutBatchResponse response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    cntl.set_max_retry(1);
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, &cntl, &request, &response);
+    if (ok && response.code() == 0) {
+        return true;
+    }
+    if (unsupported != nullptr) {
+        // the tablet of an old version has no PutBatch
+        *unsupported = (!ok && (cntl.ErrorCode() == brpc::ENOMETHOD || cntl.ErrorCode() == brpc::ENOSERVICE)) ||
+                       (ok && response.code() == ::openmldb::base::ReturnCode::kOperatorNotSupport);
+    }
+    if (msg != nullptr) {
+        *msg = ok ? response.msg() : cntl.ErrorText();
+    }
+    LOG(WARNING) << "fail to send put batch request for " << response.msg() << " and error code " << response.code()
+                 << ". success/total " << response.put_cnt() << "/" << request.rows_size();
+    return false;
+}
+
+bool TabletClient::AsyncPut(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
+                            const std::vector<std::pair<std::string, uint32_t>>& dimensions,
+                            openmldb::RpcCallback<openmldb::api::PutResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    ::openmldb::api::PutRequest request;
+    request.set_time(time);
+    request.set_value(value);
+    request.set_tid(tid);
+    request.set_pid(pid);
+    for (size_t i = 0; i < dimensions.size(); i++) {
+        ::openmldb::api::Dimension* d = request.add_dimensions();
+        d->set_key(dimensions[i].first);
+        d->set_idx(dimensions[i].second);
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Put, callback->GetController().get(), &request,
+                               callback->GetResponse().get(), callback);
+}
+
+bool TabletClient::AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::Put(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, const std::string& value) {
     ::openmldb::api::PutRequest request;
     auto dim = request.add_dimensions();
@@ -844,6 +942,22 @@ bool TabletClient::Delete(uint32_t tid, uint32_t pid, const std::string& pk, con
     return true;
 }
 
+bool TabletClient::AsyncDelete(uint32_t tid, uint32_t pid, const std::string& pk, const std::string& idx_name,
+                               openmldb::RpcCallback<openmldb::api::GeneralResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    ::openmldb::api::DeleteRequest request;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    request.set_key(pk);
+    if (!idx_name.empty()) {
+        request.set_idx_name(idx_name);
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Delete, callback->GetController().get(), &request,
+                               callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::ConnectZK() {
     ::openmldb::api::ConnectZKRequest request;
     ::openmldb::api::GeneralResponse response;
@@ -905,6 +1019,15 @@ std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint3
     return std::make_shared<openmldb::base::TraverseKvIterator>(response);
 }
 
+bool TabletClient::AsyncTraverse(const ::openmldb::api::TraverseRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Traverse, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::SetMode(bool mode) {
     ::openmldb::api::SetModeRequest request;
     ::openmldb::api::GeneralResponse response;
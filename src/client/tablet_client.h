@@ -72,6 +72,14 @@ class TabletClient : public Client {
     bool Query(const std::string& db, const std::string& sql, const std::string& row, brpc::Controller* cntl,
                ::openmldb::api::QueryResponse* response, const bool is_debug = false);
 
+    // the async calls return false only if the request is not sent, then the callback will never run
+    bool AsyncQuery(const std::string& db, const std::string& sql,
+                    const std::vector<openmldb::type::DataType>& parameter_types, const std::string& parameter_row,
+                    bool is_debug, openmldb::RpcCallback<openmldb::api::QueryResponse>* callback);
+
+    bool AsyncQuery(const std::string& db, const std::string& sql, const std::string& row, bool is_debug,
+                    openmldb::RpcCallback<openmldb::api::QueryResponse>* callback);
+
     bool SQLBatchRequestQuery(const std::string& db, const std::string& sql,
                               std::shared_ptr<::openmldb::sdk::SQLRequestRowBatch>, brpc::Controller* cntl,
                               ::openmldb::api::SQLBatchRequestQueryResponse* response, const bool is_debug = false);
@@ -81,6 +89,16 @@ class TabletClient : public Client {
     bool Put(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
              const std::vector<std::pair<std::string, uint32_t>>& dimensions);
 
+    // unsupported is set if the tablet does not support PutBatch, the rows have to be put one by one
+    bool PutBatch(const ::openmldb::api::PutBatchRequest& request, std::string* msg, bool* unsupported = nullptr);
+
+    bool AsyncPut(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
+                  const std::vector<std::pair<std::string, uint32_t>>& dimensions,
+                  openmldb::RpcCallback<openmldb::api::PutResponse>* callback);
+
+    bool AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                       openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback);
+
     bool Get(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, std::string& value,  // NOLINT
              uint64_t& ts,                                                                          // NOLINT
              std::string& msg);                        ;                                             // NOLINT
@@ -93,6 +111,9 @@ class TabletClient : public Client {
     bool Delete(uint32_t tid, uint32_t pid, const std::string& pk, const std::string& idx_name,
                 std::string& msg);  // NOLINT
 
+    bool AsyncDelete(uint32_t tid, uint32_t pid, const std::string& pk, const std::string& idx_name,
+                     openmldb::RpcCallback<openmldb::api::GeneralResponse>* callback);
+
     bool Count(uint32_t tid, uint32_t pid, const std::string& pk, const std::string& idx_name, bool filter_expired_data,
                uint64_t& value, std::string& msg);  // NOLINT
 
@@ -193,6 +214,9 @@ class TabletClient : public Client {
             const std::string& idx_name, const std::string& pk, uint64_t ts,
             uint32_t limit, bool skip_current_pk, uint32_t& count);  // NOLINT
 
+    bool AsyncTraverse(const ::openmldb::api::TraverseRequest& request,
+                       openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback);
+
     bool SetMode(bool mode);
 
     bool DeleteIndex(uint32_t tid, uint32_t pid, const std::string& idx_name, std::string* msg);
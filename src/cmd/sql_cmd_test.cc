@@ -433,6 +433,65 @@ TEST_F(SqlCmdTest, LoadData) {
     unlink(file_name.c_str());
 }
 
+TEST_F(SqlCmdTest, LoadDataMultiThread) {
+    sr = standalone_cli.sr;
+    cs = standalone_cli.cs;
+    HandleSQL("create database test1;");
+    HandleSQL("use test1;");
+    std::string create_sql = "create table trans (c1 string, c2 int);";
+    HandleSQL(create_sql);
+    std::string file_name = "./myfile_multi_thread.csv";
+    std::ofstream ofile;
+    ofile.open(file_name);
+    ofile << "c1,c2" << std::endl;
+    // more than one chunk of put_batch_max_rows
+    for (int i = 0; i < 2500; i++) {
+        ofile << "aa" << i % 10 << "," << i << std::endl;
+    }
+    ofile.close();
+    hybridse::sdk::Status status;
+    sr->ExecuteSQL("LOAD DATA INFILE '" + file_name + "' INTO TABLE trans options(thread=4);", &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    auto result = sr->ExecuteSQL("select * from trans;", &status);
+    ASSERT_TRUE(status.IsOK());
+    ASSERT_EQ(2500, result->Size());
+
+    // a bad line fails the load
+    ofile.open(file_name);
+    ofile << "c1,c2" << std::endl;
+    ofile << "aa,1" << std::endl;
+    ofile << "aa,bb" << std::endl;
+    ofile.close();
+    sr->ExecuteSQL("LOAD DATA INFILE '" + file_name + "' INTO TABLE trans options(thread=2);", &status);
+    ASSERT_FALSE(status.IsOK());
+    ASSERT_NE(std::string::npos, status.msg.find("0 rows have been loaded")) << status.msg;
+    ASSERT_NE(std::string::npos, status.msg.find("lines 2-3")) << status.msg;
+    sr->ExecuteSQL("LOAD DATA INFILE '" + file_name + "' INTO TABLE trans options(thread=0);", &status);
+    ASSERT_FALSE(status.IsOK());
+
+    // only the rows of the chunks put are counted, and the failed chunk is reported
+    ofile.open(file_name);
+    ofile << "c1,c2" << std::endl;
+    for (int i = 0; i < 1000; i++) {
+        ofile << "bb" << i % 10 << "," << i << std::endl;
+    }
+    ofile << "bb,cc" << std::endl;
+    for (int i = 0; i < 10; i++) {
+        ofile << "bb" << i % 10 << "," << i << std::endl;
+    }
+    ofile.close();
+    sr->ExecuteSQL("LOAD DATA INFILE '" + file_name + "' INTO TABLE trans options(thread=1);", &status);
+    ASSERT_FALSE(status.IsOK());
+    ASSERT_NE(std::string::npos, status.msg.find(", 1000 rows have been loaded")) << status.msg;
+    ASSERT_NE(std::string::npos, status.msg.find("lines 1002-1012")) << status.msg;
+    result = sr->ExecuteSQL("select * from trans;", &status);
+    ASSERT_TRUE(status.IsOK());
+    ASSERT_EQ(3500, result->Size());
+    HandleSQL("drop table trans;");
+    HandleSQL("drop database test1;");
+    unlink(file_name.c_str());
+}
+
 TEST_P(DBSDKTest, Deploy) {
     auto cli = GetParam();
     cs = cli->cs;
@@ -52,6 +52,8 @@ class RowProject {
 
     uint32_t GetMaxIdx() { return max_idx_; }
 
+    const Schema& GetOutputSchema() const { return output_schema_; }
+
  private:
     const ProjectList& plist_;
     Schema output_schema_;
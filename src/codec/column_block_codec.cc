@@ -0,0 +1,357 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/column_block_codec.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/glog_wrapper.h"
+
+namespace openmldb {
+namespace codec {
+
+static constexpr uint32_t BLOCK_HEADER_LENGTH = 8;
+
+static uint32_t GetFixedSize(::openmldb::type::DataType type) {
+    switch (type) {
+        case ::openmldb::type::kBool:
+            return sizeof(bool);
+        case ::openmldb::type::kSmallInt:
+            return sizeof(int16_t);
+        case ::openmldb::type::kInt:
+        case ::openmldb::type::kDate:
+            return sizeof(int32_t);
+        case ::openmldb::type::kFloat:
+            return sizeof(float);
+        case ::openmldb::type::kBigInt:
+        case ::openmldb::type::kTimestamp:
+            return sizeof(int64_t);
+        case ::openmldb::type::kDouble:
+            return sizeof(double);
+        default:
+            return 0;
+    }
+}
+
+static inline bool IsStringType(::openmldb::type::DataType type) {
+    return type == ::openmldb::type::kVarchar || type == ::openmldb::type::kString;
+}
+
+template <typename T>
+static inline void AppendFixed(T val, std::string* buf) {
+    buf->append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+template <typename T>
+static inline T ReadFixed(const char* ptr) {
+    T val;
+    memcpy(&val, ptr, sizeof(T));
+    return val;
+}
+
+ColumnBlockEncoder::ColumnBlockEncoder(const Schema& schema) : row_view_(schema), columns_(), count_(0) {
+    for (const auto& column : schema) {
+        columns_.push_back({column.data_type(), "", "", ""});
+    }
+}
+
+bool ColumnBlockEncoder::Append(const int8_t* row, uint32_t size) {
+    if (!row_view_.Reset(row, size)) {
+        PDLOG(WARNING, "fail to reset row with size %u", size);
+        return false;
+    }
+    uint32_t bit = count_ % 8;
+    for (uint32_t idx = 0; idx < columns_.size(); idx++) {
+        Column& column = columns_[idx];
+        if (bit == 0) {
+            column.null_bitmap.push_back(0);
+        }
+        if (row_view_.IsNULL(idx)) {
+            column.null_bitmap.back() |= static_cast<char>(1 << bit);
+            continue;
+        }
+        int32_t ret = 0;
+        switch (column.type) {
+            case ::openmldb::type::kBool: {
+                bool val = false;
+                ret = row_view_.GetBool(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kSmallInt: {
+                int16_t val = 0;
+                ret = row_view_.GetInt16(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kInt: {
+                int32_t val = 0;
+                ret = row_view_.GetInt32(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kDate: {
+                int32_t val = 0;
+                ret = row_view_.GetDate(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kFloat: {
+                float val = 0;
+                ret = row_view_.GetFloat(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kBigInt: {
+                int64_t val = 0;
+                ret = row_view_.GetInt64(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kTimestamp: {
+                int64_t val = 0;
+                ret = row_view_.GetTimestamp(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kDouble: {
+                double val = 0;
+                ret = row_view_.GetDouble(idx, &val);
+                AppendFixed(val, &column.data);
+                break;
+            }
+            case ::openmldb::type::kVarchar:
+            case ::openmldb::type::kString: {
+                char* val = nullptr;
+                uint32_t length = 0;
+                ret = row_view_.GetString(idx, &val, &length);
+                if (ret == 0) {
+                    AppendFixed(length, &column.lengths);
+                    column.data.append(val, length);
+                }
+                break;
+            }
+            default:
+                ret = -1;
+        }
+        if (ret != 0) {
+            PDLOG(WARNING, "fail to get value of column %u", idx);
+            return false;
+        }
+    }
+    count_++;
+    return true;
+}
+
+void ColumnBlockEncoder::Encode(std::string* buf) {
+    AppendFixed(count_, buf);
+    AppendFixed(static_cast<uint32_t>(columns_.size()), buf);
+    for (const auto& column : columns_) {
+        buf->push_back(static_cast<char>(column.type));
+    }
+    for (auto& column : columns_) {
+        buf->append(column.null_bitmap);
+        AppendFixed(static_cast<uint32_t>(column.lengths.size() + column.data.size()), buf);
+        buf->append(column.lengths);
+        buf->append(column.data);
+        column.null_bitmap.clear();
+        column.lengths.clear();
+        column.data.clear();
+    }
+    count_ = 0;
+}
+
+bool ColumnBlockDecoder::Init(const char* block, uint32_t size) {
+    count_ = 0;
+    next_row_ = 0;
+    builder_.reset();
+    schema_.Clear();
+    starts_.clear();
+    cursors_.clear();
+    if (block == nullptr || size < BLOCK_HEADER_LENGTH) {
+        return false;
+    }
+    uint32_t row_cnt = ReadFixed<uint32_t>(block);
+    uint32_t column_cnt = ReadFixed<uint32_t>(block + 4);
+    uint32_t offset = BLOCK_HEADER_LENGTH;
+    if (column_cnt > size - offset) {
+        PDLOG(WARNING, "invalid column count %u", column_cnt);
+        return false;
+    }
+    for (uint32_t idx = 0; idx < column_cnt; idx++) {
+        int type = static_cast<uint8_t>(block[offset + idx]);
+        if (!::openmldb::type::DataType_IsValid(type) ||
+                (GetFixedSize(static_cast<::openmldb::type::DataType>(type)) == 0 &&
+                 !IsStringType(static_cast<::openmldb::type::DataType>(type)))) {
+            PDLOG(WARNING, "invalid data type %d of column %u", type, idx);
+            schema_.Clear();
+            return false;
+        }
+        auto* column = schema_.Add();
+        column->set_name(std::to_string(idx));
+        column->set_data_type(static_cast<::openmldb::type::DataType>(type));
+    }
+    offset += column_cnt;
+    uint64_t bitmap_size = (static_cast<uint64_t>(row_cnt) + 7) / 8;
+    starts_.resize(column_cnt);
+    for (uint32_t idx = 0; idx < column_cnt; idx++) {
+        if (offset + bitmap_size + 4 > size) {
+            PDLOG(WARNING, "block is truncated at column %u", idx);
+            return false;
+        }
+        Cursor& cursor = starts_[idx];
+        cursor.null_bitmap = block + offset;
+        offset += bitmap_size;
+        uint32_t data_size = ReadFixed<uint32_t>(block + offset);
+        offset += 4;
+        if (offset + static_cast<uint64_t>(data_size) > size) {
+            PDLOG(WARNING, "block is truncated at column %u", idx);
+            return false;
+        }
+        uint64_t not_null_cnt = 0;
+        for (uint32_t row = 0; row < row_cnt; row++) {
+            if (!(cursor.null_bitmap[row / 8] & (1 << (row % 8)))) {
+                not_null_cnt++;
+            }
+        }
+        ::openmldb::type::DataType type = schema_.Get(idx).data_type();
+        uint64_t expect_size = IsStringType(type) ? not_null_cnt * 4 : not_null_cnt * GetFixedSize(type);
+        if ((IsStringType(type) && expect_size > data_size) || (!IsStringType(type) && expect_size != data_size)) {
+            PDLOG(WARNING, "invalid data size %u of column %u", data_size, idx);
+            return false;
+        }
+        if (IsStringType(type)) {
+            cursor.lengths = block + offset;
+            cursor.data = block + offset + expect_size;
+        } else {
+            cursor.lengths = nullptr;
+            cursor.data = block + offset;
+        }
+        offset += data_size;
+        cursor.end = block + offset;
+    }
+    builder_.reset(new RowBuilder(schema_));
+    cursors_ = starts_;
+    count_ = row_cnt;
+    return true;
+}
+
+void ColumnBlockDecoder::Reset() {
+    cursors_ = starts_;
+    next_row_ = 0;
+}
+
+bool ColumnBlockDecoder::Next(std::string* row_buf) {
+    if (row_buf == nullptr || !builder_ || next_row_ >= count_) {
+        return false;
+    }
+    uint32_t row = next_row_;
+    uint32_t column_cnt = cursors_.size();
+    uint64_t str_size = 0;
+    for (uint32_t idx = 0; idx < column_cnt; idx++) {
+        const Cursor& cursor = cursors_[idx];
+        if (cursor.lengths != nullptr && !(cursor.null_bitmap[row / 8] & (1 << (row % 8)))) {
+            str_size += ReadFixed<uint32_t>(cursor.lengths);
+        }
+    }
+    uint32_t total_size = str_size > UINT32_MAX ? 0 : builder_->CalTotalLength(str_size);
+    if (total_size == 0) {
+        PDLOG(WARNING, "invalid string size %lu of row %u", str_size, row);
+        return false;
+    }
+    // the slots of the null values are left zero, like a row built by RowBuilder on a new buffer
+    row_buf->assign(total_size, '\0');
+    builder_->SetBuffer(reinterpret_cast<int8_t*>(&(*row_buf)[0]), total_size);
+    for (uint32_t idx = 0; idx < column_cnt; idx++) {
+        Cursor& cursor = cursors_[idx];
+        if (cursor.null_bitmap[row / 8] & (1 << (row % 8))) {
+            builder_->AppendNULL();
+            continue;
+        }
+        bool ok = false;
+        switch (schema_.Get(idx).data_type()) {
+            case ::openmldb::type::kBool:
+                ok = builder_->AppendBool(ReadFixed<bool>(cursor.data));
+                break;
+            case ::openmldb::type::kSmallInt:
+                ok = builder_->AppendInt16(ReadFixed<int16_t>(cursor.data));
+                break;
+            case ::openmldb::type::kInt:
+                ok = builder_->AppendInt32(ReadFixed<int32_t>(cursor.data));
+                break;
+            case ::openmldb::type::kDate:
+                ok = builder_->AppendDate(ReadFixed<int32_t>(cursor.data));
+                break;
+            case ::openmldb::type::kFloat:
+                ok = builder_->AppendFloat(ReadFixed<float>(cursor.data));
+                break;
+            case ::openmldb::type::kBigInt:
+                ok = builder_->AppendInt64(ReadFixed<int64_t>(cursor.data));
+                break;
+            case ::openmldb::type::kTimestamp:
+                ok = builder_->AppendTimestamp(ReadFixed<int64_t>(cursor.data));
+                break;
+            case ::openmldb::type::kDouble:
+                ok = builder_->AppendDouble(ReadFixed<double>(cursor.data));
+                break;
+            default: {
+                uint32_t length = ReadFixed<uint32_t>(cursor.lengths);
+                cursor.lengths += 4;
+                if (length > static_cast<uint64_t>(cursor.end - cursor.data)) {
+                    PDLOG(WARNING, "string of column %u is truncated", idx);
+                    return false;
+                }
+                ok = builder_->AppendString(cursor.data, length);
+                cursor.data += length;
+                break;
+            }
+        }
+        if (!ok) {
+            PDLOG(WARNING, "fail to append column %u of row %u", idx, row);
+            return false;
+        }
+        if (cursor.lengths == nullptr) {
+            cursor.data += GetFixedSize(schema_.Get(idx).data_type());
+        }
+    }
+    next_row_++;
+    return true;
+}
+
+bool DecodeColumnBlock(const char* block, uint32_t size, std::string* rows, uint32_t* count) {
+    if (rows == nullptr || count == nullptr) {
+        return false;
+    }
+    ColumnBlockDecoder decoder;
+    if (!decoder.Init(block, size)) {
+        return false;
+    }
+    std::string row;
+    for (uint32_t i = 0; i < decoder.GetCount(); i++) {
+        if (!decoder.Next(&row)) {
+            return false;
+        }
+        rows->append(row);
+    }
+    *count = decoder.GetCount();
+    return true;
+}
+
+}  // namespace codec
+}  // namespace openmldb
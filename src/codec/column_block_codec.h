@@ -0,0 +1,106 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CODEC_COLUMN_BLOCK_CODEC_H_
+#define SRC_CODEC_COLUMN_BLOCK_CODEC_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "codec/codec.h"
+
+namespace openmldb {
+namespace codec {
+
+// A column block keeps the rows of one schema column by column, so the values of a column sit together
+// and compress much better than the encoded rows. The block is self-described:
+//   | row count(4) | column count(4) | data type(1) * column count | column * column count |
+// and every column is
+//   | null bitmap((row count + 7) / 8) | data size(4) | data |
+// the data of a fixed size column is the values of the not null rows. the data of a string column is
+// the lengths(4) of the not null rows followed by all the string bytes
+class ColumnBlockEncoder {
+ public:
+    explicit ColumnBlockEncoder(const Schema& schema);
+
+    // row must be encoded with the schema of the encoder
+    bool Append(const int8_t* row, uint32_t size);
+
+    uint32_t GetCount() const { return count_; }
+
+    // append the block to buf and reset the encoder
+    void Encode(std::string* buf);
+
+ private:
+    struct Column {
+        ::openmldb::type::DataType type;
+        std::string null_bitmap;
+        std::string lengths;
+        std::string data;
+    };
+
+ private:
+    RowView row_view_;
+    std::vector<Column> columns_;
+    uint32_t count_;
+};
+
+// Decode a column block row by row, so the rows are rebuilt only when they are read.
+// the block is referred to, not copied, and has to outlive the decoder
+class ColumnBlockDecoder {
+ public:
+    ColumnBlockDecoder() : schema_(), builder_(), starts_(), cursors_(), count_(0), next_row_(0) {}
+
+    ColumnBlockDecoder(const ColumnBlockDecoder&) = delete;
+    ColumnBlockDecoder& operator=(const ColumnBlockDecoder&) = delete;
+
+    // check the layout of the block and position at the first row
+    bool Init(const char* block, uint32_t size);
+
+    uint32_t GetCount() const { return count_; }
+
+    // go back to the first row
+    void Reset();
+
+    // encode the next row into row, return false at the end of the block or if the row is invalid
+    bool Next(std::string* row);
+
+ private:
+    struct Cursor {
+        const char* null_bitmap;
+        const char* lengths;
+        const char* data;
+        const char* end;
+    };
+
+ private:
+    Schema schema_;
+    // refers to schema_
+    std::unique_ptr<RowBuilder> builder_;
+    // the cursors at the first row of every column
+    std::vector<Cursor> starts_;
+    std::vector<Cursor> cursors_;
+    uint32_t count_;
+    uint32_t next_row_;
+};
+
+// decode a column block back into the encoded rows, which are appended to rows one by one
+bool DecodeColumnBlock(const char* block, uint32_t size, std::string* rows, uint32_t* count);
+
+}  // namespace codec
+}  // namespace openmldb
+#endif  // SRC_CODEC_COLUMN_BLOCK_CODEC_H_
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/column_block_codec.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace codec {
+
+class ColumnBlockCodecTest : public ::testing::Test {};
+
+static void InitSchema(Schema* schema) {
+    std::vector<::openmldb::type::DataType> types = {
+        ::openmldb::type::kBool,  ::openmldb::type::kSmallInt, ::openmldb::type::kInt,
+        ::openmldb::type::kBigInt, ::openmldb::type::kFloat,   ::openmldb::type::kDouble,
+        ::openmldb::type::kDate,  ::openmldb::type::kTimestamp, ::openmldb::type::kString,
+        ::openmldb::type::kVarchar};
+    for (size_t i = 0; i < types.size(); i++) {
+        auto* col = schema->Add();
+        col->set_name("col" + std::to_string(i));
+        col->set_data_type(types[i]);
+    }
+}
+
+static std::string EncodeTestRow(const Schema& schema, int32_t i) {
+    std::string str = "value" + std::to_string(i);
+    std::string empty;
+    RowBuilder builder(schema);
+    uint32_t size = builder.CalTotalLength(str.size());
+    std::string row(size, '\0');
+    builder.SetBuffer(reinterpret_cast<int8_t*>(&row[0]), size);
+    builder.AppendBool(i % 2 == 0);
+    builder.AppendInt16(static_cast<int16_t>(i));
+    i % 3 == 0 ? builder.AppendNULL() : builder.AppendInt32(i * 10);
+    builder.AppendInt64(i * 100L);
+    builder.AppendFloat(i * 1.5f);
+    builder.AppendDouble(i * 2.5);
+    builder.AppendDate(2022, 1, i % 28 + 1);
+    builder.AppendTimestamp(1650000000000L + i);
+    builder.AppendString(str.c_str(), str.size());
+    i % 5 == 0 ? builder.AppendNULL() : builder.AppendString(empty.c_str(), 0);
+    return row;
+}
+
+TEST_F(ColumnBlockCodecTest, EncodeDecode) {
+    Schema schema;
+    InitSchema(&schema);
+    ColumnBlockEncoder encoder(schema);
+    std::string rows;
+    for (int32_t i = 0; i < 21; i++) {
+        std::string row = EncodeTestRow(schema, i);
+        ASSERT_TRUE(encoder.Append(reinterpret_cast<const int8_t*>(row.data()), row.size()));
+        rows.append(row);
+    }
+    ASSERT_EQ(21u, encoder.GetCount());
+    std::string block;
+    encoder.Encode(&block);
+    ASSERT_EQ(0u, encoder.GetCount());
+
+    std::string decoded;
+    uint32_t count = 0;
+    ASSERT_TRUE(DecodeColumnBlock(block.data(), block.size(), &decoded, &count));
+    ASSERT_EQ(21u, count);
+    ASSERT_EQ(rows, decoded);
+
+    // the encoder can be reused after Encode
+    std::string row = EncodeTestRow(schema, 7);
+    ASSERT_TRUE(encoder.Append(reinterpret_cast<const int8_t*>(row.data()), row.size()));
+    block.clear();
+    encoder.Encode(&block);
+    decoded.clear();
+    ASSERT_TRUE(DecodeColumnBlock(block.data(), block.size(), &decoded, &count));
+    ASSERT_EQ(1u, count);
+    ASSERT_EQ(row, decoded);
+}
+
+TEST_F(ColumnBlockCodecTest, Decoder) {
+    Schema schema;
+    InitSchema(&schema);
+    ColumnBlockEncoder encoder(schema);
+    std::vector<std::string> rows;
+    for (int32_t i = 0; i < 9; i++) {
+        rows.push_back(EncodeTestRow(schema, i));
+        ASSERT_TRUE(encoder.Append(reinterpret_cast<const int8_t*>(rows.back().data()), rows.back().size()));
+    }
+    std::string block;
+    encoder.Encode(&block);
+    ColumnBlockDecoder decoder;
+    ASSERT_TRUE(decoder.Init(block.data(), block.size()));
+    ASSERT_EQ(9u, decoder.GetCount());
+    std::string row;
+    for (int round = 0; round < 2; round++) {
+        for (const auto& expect : rows) {
+            ASSERT_TRUE(decoder.Next(&row));
+            ASSERT_EQ(expect, row);
+        }
+        ASSERT_FALSE(decoder.Next(&row));
+        decoder.Reset();
+    }
+    ASSERT_FALSE(decoder.Init(block.data(), 7));
+    ASSERT_EQ(0u, decoder.GetCount());
+    ASSERT_FALSE(decoder.Next(&row));
+}
+
+TEST_F(ColumnBlockCodecTest, Empty) {
+    Schema schema;
+    InitSchema(&schema);
+    ColumnBlockEncoder encoder(schema);
+    std::string block;
+    encoder.Encode(&block);
+    std::string decoded;
+    uint32_t count = 1;
+    ASSERT_TRUE(DecodeColumnBlock(block.data(), block.size(), &decoded, &count));
+    ASSERT_EQ(0u, count);
+    ASSERT_TRUE(decoded.empty());
+}
+
+TEST_F(ColumnBlockCodecTest, Truncated) {
+    Schema schema;
+    InitSchema(&schema);
+    ColumnBlockEncoder encoder(schema);
+    for (int32_t i = 0; i < 5; i++) {
+        std::string row = EncodeTestRow(schema, i);
+        ASSERT_TRUE(encoder.Append(reinterpret_cast<const int8_t*>(row.data()), row.size()));
+    }
+    std::string block;
+    encoder.Encode(&block);
+    std::string decoded;
+    uint32_t count = 0;
+    for (uint32_t size = 0; size < block.size(); size++) {
+        decoded.clear();
+        ASSERT_FALSE(DecodeColumnBlock(block.data(), size, &decoded, &count)) << size;
+    }
+}
+
+}  // namespace codec
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -19,7 +19,25 @@
 namespace openmldb {
 namespace codec {
 
-bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row) {
+// the smaller buffers are copied, one user data block costs more than copying them
+static constexpr size_t kZeroCopyMinSize = 1024;
+
+// return the data at offset if it is in one block of buf, otherwise return nullptr
+static const char* GetContiguousData(const butil::IOBuf& buf, size_t offset, size_t size) {
+    size_t block_offset = 0;
+    for (size_t i = 0; i < buf.backing_block_num(); i++) {
+        butil::StringPiece block = buf.backing_block(i);
+        if (offset < block_offset + block.size()) {
+            size_t pos = offset - block_offset;
+            return pos + size <= block.size() ? block.data() + pos : nullptr;
+        }
+        block_offset += block.size();
+    }
+    return nullptr;
+}
+
+bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row,
+                  bool ref_buf) {
     if (row == nullptr) {
         return false;
     }
@@ -53,12 +71,19 @@ bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t sl
                 row->Append(hybridse::base::RefCountedSlice());
             }
         } else {
-            int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
-            buf.copy_to(slice_buf, slice_size, cur_offset);
+            const char* data = ref_buf ? GetContiguousData(buf, cur_offset, slice_size) : nullptr;
+            hybridse::base::RefCountedSlice slice;
+            if (data != nullptr) {
+                slice = hybridse::base::RefCountedSlice::Create(data, slice_size);
+            } else {
+                int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
+                buf.copy_to(slice_buf, slice_size, cur_offset);
+                slice = hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size);
+            }
             if (i == 0) {
-                *row = hybridse::codec::Row(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                *row = hybridse::codec::Row(slice);
             } else {
-                row->Append(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                row->Append(slice);
             }
         }
         cur_offset = next_offset;
@@ -96,6 +121,47 @@ bool EncodeRpcRow(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* to
     return true;
 }
 
+bool AppendRowSlice(hybridse::codec::Row* row, int32_t pos, butil::IOBuf* buf) {
+    size_t slice_size = row->size(pos);
+    if (slice_size >= kZeroCopyMinSize) {
+        int8_t* slice_buf = row->DetachBuf(pos);
+        if (slice_buf != nullptr) {
+            if (buf->append_user_data(slice_buf, slice_size, free) != 0) {
+                free(slice_buf);
+                LOG(WARNING) << "Append user data of size " << slice_size << " failed";
+                return false;
+            }
+            return true;
+        }
+    }
+    return buf->append(row->buf(pos), slice_size) == 0;
+}
+
+bool EncodeRpcRowZeroCopy(hybridse::codec::Row* row, butil::IOBuf* buf, size_t* total_size) {
+    if (buf == nullptr || row == nullptr) {
+        return false;
+    }
+    *total_size = 0;
+    size_t slice_num = row->GetRowPtrCnt();
+    for (size_t i = 0; i < slice_num; ++i) {
+        size_t slice_size = row->size(i);
+        bool ok;
+        if (row->buf(i) == nullptr || slice_size == 0) {
+            char empty_header[6] = {1, 1, 0, 0, 0, 0};
+            ok = buf->append(empty_header, 6) == 0;
+            *total_size += 6;
+        } else {
+            ok = AppendRowSlice(row, i, buf);
+            *total_size += slice_size;
+        }
+        if (!ok) {
+            LOG(WARNING) << "Append " << i << "th slice of size " << slice_size << " failed";
+            return false;
+        }
+    }
+    return true;
+}
+
 bool EncodeRpcRow(const int8_t* buf, size_t size, butil::IOBuf* io_buf) {
     int code = io_buf->append(buf, size);
     if (code != 0) {
@@ -31,10 +31,20 @@
 namespace openmldb {
 namespace codec {
 
-bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row);
+// if ref_buf is true, a slice which is contiguous in buf is referenced instead of copied,
+// so buf must outlive the row
+bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row,
+                  bool ref_buf = false);
 
 bool EncodeRpcRow(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* total_size);
 
+// same as EncodeRpcRow, but the slice buffers owned only by row are handed over to buf without copy.
+// the slices of row still reference the buffers, which are valid until buf is released
+bool EncodeRpcRowZeroCopy(hybridse::codec::Row* row, butil::IOBuf* buf, size_t* total_size);
+
+// append the pos-th slice of row to buf, the buffer is handed over like EncodeRpcRowZeroCopy
+bool AppendRowSlice(hybridse::codec::Row* row, int32_t pos, butil::IOBuf* buf);
+
 bool EncodeRpcRow(const int8_t* buf, size_t size, butil::IOBuf* io_buf);
 
 }  // namespace codec
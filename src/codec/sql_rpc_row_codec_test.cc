@@ -123,6 +123,59 @@ TEST_F(SqlRpcRowCodecTest, TestMultiSlice) {
     ASSERT_EQ(0, decoded.size(3));
 }
 
+TEST_F(SqlRpcRowCodecTest, TestZeroCopy) {
+    hybridse::codec::Schema schema;
+    InitSchema(&schema);
+    hybridse::codec::RowBuilder builder(schema);
+    std::string str(4000, 'a');
+    size_t buf_size = builder.CalTotalLength(str.size());
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(buf_size));
+    builder.SetBuffer(buf, buf_size);
+    builder.AppendInt32(42);
+    builder.AppendFloat(3.14);
+    builder.AppendString(str.data(), str.size());
+    hybridse::codec::Row row(hybridse::codec::RefCountedSlice::CreateManaged(buf, buf_size));
+
+    butil::IOBuf iobuf;
+    size_t total_size;
+    {
+        // the buffer shared by two rows is copied
+        hybridse::codec::Row copy = row;
+        ASSERT_TRUE(EncodeRpcRowZeroCopy(&row, &iobuf, &total_size));
+        ASSERT_EQ(buf_size, total_size);
+        ASSERT_NE(reinterpret_cast<const char*>(buf), iobuf.backing_block(0).data());
+    }
+    iobuf.clear();
+    ASSERT_TRUE(EncodeRpcRowZeroCopy(&row, &iobuf, &total_size));
+    ASSERT_EQ(buf_size, total_size);
+    ASSERT_EQ(1u, iobuf.backing_block_num());
+    ASSERT_EQ(reinterpret_cast<const char*>(buf), iobuf.backing_block(0).data());
+    // the row still reads the buffer owned by iobuf
+    ASSERT_EQ(buf, row.buf(0));
+
+    hybridse::codec::Row decoded;
+    ASSERT_TRUE(DecodeRpcRow(iobuf, 0, buf_size, 1, &decoded, true));
+    ASSERT_EQ(reinterpret_cast<const char*>(buf), reinterpret_cast<const char*>(decoded.buf(0)));
+    hybridse::codec::RowView row_view(schema);
+    row_view.Reset(decoded.buf(0), decoded.size(0));
+    ASSERT_EQ(42, row_view.GetInt32Unsafe(0));
+    ASSERT_EQ(str, row_view.GetStringUnsafe(2));
+
+    // the slice across blocks is copied
+    butil::IOBuf split;
+    char* head = reinterpret_cast<char*>(malloc(100));
+    memcpy(head, buf, 100);
+    split.append_user_data(head, 100, free);
+    char* tail = reinterpret_cast<char*>(malloc(buf_size - 100));
+    memcpy(tail, buf + 100, buf_size - 100);
+    split.append_user_data(tail, buf_size - 100, free);
+    ASSERT_EQ(2u, split.backing_block_num());
+    ASSERT_TRUE(DecodeRpcRow(split, 0, buf_size, 1, &decoded, true));
+    ASSERT_NE(reinterpret_cast<const char*>(buf), reinterpret_cast<const char*>(decoded.buf(0)));
+    row_view.Reset(decoded.buf(0), decoded.size(0));
+    ASSERT_EQ(str, row_view.GetStringUnsafe(2));
+}
+
 }  // namespace codec
 }  // namespace openmldb
 
@@ -63,6 +63,10 @@ DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
 DEFINE_uint32(gc_deleted_pk_version_delta, 2, "config the gc version delta");
+DEFINE_bool(gc_expiry_index, false, "index the keys of absolute ttl tables by their oldest time for gc");
+DEFINE_uint32(gc_expiry_index_full_scan_round, 12, "scan all the keys every n rounds of ttl gc, 0 to disable");
+DEFINE_uint32(gc_pace_keys, 0, "sleep 1ms every n keys visited by gc, 0 to disable");
+DEFINE_uint32(gc_segment_thread_num, 1, "the number of threads to gc the segments of a table");
 DEFINE_double(mem_release_rate, 5, "specify memory release rate, which should be in 0 ~ 10");
 DEFINE_int32(task_pool_size, 3, "the size of tablet task thread pool");
 DEFINE_int32(io_pool_size, 2, "the size of tablet io task thread pool");
@@ -70,6 +74,10 @@ DEFINE_bool(use_name, false, "enable or disable use server name");
 DEFINE_string(data_dir, "./data", "the path of data dir");
 DEFINE_bool(enable_distsql, false, "enable or disable distribute sql");
 DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when distribute sql circumstance");
+DEFINE_string(jit_object_cache_dir, "", "the dir to cache the compiled sql objects across restarts, disabled if empty");
+DEFINE_uint64(jit_object_cache_max_size_mb, 1024,
+              "the max size of the compiled sql objects cached, the least recently used ones are removed beyond it. "
+              "0 for no limit");
 DEFINE_string(bucket_size, "1d", "the default bucket size in pre-aggr table");
 
 // scan configuration
@@ -80,7 +88,16 @@ DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview")
 // binlog configuration
 DEFINE_int32(binlog_single_file_max_size, 1024 * 4, "the max size of single binlog file");
 DEFINE_int32(binlog_sync_batch_size, 32, "the batch size of sync binlog");
+DEFINE_uint32(binlog_sync_thread_num, 0,
+              "the threads shared by all the replicate nodes, which are posted when the binlog is appended. "
+              "0 means every replicate node has its own sync thread");
+DEFINE_bool(binlog_sync_raw, false,
+            "ship the binlog records to followers as they are in the rpc attachment. "
+            "all the tablets must support it before it is enabled");
+DEFINE_uint32(binlog_sync_batch_byte_size, 1024 * 1024, "the max byte size of one batch if binlog_sync_raw is enabled");
 DEFINE_bool(binlog_notify_on_put, false, "config the sync log to follower strategy");
+DEFINE_bool(binlog_enable_group_commit, false, "enable group commit of binlog for concurrent puts");
+DEFINE_uint32(binlog_group_commit_max_size, 128, "the max entry count of one binlog group commit");
 DEFINE_bool(binlog_enable_crc, false, "enable crc");
 DEFINE_int32(binlog_coffee_time, 1000, "config the coffee time. unit is milliseconds");
 DEFINE_int32(binlog_sync_wait_time, 100, "config the sync log wait time. unit is milliseconds");
@@ -93,6 +110,7 @@ DEFINE_uint32(check_binlog_sync_progress_delta, 100000, "config the delta of che
 DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
 DEFINE_uint32(put_slow_log_threshold, 50000, "config the threshold of put slow log");
+DEFINE_uint32(put_batch_max_rows, 1000, "config the max row count of one put batch request");
 DEFINE_uint32(query_slow_log_threshold, 50000, "config the threshold of query slow log");
 
 // local db config
@@ -106,9 +124,15 @@ DEFINE_int32(request_max_retry, 3, "max retry time when request error");
 DEFINE_int32(request_timeout_ms, 20000,
              "rpc request timeout of misc. unit is milliseconds");
 DEFINE_int32(request_sleep_time, 1000, "the sleep time when request error. unit is milliseconds");
+DEFINE_uint32(deployment_binary_max_inflight, 64,
+              "the max procedure calls in flight for the rows of one binary deployment request of apiserver");
 
 DEFINE_uint32(max_traverse_cnt, 50000, "max traverse iter loop cnt");
 DEFINE_uint32(traverse_cnt_limit, 1000, "limit traverse cnt");
+DEFINE_uint32(traverse_prefetch_depth, 0,
+              "the pages fetched ahead for every remote partition when a distributed table is traversed. "
+              "0 means traverse the partitions one by one");
+DEFINE_uint32(traverse_prefetch_concurrency, 4, "the max concurrent traverse requests of one prefetching iterator");
 DEFINE_string(ssd_root_path, "", "the root ssd path of db");
 DEFINE_string(hdd_root_path, "", "the root hdd path of db");
 
@@ -147,6 +171,13 @@ DEFINE_uint32(skiplist_max_height, 12, "the max height of skiplist");
 DEFINE_uint32(key_entry_max_height, 8, "the max height of key entry");
 DEFINE_uint32(latest_default_skiplist_height, 1, "the default height of skiplist for latest table");
 DEFINE_uint32(absolute_default_skiplist_height, 4, "the default height of skiplist for absolute table");
+DEFINE_bool(enable_datablock_slab, false, "allocate the rows of memory table from per table slabs");
+DEFINE_uint32(datablock_slab_size, 1024 * 1024, "the size of one datablock slab. unit is byte");
+DEFINE_uint32(key_entry_compact_hot_cnt, 0,
+              "freeze the rows after the latest n rows of a key into cold blocks on gc, the keys created "
+              "before it is on stay hot. 0 means disable");
+DEFINE_uint32(key_entry_compact_block_rows, 256, "the row count of one cold block");
+DEFINE_bool(key_entry_compact_compress, false, "compress the cold blocks with snappy");
 DEFINE_uint32(max_col_display_length, 256, "config the max length of column display");
 
 // rocksdb
@@ -156,13 +187,26 @@ DEFINE_uint32(block_cache_mb, 4096,
               "Memory allocated for caching uncompressed block (OS page cache "
               "handles the compressed ones)");
 DEFINE_uint32(write_buffer_mb, 128, "Memtable size");
+DEFINE_uint32(write_buffer_manager_mb, 0,
+              "the total memtable size of all the disk tables, which is charged to the shared block cache. "
+              "0 means no limit");
 DEFINE_uint32(block_cache_shardbits, 8, "Divide block cache into 2^8 shards to avoid cache contention");
 DEFINE_bool(verify_compression, false, "For debug");
+DEFINE_uint32(disk_table_bloom_bits_per_key, 10,
+              "bits per key of the prefix bloom filter of disk tables, the prefix is the index key. 0 means disable");
+DEFINE_bool(disk_table_partition_filters, false,
+            "partition the index and filter blocks of disk tables and cache them in the block cache, "
+            "the top level blocks are pinned");
+DEFINE_double(disk_table_memtable_bloom_ratio, 0.02, "the size ratio of the memtable prefix bloom of disk tables");
+DEFINE_bool(disk_table_statistics, false,
+            "a diagnostic switch to collect the bloom filter and block cache statistics of disk tables, "
+            "which costs cpu on every read and write");
 
 // load table resouce control
-DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
+DEFINE_uint32(load_table_batch, 256, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_uint32(load_table_read_buffer_size, 4 * 1024 * 1024, "the read buffer size of snapshot file when load table");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000,
@@ -126,7 +126,9 @@ Status Writer::EndLog() {
     return s;
 }
 
-Status Writer::AddRecord(const Slice& slice) {
+Status Writer::AddRecord(const Slice& slice) { return AddRecord(slice, true); }
+
+Status Writer::AddRecord(const Slice& slice, bool flush) {
     const char* ptr = slice.data();
     size_t left = slice.size();
 
@@ -172,7 +174,7 @@ Status Writer::AddRecord(const Slice& slice) {
         } else {
             type = kMiddleType;
         }
-        s = EmitPhysicalRecord(type, ptr, fragment_length);
+        s = EmitPhysicalRecord(type, ptr, fragment_length, flush);
         ptr += fragment_length;
         left -= fragment_length;
         begin = false;
@@ -180,7 +182,7 @@ Status Writer::AddRecord(const Slice& slice) {
     return s;
 }
 
-Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
+Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, bool flush) {
     if (compress_type_ == kNoCompress) {
         assert(n <= 0xffff);  // Must fit in two bytes
     } else {
@@ -211,7 +213,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
         Status s = dest_->Append(Slice(buf, header_size_));
         if (s.ok()) {
             s = dest_->Append(Slice(ptr, n));
-            if (s.ok()) {
+            if (s.ok() && flush) {
                 s = dest_->Flush();
             }
         }
@@ -50,6 +50,9 @@ class Writer {
     ~Writer();
 
     Status AddRecord(const Slice& slice);
+    // if flush is false, the record stays in the file buffer until Flush is called
+    Status AddRecord(const Slice& slice, bool flush);
+    Status Flush() { return dest_->Flush(); }
     Status EndLog();
 
     inline CompressType GetCompressType() { return compress_type_; }
@@ -79,7 +82,7 @@ class Writer {
     Status CompressRecord();
     Status AppendInternal(WritableFile* wf, int leftover);
 
-    Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
+    Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length, bool flush = true);
 
     // No copying allowed
     Writer(const Writer&);
@@ -98,6 +101,10 @@ struct WriteHandle {
 
     Status Write(const ::openmldb::base::Slice& slice) { return lw_->AddRecord(slice); }
 
+    Status Write(const ::openmldb::base::Slice& slice, bool flush) { return lw_->AddRecord(slice, flush); }
+
+    Status Flush() { return lw_->Flush(); }
+
     Status Sync() { return wf_->Sync(); }
 
     Status EndLog() { return lw_->EndLog(); }
@@ -34,8 +34,11 @@
 #include "storage/segment.h"
 
 DECLARE_int32(binlog_single_file_max_size);
+DECLARE_bool(binlog_enable_group_commit);
+DECLARE_uint32(binlog_group_commit_max_size);
 DECLARE_int32(binlog_name_length);
 DECLARE_string(zk_cluster);
+DECLARE_uint32(binlog_sync_thread_num);
 
 namespace openmldb {
 namespace replica {
@@ -290,6 +293,12 @@ uint64_t LogReplicator::GetLeaderTerm() { return term_.load(std::memory_order_re
 void LogReplicator::SetLeaderTerm(uint64_t term) { term_.store(term, std::memory_order_relaxed); }
 
 bool LogReplicator::ApplyEntry(const LogEntry& entry) {
+    std::string buffer;
+    entry.SerializeToString(&buffer);
+    return ApplyRawEntry(entry.log_index(), ::openmldb::base::Slice(buffer.c_str(), buffer.size()));
+}
+
+bool LogReplicator::ApplyRawEntry(uint64_t log_index, const ::openmldb::base::Slice& record) {
     std::lock_guard<std::mutex> lock(wmu_);
     uint64_t last_log_offset = GetOffset();
     if (wh_ == NULL || (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size) {
@@ -298,20 +307,17 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
             return false;
         }
     }
-    if (entry.log_index() <= last_log_offset) {
+    if (log_index <= last_log_offset) {
         PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u",
-                entry.log_index(), last_log_offset, tid_, pid_);
+                log_index, last_log_offset, tid_, pid_);
         return true;
     }
-    std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer.c_str(), buffer.size());
-    ::openmldb::log::Status status = wh_->Write(slice);
+    ::openmldb::log::Status status = wh_->Write(record);
     if (!status.ok()) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
         return false;
     }
-    log_offset_.store(entry.log_index(), std::memory_order_relaxed);
+    log_offset_.store(log_index, std::memory_order_relaxed);
     DEBUGLOG("sync log entry to offset %lu for %s", GetOffset(), path_.c_str());
     return true;
 }
@@ -434,7 +440,95 @@ bool LogReplicator::DelAllReplicateNode() {
 }
 
 bool LogReplicator::AppendEntry(LogEntry& entry, ::google::protobuf::Closure* done) {
-    std::lock_guard<std::mutex> lock(wmu_);
+    if (FLAGS_binlog_enable_group_commit) {
+        bool ok = GroupAppendEntry(entry, done);
+        WakeReplicateNodes();
+        return ok;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wmu_);
+        if (!AppendEntryUnLock(entry)) {
+            return false;
+        }
+        if (done) {
+            done->Run();
+        }
+    }
+    WakeReplicateNodes();
+    return true;
+}
+
+bool LogReplicator::AppendEntries(std::vector<LogEntry>& entries, ::google::protobuf::Closure* done) {
+    std::vector<LogEntry*> batch;
+    batch.reserve(entries.size());
+    for (auto& entry : entries) {
+        batch.push_back(&entry);
+    }
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> lock(wmu_);
+        uint32_t cnt = WriteEntriesUnLock(batch);
+        if (cnt < batch.size()) {
+            PDLOG(WARNING, "append entries partially. success/total %u/%u tid %u pid %u", cnt, batch.size(), tid_,
+                  pid_);
+            // the entries written stay in the binlog, done still runs for them
+            entries.resize(cnt);
+        }
+        if (cnt > 0 && done) {
+            done->Run();
+        }
+        ok = cnt == batch.size();
+    }
+    WakeReplicateNodes();
+    return ok;
+}
+
+bool LogReplicator::GroupAppendEntry(LogEntry& entry, ::google::protobuf::Closure* done) {
+    PendingEntry pending(&entry, done);
+    std::unique_lock<bthread::Mutex> lock(pending_mu_);
+    pending_.push_back(&pending);
+    while (!pending.finished && &pending != pending_.front()) {
+        pending.cv.wait(lock);
+    }
+    if (pending.finished) {
+        return pending.ok;
+    }
+    // the front of the queue becomes the leader and writes the entries queued behind it.
+    // the followers are blocked in wait, so their entries and closures stay valid
+    size_t max_size = std::max(FLAGS_binlog_group_commit_max_size, 1u);
+    std::vector<PendingEntry*> group;
+    std::vector<LogEntry*> batch;
+    for (auto it = pending_.begin(); it != pending_.end() && group.size() < max_size; ++it) {
+        group.push_back(*it);
+        batch.push_back((*it)->entry);
+    }
+    lock.unlock();
+    {
+        std::lock_guard<std::mutex> wlock(wmu_);
+        uint32_t cnt = WriteEntriesUnLock(batch);
+        // closures run in log_index order within wmu_ as AppendEntry does
+        for (uint32_t i = 0; i < group.size(); i++) {
+            group[i]->ok = i < cnt;
+            if (group[i]->ok && group[i]->done) {
+                group[i]->done->Run();
+            }
+        }
+    }
+    lock.lock();
+    for (auto* cur : group) {
+        pending_.pop_front();
+        if (cur != &pending) {
+            cur->finished = true;
+            cur->cv.notify_one();
+        }
+    }
+    if (!pending_.empty()) {
+        pending_.front()->cv.notify_one();
+    }
+    return pending.ok;
+}
+
+bool LogReplicator::AppendEntryUnLock(LogEntry& entry) {
     if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
         bool ok = RollWLogFile();
         if (!ok) {
@@ -456,12 +550,48 @@ bool LogReplicator::AppendEntry(LogEntry& entry, ::google::protobuf::Closure* do
                                      // sync to remote replica
         follower_offset_.store(cur_offset + 1, std::memory_order_relaxed);
     }
-    if (done) {
-        done->Run();
-    }
     return true;
 }
 
+uint32_t LogReplicator::WriteEntriesUnLock(const std::vector<LogEntry*>& entries) {
+    if (entries.empty()) {
+        return 0;
+    }
+    // the file is rolled only at the batch boundary, so one file may exceed the limit by one batch
+    if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
+        bool ok = RollWLogFile();
+        if (!ok) {
+            return 0;
+        }
+    }
+    uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
+    uint32_t cnt = 0;
+    std::string buffer;
+    for (auto* entry : entries) {
+        entry->set_log_index(cur_offset + cnt + 1);
+        buffer.clear();
+        entry->SerializeToString(&buffer);
+        ::openmldb::log::Status status = wh_->Write(::openmldb::base::Slice(buffer), false);
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(),
+                  status.ToString().c_str());
+            break;
+        }
+        cnt++;
+    }
+    ::openmldb::log::Status status = wh_->Flush();
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to flush replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
+    }
+    // publish the offset after the records are flushed, so the replicate nodes never read a partial batch
+    log_offset_.store(cur_offset + cnt, std::memory_order_relaxed);
+    if (local_endpoints_.empty()) {  // if local replica are dead, leader direct
+                                     // sync to remote replica
+        follower_offset_.store(cur_offset + cnt, std::memory_order_relaxed);
+    }
+    return cnt;
+}
+
 bool LogReplicator::RollWLogFile() {
     if (wh_ != NULL) {
         wh_->EndLog();
@@ -485,7 +615,20 @@ bool LogReplicator::RollWLogFile() {
     return true;
 }
 
-void LogReplicator::Notify() { cv_.notify_all(); }
+void LogReplicator::Notify() {
+    cv_.notify_all();
+    WakeReplicateNodes();
+}
+
+void LogReplicator::WakeReplicateNodes() {
+    if (FLAGS_binlog_sync_thread_num == 0) {
+        return;
+    }
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    for (const auto& node : nodes_) {
+        node->Wake();
+    }
+}
 
 }  // namespace replica
 }  // namespace openmldb
@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -63,11 +64,23 @@ class LogReplicator {
     // the slave node receives master log entries
     bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
 
+    // the slave node receives a master log record as it is in the binlog, record is the serialized entry
+    bool ApplyRawEntry(uint64_t log_index, const ::openmldb::base::Slice& record);
+
     // the master node append entry
     bool AppendEntry(::openmldb::api::LogEntry& entry, ::google::protobuf::Closure* done = nullptr);  // NOLINT
 
+    // the master node append a batch of entries with consecutive log index under one lock,
+    // done will be invoked once after the entries are written. if only a prefix of the entries is
+    // written, entries is truncated to it, done is still invoked for it and false is returned
+    bool AppendEntries(std::vector<::openmldb::api::LogEntry>& entries,  // NOLINT
+                       ::google::protobuf::Closure* done = nullptr);
+
     //  data to slave nodes
     void Notify();
+
+    // post the replicate nodes to ReplicateScheduler, it does nothing if the nodes have their own threads
+    void WakeReplicateNodes();
     // recover logs meta
     bool Recover();
 
@@ -113,6 +126,26 @@ class LogReplicator {
  private:
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    // write one entry to binlog, wmu_ should be held by the caller
+    bool AppendEntryUnLock(::openmldb::api::LogEntry& entry);  // NOLINT
+
+    // write entries with consecutive log index and flush once, wmu_ should be held by the caller.
+    // return the count of entries written from the beginning
+    uint32_t WriteEntriesUnLock(const std::vector<::openmldb::api::LogEntry*>& entries);
+
+    // enqueue the entry, the front of the queue writes all queued entries as one batch
+    bool GroupAppendEntry(::openmldb::api::LogEntry& entry, ::google::protobuf::Closure* done);  // NOLINT
+
+    struct PendingEntry {
+        PendingEntry(::openmldb::api::LogEntry* e, ::google::protobuf::Closure* d)
+            : entry(e), done(d), ok(false), finished(false) {}
+        ::openmldb::api::LogEntry* entry;
+        ::google::protobuf::Closure* done;
+        bool ok;
+        bool finished;
+        bthread::ConditionVariable cv;
+    };
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -139,6 +172,10 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+
+    // group commit queue
+    bthread::Mutex pending_mu_;
+    std::deque<PendingEntry*> pending_;
 };
 
 }  // namespace replica
@@ -25,7 +25,9 @@
 #include <unistd.h>
 
 #include <filesystem>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wrapper.h"
 #include "base/status.h"
@@ -48,6 +50,10 @@ using ::openmldb::storage::TableIterator;
 using ::openmldb::storage::Ticket;
 
 DECLARE_int32(binlog_single_file_max_size);
+DECLARE_bool(binlog_enable_group_commit);
+DECLARE_bool(binlog_sync_raw);
+DECLARE_uint32(binlog_sync_batch_byte_size);
+DECLARE_uint32(binlog_sync_thread_num);
 
 namespace openmldb {
 namespace replica {
@@ -86,12 +92,26 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
         uint64_t last_log_offset = replicator_.GetOffset();
-        for (int32_t i = 0; i < request->entries_size(); i++) {
-            if (request->entries(i).log_index() <= last_log_offset) {
+        // a follower of an old version does not know raw_entry_sizes and sees an empty request
+        bool raw = request->raw_entry_sizes_size() > 0 && !ignore_raw_.load(std::memory_order_relaxed);
+        int32_t entry_cnt = raw ? request->raw_entry_sizes_size() : request->entries_size();
+        butil::IOBuf& raw_buf = static_cast<brpc::Controller*>(controller)->request_attachment();
+        ::openmldb::api::LogEntry raw_entry;
+        std::string raw_record;
+        for (int32_t i = 0; i < entry_cnt; i++) {
+            if (raw) {
+                raw_record.clear();
+                raw_buf.cutn(&raw_record, request->raw_entry_sizes(i));
+                raw_entry.ParseFromString(raw_record);
+                raw_requests_++;
+            }
+            const auto& entry = raw ? raw_entry : request->entries(i);
+            if (entry.log_index() <= last_log_offset) {
                 continue;
             }
-            const auto& entry = request->entries(i);
-            if (!replicator_.ApplyEntry(entry)) {
+            bool ok = raw ? replicator_.ApplyRawEntry(entry.log_index(), ::openmldb::base::Slice(raw_record))
+                          : replicator_.ApplyEntry(entry);
+            if (!ok) {
                 response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
                 response->set_msg("fail to append entries to replicator");
                 return;
@@ -107,6 +127,12 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
 
     bool GetMode() { return follower_.load(std::memory_order_relaxed); }
 
+    uint64_t GetOffset() { return replicator_.GetOffset(); }
+
+    uint32_t GetRawRequests() { return raw_requests_.load(std::memory_order_relaxed); }
+
+    void SetIgnoreRaw(bool ignore_raw) { ignore_raw_.store(ignore_raw, std::memory_order_relaxed); }
+
  private:
     std::shared_ptr<Table> table_;
     ReplicatorRole role_;
@@ -114,10 +140,21 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
     std::map<std::string, std::string> real_ep_map_;
     LogReplicator replicator_;
     std::atomic<bool> follower_;
+    std::atomic<uint32_t> raw_requests_{0};
+    std::atomic<bool> ignore_raw_{false};
 };
 
 bool ReceiveEntry(const ::openmldb::api::LogEntry& entry) { return true; }
 
+class FunctionClosure : public Closure {
+ public:
+    explicit FunctionClosure(const std::function<void()>& callback) : callback_(callback) {}
+    void Run() override { callback_(); }
+
+ private:
+    std::function<void()> callback_;
+};
+
 class LogReplicatorTest : public ::testing::Test {
  public:
     LogReplicatorTest() {}
@@ -150,6 +187,65 @@ TEST_F(LogReplicatorTest, BenchMark) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(LogReplicatorTest, GroupCommit) {
+    FLAGS_binlog_enable_group_commit = true;
+    absl::Cleanup reset_flag = []() { FLAGS_binlog_enable_group_commit = false; };
+    std::map<std::string, std::string> map;
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / GenRand();
+    absl::Cleanup clean = [&folder]() { std::filesystem::remove_all(folder); };
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    int thread_num = 8;
+    int num = 1000;
+    std::mutex mu;
+    uint64_t last_index = 0;
+    bool in_order = true;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num; i++) {
+                ::openmldb::api::LogEntry entry;
+                entry.set_term(1);
+                entry.set_pk(absl::StrCat("key", t, "_", i));
+                entry.set_value("value");
+                entry.set_ts(9527);
+                // the closures must observe strictly increasing log index
+                auto check_order = [&]() {
+                    std::lock_guard<std::mutex> lock(mu);
+                    if (entry.log_index() != last_index + 1) {
+                        in_order = false;
+                    }
+                    last_index = entry.log_index();
+                };
+                FunctionClosure closure(check_order);
+                ASSERT_TRUE(replicator.AppendEntry(entry, &closure));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(in_order);
+    ASSERT_EQ(static_cast<uint64_t>(thread_num * num), replicator.GetOffset());
+    LogReader reader(replicator.GetLogPart(), replicator.GetLogPath(), false);
+    ASSERT_TRUE(reader.SetOffset(0));
+    ::openmldb::api::LogEntry entry;
+    std::string buffer;
+    ::openmldb::base::Slice record;
+    uint64_t expect_index = 1;
+    while (true) {
+        buffer.clear();
+        ::openmldb::log::Status status = reader.ReadNextRecord(&record, &buffer);
+        if (!status.ok()) {
+            break;
+        }
+        entry.ParseFromString(record.ToString());
+        ASSERT_EQ(expect_index, entry.log_index());
+        expect_index++;
+    }
+    ASSERT_EQ(static_cast<uint64_t>(thread_num * num + 1), expect_index);
+}
+
 TEST_F(LogReplicatorTest, LogReader) {
     // set to 1 MB, every binlog file will be a little larger than 2 MB
     // as the checking logic is: (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size
@@ -549,6 +645,173 @@ TEST_F(LogReplicatorTest, LeaderAndFollower) {
     }
 }
 
+TEST_F(LogReplicatorTest, RawEntries) {
+    FLAGS_binlog_sync_raw = true;
+    uint32_t old_byte_size = FLAGS_binlog_sync_batch_byte_size;
+    FLAGS_binlog_sync_batch_byte_size = 100;
+    absl::Cleanup reset_flag = [old_byte_size]() {
+        FLAGS_binlog_sync_raw = false;
+        FLAGS_binlog_sync_batch_byte_size = old_byte_size;
+    };
+    brpc::ServerOptions options;
+    brpc::Server server0;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> t7 =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    t7->Init();
+    std::string follower_addr = "127.0.0.1:18530";
+    MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, "/tmp/" + GenRand() + "/", g_endpoints, t7);
+    ASSERT_TRUE(follower->Init());
+    ASSERT_EQ(0, server0.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+    ASSERT_EQ(0, server0.Start(follower_addr.c_str(), &options));
+
+    LogReplicator leader(1, 1, "/tmp/" + GenRand() + "/", g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    for (int i = 0; i < 50; i++) {
+        ::openmldb::api::LogEntry entry;
+        ::openmldb::test::AddDimension(0, "test_pk", &entry);
+        entry.set_value(::openmldb::test::EncodeKV("test_pk", "value" + std::to_string(i)));
+        entry.set_ts(9527 - i);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+    }
+    leader.Notify();
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair(follower_addr, ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    for (int i = 0; i < 50 && follower->GetOffset() < 50; i++) {
+        sleep(1);
+    }
+    leader.DelAllReplicateNode();
+    ASSERT_EQ(50u, follower->GetOffset());
+    ASSERT_GE(follower->GetRawRequests(), 50u);
+    ASSERT_EQ(50u, t7->GetRecordCnt());
+    Ticket ticket;
+    std::unique_ptr<TableIterator> it(t7->NewIterator("test_pk", ticket));
+    it->Seek(9527);
+    for (int i = 0; i < 50; i++) {
+        ASSERT_TRUE(it->Valid());
+        ::openmldb::base::Slice value = it->GetValue();
+        ASSERT_EQ("value" + std::to_string(i), ::openmldb::test::DecodeV(std::string(value.data(), value.size())));
+        ASSERT_EQ(9527u - i, it->GetKey());
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+}
+
+TEST_F(LogReplicatorTest, RawEntriesNotApplied) {
+    FLAGS_binlog_sync_raw = true;
+    uint32_t old_byte_size = FLAGS_binlog_sync_batch_byte_size;
+    FLAGS_binlog_sync_batch_byte_size = 100;
+    absl::Cleanup reset_flag = [old_byte_size]() {
+        FLAGS_binlog_sync_raw = false;
+        FLAGS_binlog_sync_batch_byte_size = old_byte_size;
+    };
+    brpc::ServerOptions options;
+    brpc::Server server0;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> t7 =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    t7->Init();
+    std::string follower_addr = "127.0.0.1:18533";
+    MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, "/tmp/" + GenRand() + "/", g_endpoints, t7);
+    ASSERT_TRUE(follower->Init());
+    follower->SetIgnoreRaw(true);
+    ASSERT_EQ(0, server0.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+    ASSERT_EQ(0, server0.Start(follower_addr.c_str(), &options));
+
+    LogReplicator leader(1, 1, "/tmp/" + GenRand() + "/", g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    for (int i = 0; i < 50; i++) {
+        ::openmldb::api::LogEntry entry;
+        ::openmldb::test::AddDimension(0, "test_pk", &entry);
+        entry.set_value(::openmldb::test::EncodeKV("test_pk", "value" + std::to_string(i)));
+        entry.set_ts(9527 - i);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+    }
+    leader.Notify();
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair(follower_addr, ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    for (int i = 0; i < 50 && follower->GetOffset() < 50; i++) {
+        sleep(1);
+    }
+    leader.DelAllReplicateNode();
+    // the leader falls back to entries instead of resending the raw records
+    ASSERT_EQ(50u, follower->GetOffset());
+    ASSERT_EQ(0u, follower->GetRawRequests());
+    ASSERT_EQ(50u, t7->GetRecordCnt());
+}
+
+TEST_F(LogReplicatorTest, SyncInScheduler) {
+    FLAGS_binlog_sync_thread_num = 2;
+    absl::Cleanup reset_flag = []() { FLAGS_binlog_sync_thread_num = 0; };
+    brpc::ServerOptions options;
+    brpc::Server server0;
+    brpc::Server server1;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::vector<std::string> follower_addrs = {"127.0.0.1:18531", "127.0.0.1:18532"};
+    std::vector<brpc::Server*> servers = {&server0, &server1};
+    std::vector<std::shared_ptr<MemTable>> tables;
+    std::vector<MockTabletImpl*> followers;
+    for (uint32_t i = 0; i < follower_addrs.size(); i++) {
+        auto table =
+            std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, "/tmp/" + GenRand() + "/", g_endpoints, table);
+        ASSERT_TRUE(follower->Init());
+        ASSERT_EQ(0, servers[i]->AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, servers[i]->Start(follower_addrs[i].c_str(), &options));
+        tables.push_back(table);
+        followers.push_back(follower);
+    }
+    LogReplicator leader(1, 1, "/tmp/" + GenRand() + "/", g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    auto append = [&leader](int start, int end) {
+        for (int i = start; i < end; i++) {
+            ::openmldb::api::LogEntry entry;
+            ::openmldb::test::AddDimension(0, "test_pk", &entry);
+            entry.set_value(::openmldb::test::EncodeKV("test_pk", "value" + std::to_string(i)));
+            entry.set_ts(9527 - i);
+            ASSERT_TRUE(leader.AppendEntry(entry));
+        }
+    };
+    append(0, 10);
+    for (const auto& addr : follower_addrs) {
+        std::map<std::string, std::string> map = {{addr, ""}};
+        ASSERT_EQ(0, leader.AddReplicateNode(map));
+    }
+    // the entries appended later are posted to the scheduler without Notify
+    append(10, 100);
+    auto wait_synced = [&followers](uint64_t offset) {
+        for (int i = 0; i < 100; i++) {
+            if (followers[0]->GetOffset() >= offset && followers[1]->GetOffset() >= offset) {
+                return;
+            }
+            usleep(100 * 1000);
+        }
+    };
+    wait_synced(100);
+    for (uint32_t i = 0; i < followers.size(); i++) {
+        ASSERT_EQ(100u, followers[i]->GetOffset());
+        ASSERT_EQ(100u, tables[i]->GetRecordCnt());
+    }
+    std::map<std::string, uint64_t> info_map;
+    leader.GetReplicateInfo(info_map);
+    ASSERT_EQ(2u, info_map.size());
+    for (const auto& kv : info_map) {
+        ASSERT_EQ(100u, kv.second);
+    }
+    ASSERT_EQ(0, leader.DelReplicateNode(follower_addrs[1]));
+    append(100, 110);
+    wait_synced(110);
+    ASSERT_EQ(110u, followers[0]->GetOffset());
+    ASSERT_EQ(100u, followers[1]->GetOffset());
+    leader.DelAllReplicateNode();
+}
+
 TEST_F(LogReplicatorTest, Leader_Remove_local_follower) {
     brpc::ServerOptions options;
     brpc::Server server0;
@@ -17,13 +17,18 @@
 #include "replica/replicate_node.h"
 
 #include <gflags/gflags.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include <algorithm>
 
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
+#include "replica/replicate_scheduler.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_bool(binlog_sync_raw);
+DECLARE_uint32(binlog_sync_batch_byte_size);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
@@ -31,10 +36,36 @@ DECLARE_int32(request_max_retry);
 DECLARE_int32(request_timeout_ms);
 DECLARE_string(zk_cluster);
 DECLARE_uint32(go_back_max_try_cnt);
+DECLARE_uint32(binlog_sync_thread_num);
 
 namespace openmldb {
 namespace replica {
 
+// read the log_index of a serialized LogEntry without parsing the whole entry
+static bool GetRawLogIndex(const ::openmldb::base::Slice& record, uint64_t* log_index) {
+    using ::google::protobuf::internal::WireFormatLite;
+    ::google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(record.data()),
+                                                   static_cast<int>(record.size()));
+    uint32_t tag = 0;
+    while ((tag = input.ReadTag()) != 0) {
+        if (WireFormatLite::GetTagFieldNumber(tag) == ::openmldb::api::LogEntry::kLogIndexFieldNumber &&
+            WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT) {
+            ::google::protobuf::uint64 value = 0;
+            if (!input.ReadVarint64(&value)) {
+                return false;
+            }
+            *log_index = value;
+            return true;
+        }
+        if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static uint64_t GetNodeSyncLag(void* arg) { return static_cast<ReplicateNode*>(arg)->GetSyncLag(); }
+
 static void* RunSyncTask(void* args) {
     if (args == NULL) {
         PDLOG(WARNING, "input args is null");
@@ -65,8 +96,16 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
       mu_(mu),
       cv_(cv),
       go_back_cnt_(0),
+      raw_disabled_(false),
       rep_node_(rep_follower),
-      follower_offset_(follower_offset) {
+      follower_offset_(follower_offset),
+      use_scheduler_(false),
+      sched_state_(kSchedIdle),
+      idle_gen_(0),
+      run_mu_(),
+      sync_record_cnt_(),
+      sync_record_rate_(&sync_record_cnt_),
+      sync_lag_(GetNodeSyncLag, this) {
     if (!real_point.empty()) {
         rpc_client_ = openmldb::RpcClient<::openmldb::api::TabletServer_Stub>(real_point);
     }
@@ -78,6 +117,9 @@ int ReplicateNode::Init() {
         PDLOG(WARNING, "fail to open rpc client with errno %d", ok);
     }
     PDLOG(INFO, "open rpc client for endpoint %s done", endpoint_.c_str());
+    std::string name = std::to_string(tid_) + "_" + std::to_string(pid_) + "_" + endpoint_;
+    sync_record_rate_.expose_as("openmldb_replicate_record_rate", name);
+    sync_lag_.expose_as("openmldb_replicate_lag", name);
     return ok;
 }
 
@@ -87,6 +129,12 @@ int ReplicateNode::Start() {
         return 0;
     }
     is_running_.store(true, std::memory_order_relaxed);
+    if (FLAGS_binlog_sync_thread_num > 0) {
+        use_scheduler_ = true;
+        ReplicateScheduler::GetInstance()->Post(shared_from_this());
+        PDLOG(INFO, "start sync in scheduler for table #tid %u, #pid %u done", tid_, pid_);
+        return 0;
+    }
     int ok = bthread_start_background(&worker_, NULL, RunSyncTask, this);
     if (ok != 0) {
         PDLOG(WARNING, "fail to start bthread with errno %d", ok);
@@ -141,6 +189,46 @@ void ReplicateNode::SyncData() {
     PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
 }
 
+ReplicateNode::SyncState ReplicateNode::SyncOnce(uint32_t* delay_ms) {
+    std::lock_guard<bthread::Mutex> lock(run_mu_);
+    if (!is_running_.load(std::memory_order_relaxed)) {
+        return SyncState::kStopped;
+    }
+    if (!log_matched_ && MatchLogOffsetFromNode() != 0) {
+        *delay_ms = FLAGS_binlog_match_logoffset_interval;
+        return SyncState::kWait;
+    }
+    uint64_t log_offset = GetTargetOffset();
+    if (last_sync_offset_ >= log_offset) {
+        *delay_ms = FLAGS_binlog_sync_wait_time;
+        return SyncState::kIdle;
+    }
+    if (SyncData(log_offset) == 1) {
+        *delay_ms = FLAGS_binlog_coffee_time;
+        return SyncState::kWait;
+    }
+    return SyncState::kAgain;
+}
+
+void ReplicateNode::Wake() {
+    if (use_scheduler_ && is_running_.load(std::memory_order_relaxed)) {
+        ReplicateScheduler::GetInstance()->Post(shared_from_this());
+    }
+}
+
+uint64_t ReplicateNode::GetTargetOffset() {
+    if (rep_node_.load(std::memory_order_relaxed)) {
+        return follower_offset_->load(std::memory_order_relaxed);
+    }
+    return leader_log_offset_->load(std::memory_order_relaxed);
+}
+
+uint64_t ReplicateNode::GetSyncLag() {
+    uint64_t offset = GetTargetOffset();
+    uint64_t synced = last_sync_offset_;
+    return offset > synced ? offset - synced : 0;
+}
+
 int ReplicateNode::GetLogIndex() { return log_reader_.GetLogIndex(); }
 
 bool ReplicateNode::IsLogMatched() { return log_matched_; }
@@ -180,25 +268,32 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     }
     ::openmldb::api::AppendEntriesRequest request;
     ::openmldb::api::AppendEntriesResponse response;
+    butil::IOBuf attachment;
     uint64_t sync_log_offset = last_sync_offset_;
     bool request_from_cache = false;
     bool need_wait = false;
+    bool raw = FLAGS_binlog_sync_raw && !raw_disabled_;
     if (cache_.size() > 0) {
         request_from_cache = true;
         request = cache_[0];
-        if (request.entries_size() <= 0) {
+        attachment = cache_attachment_;
+        raw = request.raw_entry_sizes_size() > 0;
+        if (request.entries_size() <= 0 && !raw) {
             cache_.clear();
+            cache_attachment_.clear();
             PDLOG(WARNING, "empty append entry request from node %s cache", endpoint_.c_str());
             return -1;
         }
-        const ::openmldb::api::LogEntry& entry = request.entries(request.entries_size() - 1);
-        if (entry.log_index() <= last_sync_offset_) {
+        uint64_t last_log_index =
+            raw ? request.last_log_index() : request.entries(request.entries_size() - 1).log_index();
+        if (last_log_index <= last_sync_offset_) {
             DEBUGLOG("duplicate log index from node %s cache", endpoint_.c_str());
             cache_.clear();
+            cache_attachment_.clear();
             return -1;
         }
-        PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", entry.log_index(), tid_, pid_);
-        sync_log_offset = entry.log_index();
+        PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", last_log_index, tid_, pid_);
+        sync_log_offset = last_log_index;
     } else {
         request.set_tid(tid_);
         request.set_pid(pid_);
@@ -206,32 +301,51 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         if (!FLAGS_zk_cluster.empty()) {
             request.set_term(term_->load(std::memory_order_relaxed));
         }
-        uint32_t batchSize = log_offset - last_sync_offset_;
-        batchSize = std::min(batchSize, (uint32_t)FLAGS_binlog_sync_batch_size);
+        // the raw batch is sized by bytes, the records are not parsed except the log index
+        uint64_t batchSize = log_offset - last_sync_offset_;
+        if (!raw) {
+            batchSize = std::min(batchSize, (uint64_t)FLAGS_binlog_sync_batch_size);
+        }
+        uint64_t batch_byte_size = 0;
         for (uint64_t i = 0; i < batchSize;) {
             std::string buffer;
             ::openmldb::base::Slice record;
             ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
             if (status.ok()) {
-                ::openmldb::api::LogEntry* entry = request.add_entries();
-                if (!entry->ParseFromString(record.ToString())) {
-                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
-                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_,
-                          pid_);
-                    request.mutable_entries()->RemoveLast();
-                    break;
+                ::openmldb::api::LogEntry* entry = nullptr;
+                uint64_t log_index = 0;
+                if (raw) {
+                    if (!GetRawLogIndex(record, &log_index)) {
+                        PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                              ::openmldb::base::DebugString(record.ToString()).c_str(), record.size(), tid_, pid_);
+                        break;
+                    }
+                } else {
+                    entry = request.add_entries();
+                    if (!entry->ParseFromString(record.ToString())) {
+                        PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                              ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(),
+                              tid_, pid_);
+                        request.mutable_entries()->RemoveLast();
+                        break;
+                    }
+                    DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
+                    log_index = entry->log_index();
                 }
-                DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
-                if (entry->log_index() <= sync_log_offset) {
-                    DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
-                    request.mutable_entries()->RemoveLast();
+                if (log_index <= sync_log_offset) {
+                    DEBUGLOG("skip duplicate log offset %lld", log_index);
+                    if (entry != nullptr) {
+                        request.mutable_entries()->RemoveLast();
+                    }
                     continue;
                 }
                 // the log index should incr by 1
-                if ((sync_log_offset + 1) != entry->log_index()) {
+                if ((sync_log_offset + 1) != log_index) {
                     PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", sync_log_offset + 1,
-                          entry->log_index(), tid_, pid_);
-                    request.mutable_entries()->RemoveLast();
+                          log_index, tid_, pid_);
+                    if (entry != nullptr) {
+                        request.mutable_entries()->RemoveLast();
+                    }
                     if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
                         log_reader_.GoBackToStart();
                         go_back_cnt_ = 0;
@@ -243,7 +357,12 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
                     need_wait = true;
                     break;
                 }
-                sync_log_offset = entry->log_index();
+                if (raw) {
+                    attachment.append(record.data(), record.size());
+                    request.add_raw_entry_sizes(record.size());
+                    batch_byte_size += record.size();
+                }
+                sync_log_offset = log_index;
             } else if (status.IsWaitRecord()) {
                 DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
                 need_wait = true;
@@ -267,13 +386,50 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             }
             i++;
             go_back_cnt_ = 0;
+            if (raw && batch_byte_size >= FLAGS_binlog_sync_batch_byte_size) {
+                break;
+            }
+        }
+        if (raw) {
+            request.set_last_log_index(sync_log_offset);
         }
     }
-    if (request.entries_size() > 0) {
-        bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
-                                           FLAGS_request_timeout_ms, FLAGS_request_max_retry);
+    if (request.entries_size() > 0 || request.raw_entry_sizes_size() > 0) {
+        bool ret = false;
+        if (raw) {
+            ret = rpc_client_.SendRequestWithAttachment(&::openmldb::api::TabletServer_Stub::AppendEntries, &request,
+                                                        &response, FLAGS_request_timeout_ms,
+                                                        FLAGS_request_max_retry, attachment);
+            // a follower which does not know the raw records replies ok without applying them.
+            // resending the raw request would never make progress, so the cached records are
+            // sent again as entries from the offset of the follower
+            if (ret && response.code() == 0 && response.log_offset() < sync_log_offset) {
+                PDLOG(WARNING, "node %s does not apply raw records, log offset %lu expect %lu. tid %u pid %u",
+                      endpoint_.c_str(), response.log_offset(), sync_log_offset, tid_, pid_);
+                raw_disabled_ = true;
+                cache_.clear();
+                cache_attachment_.clear();
+                ::openmldb::api::AppendEntriesRequest entries_request;
+                if (ToEntriesRequest(request, attachment, response.log_offset(), &entries_request)) {
+                    last_sync_offset_ = response.log_offset();
+                    if (entries_request.entries_size() > 0) {
+                        cache_.push_back(entries_request);
+                    }
+                } else {
+                    PDLOG(WARNING, "fail to rebuild the raw records as entries. tid %u pid %u", tid_, pid_);
+                    log_reader_.GoBackToStart();
+                }
+                return 1;
+            }
+        } else {
+            ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
+                                          FLAGS_request_timeout_ms, FLAGS_request_max_retry);
+        }
         if (ret && response.code() == 0) {
             DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
+            if (sync_log_offset > last_sync_offset_) {
+                sync_record_cnt_ << sync_log_offset - last_sync_offset_;
+            }
             last_sync_offset_ = sync_log_offset;
             if (!rep_node_.load(std::memory_order_relaxed) &&
                 (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
@@ -281,10 +437,12 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             }
             if (request_from_cache) {
                 cache_.clear();
+                cache_attachment_.clear();
             }
         } else {
             if (!request_from_cache) {
                 cache_.push_back(request);
+                cache_attachment_ = attachment;
             }
             need_wait = true;
             PDLOG(WARNING, "fail to sync log to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
@@ -296,9 +454,45 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     return 0;
 }
 
+bool ReplicateNode::ToEntriesRequest(const ::openmldb::api::AppendEntriesRequest& raw_request,
+                                     const butil::IOBuf& attachment, uint64_t log_offset,
+                                     ::openmldb::api::AppendEntriesRequest* request) {
+    // the records before pre_log_index are not in the raw request
+    if (log_offset < raw_request.pre_log_index()) {
+        return false;
+    }
+    request->set_tid(raw_request.tid());
+    request->set_pid(raw_request.pid());
+    request->set_pre_log_index(log_offset);
+    if (raw_request.has_term()) {
+        request->set_term(raw_request.term());
+    }
+    butil::IOBuf buf = attachment;
+    std::string record;
+    for (uint32_t size : raw_request.raw_entry_sizes()) {
+        record.clear();
+        if (buf.cutn(&record, size) != size) {
+            return false;
+        }
+        ::openmldb::api::LogEntry* entry = request->add_entries();
+        if (!entry->ParseFromString(record)) {
+            return false;
+        }
+        if (entry->log_index() <= log_offset) {
+            request->mutable_entries()->RemoveLast();
+        }
+    }
+    return true;
+}
+
 void ReplicateNode::Stop() {
     is_running_.store(false, std::memory_order_relaxed);
+    // the lag reads the offsets owned by LogReplicator
+    sync_lag_.hide();
+    sync_record_rate_.hide();
     if (worker_ == 0) {
+        // wait for the running step in ReplicateScheduler
+        std::lock_guard<bthread::Mutex> lock(run_mu_);
         return;
     }
 
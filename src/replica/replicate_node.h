@@ -18,12 +18,15 @@
 #define SRC_REPLICA_REPLICATE_NODE_H_
 
 #include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "base/skiplist.h"
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
+#include "bvar/bvar.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
@@ -36,8 +39,18 @@ namespace replica {
 using ::openmldb::log::LogReader;
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
-class ReplicateNode {
+class ReplicateNode : public std::enable_shared_from_this<ReplicateNode> {
  public:
+    enum class SyncState {
+        kStopped,
+        // there may be more data to sync
+        kAgain,
+        // wait for delay_ms before the next step, e.g. the follower is not reachable
+        kWait,
+        // all the data is synced
+        kIdle,
+    };
+
     ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid, uint32_t pid,
                   std::atomic<uint64_t>* term, std::atomic<uint64_t>* leader_log_offset, bthread::Mutex* mu,
                   bthread::ConditionVariable* cv, bool rep_follower, std::atomic<uint64_t>* follower_offset,
@@ -53,6 +66,12 @@ class ReplicateNode {
 
     int SyncData(uint64_t log_offset);
 
+    // run one sync step in ReplicateScheduler instead of the sync thread, delay_ms is set for kWait and kIdle
+    SyncState SyncOnce(uint32_t* delay_ms);
+
+    // post the node to ReplicateScheduler if it is started there
+    void Wake();
+
     void SetLastSyncOffset(uint64_t offset);
 
     bool IsLogMatched();
@@ -61,6 +80,9 @@ class ReplicateNode {
 
     uint64_t GetLastSyncOffset();
 
+    // the count of the entries not synced yet
+    uint64_t GetSyncLag();
+
     int GetLogIndex();
 
     void Stop();
@@ -70,11 +92,20 @@ class ReplicateNode {
     ReplicateNode& operator=(const ReplicateNode&) = delete;
 
  private:
+    friend class ReplicateScheduler;
+    enum SchedState { kSchedIdle = 0, kSchedQueued = 1, kSchedRunning = 2, kSchedRunningDirty = 3 };
+
     int MatchLogOffsetFromNode();
+    uint64_t GetTargetOffset();
+    // rebuild the records of a raw request after log_offset as entries
+    bool ToEntriesRequest(const ::openmldb::api::AppendEntriesRequest& raw_request, const butil::IOBuf& attachment,
+                          uint64_t log_offset, ::openmldb::api::AppendEntriesRequest* request);
 
  private:
     LogReader log_reader_;
     std::vector<::openmldb::api::AppendEntriesRequest> cache_;
+    // the raw records of the cached request
+    butil::IOBuf cache_attachment_;
     std::string endpoint_;
     uint64_t last_sync_offset_;
     bool log_matched_;
@@ -88,8 +119,20 @@ class ReplicateNode {
     bthread::Mutex* mu_;
     bthread::ConditionVariable* cv_;
     uint32_t go_back_cnt_;
+    // the follower does not apply raw records, sync it with entries
+    bool raw_disabled_;
     std::atomic<bool> rep_node_;
     std::atomic<uint64_t>* follower_offset_;  // max local cluster follower offset
+    // the node is driven by ReplicateScheduler instead of worker_
+    bool use_scheduler_;
+    std::atomic<int> sched_state_;
+    // bumped every time the node goes idle, only the idle check of the latest generation runs
+    std::atomic<uint64_t> idle_gen_;
+    // held by a sync step in ReplicateScheduler, Stop waits for it
+    bthread::Mutex run_mu_;
+    bvar::Adder<uint64_t> sync_record_cnt_;
+    bvar::PerSecond<bvar::Adder<uint64_t>> sync_record_rate_;
+    bvar::PassiveStatus<uint64_t> sync_lag_;
 };
 
 }  // namespace replica
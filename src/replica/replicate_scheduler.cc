@@ -0,0 +1,182 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "replica/replicate_scheduler.h"
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+
+#include "base/glog_wrapper.h"
+#include "common/timer.h"
+#include "replica/replicate_node.h"
+
+DECLARE_uint32(binlog_sync_thread_num);
+
+namespace openmldb {
+namespace replica {
+
+static uint64_t GetSchedulerQueueSize(void* arg) {
+    return static_cast<ReplicateScheduler*>(arg)->GetQueueSize();
+}
+
+ReplicateScheduler* ReplicateScheduler::GetInstance() {
+    // never deleted, the nodes may be stopped by the static objects at exit
+    static ReplicateScheduler* scheduler = new ReplicateScheduler(FLAGS_binlog_sync_thread_num);
+    return scheduler;
+}
+
+ReplicateScheduler::ReplicateScheduler(uint32_t thread_num)
+    : mu_(), cv_(), ready_(), delayed_(), stop_(false), workers_(),
+      queue_size_("openmldb_replicate_scheduler_queue_size", GetSchedulerQueueSize, this) {
+    thread_num = std::max(thread_num, 1u);
+    for (uint32_t i = 0; i < thread_num; i++) {
+        bthread_t worker;
+        if (bthread_start_background(&worker, NULL, RunWorker, this) != 0) {
+            PDLOG(WARNING, "fail to start replicate worker %u", i);
+            continue;
+        }
+        workers_.push_back(worker);
+    }
+    PDLOG(INFO, "start replicate scheduler with %u workers", workers_.size());
+}
+
+ReplicateScheduler::~ReplicateScheduler() {
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto worker : workers_) {
+        bthread_join(worker, NULL);
+    }
+}
+
+void* ReplicateScheduler::RunWorker(void* args) {
+    static_cast<ReplicateScheduler*>(args)->Run();
+    return NULL;
+}
+
+uint64_t ReplicateScheduler::GetQueueSize() {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    return ready_.size() + delayed_.size();
+}
+
+void ReplicateScheduler::Push(const std::shared_ptr<ReplicateNode>& node, uint64_t delay_ms, bool idle_check,
+                              uint64_t idle_gen) {
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        if (delay_ms == 0) {
+            ready_.push_back({node, idle_check, idle_gen});
+        } else {
+            uint64_t run_time = ::baidu::common::timer::get_micros() / 1000 + delay_ms;
+            delayed_.emplace(run_time, Task{node, idle_check, idle_gen});
+        }
+    }
+    cv_.notify_one();
+}
+
+void ReplicateScheduler::Post(const std::shared_ptr<ReplicateNode>& node) {
+    int state = node->sched_state_.load(std::memory_order_acquire);
+    while (true) {
+        if (state == ReplicateNode::kSchedIdle) {
+            if (node->sched_state_.compare_exchange_weak(state, ReplicateNode::kSchedQueued)) {
+                Push(node, 0);
+                return;
+            }
+        } else if (state == ReplicateNode::kSchedRunning) {
+            // the running step will queue the node again when it is done
+            if (node->sched_state_.compare_exchange_weak(state, ReplicateNode::kSchedRunningDirty)) {
+                return;
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+void ReplicateScheduler::Run() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<bthread::Mutex> lock(mu_);
+            while (!stop_) {
+                uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+                while (!delayed_.empty() && delayed_.begin()->first <= now) {
+                    ready_.push_back(delayed_.begin()->second);
+                    delayed_.erase(delayed_.begin());
+                }
+                if (!ready_.empty()) {
+                    break;
+                }
+                if (delayed_.empty()) {
+                    cv_.wait(lock);
+                } else {
+                    cv_.wait_for(lock, (delayed_.begin()->first - now) * 1000);
+                }
+            }
+            if (stop_) {
+                return;
+            }
+            task = ready_.front();
+            ready_.pop_front();
+        }
+        std::shared_ptr<ReplicateNode> node = task.node.lock();
+        if (!node) {
+            continue;
+        }
+        if (task.idle_check) {
+            // the node has gone idle again after this check was pushed, a newer check is pending
+            if (task.idle_gen != node->idle_gen_.load(std::memory_order_acquire)) {
+                continue;
+            }
+            int state = ReplicateNode::kSchedIdle;
+            if (!node->sched_state_.compare_exchange_strong(state, ReplicateNode::kSchedRunning)) {
+                continue;
+            }
+        } else {
+            node->sched_state_.store(ReplicateNode::kSchedRunning, std::memory_order_release);
+        }
+        uint32_t delay_ms = 0;
+        switch (node->SyncOnce(&delay_ms)) {
+            case ReplicateNode::SyncState::kStopped:
+                node->sched_state_.store(ReplicateNode::kSchedIdle, std::memory_order_release);
+                break;
+            case ReplicateNode::SyncState::kAgain:
+            case ReplicateNode::SyncState::kWait:
+                node->sched_state_.store(ReplicateNode::kSchedQueued, std::memory_order_release);
+                Push(node, delay_ms);
+                break;
+            case ReplicateNode::SyncState::kIdle: {
+                // bump the generation before the node can be seen idle, so the stale checks are dropped
+                uint64_t idle_gen = node->idle_gen_.fetch_add(1, std::memory_order_acq_rel) + 1;
+                int state = ReplicateNode::kSchedRunning;
+                if (node->sched_state_.compare_exchange_strong(state, ReplicateNode::kSchedIdle)) {
+                    Push(node, delay_ms, true, idle_gen);
+                } else {
+                    // posted while it was running
+                    node->sched_state_.store(ReplicateNode::kSchedQueued, std::memory_order_release);
+                    Push(node, 0);
+                }
+                break;
+            }
+        }
+    }
+}
+
+}  // namespace replica
+}  // namespace openmldb
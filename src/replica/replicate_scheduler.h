@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_REPLICA_REPLICATE_SCHEDULER_H_
+#define SRC_REPLICA_REPLICATE_SCHEDULER_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
+#include "bvar/bvar.h"
+
+namespace openmldb {
+namespace replica {
+
+class ReplicateNode;
+
+// A fixed pool of bthreads drives the ReplicateNodes of all the partitions instead of one thread per node.
+// A node is posted when its partition appends entries, it runs one sync step at a time and is posted
+// again while it has data to sync. An idle node is checked again after binlog_sync_wait_time in case
+// its target offset moves without a post.
+class ReplicateScheduler {
+ public:
+    // the scheduler shared by the process, created with binlog_sync_thread_num workers on the first call
+    static ReplicateScheduler* GetInstance();
+
+    explicit ReplicateScheduler(uint32_t thread_num);
+    ~ReplicateScheduler();
+
+    ReplicateScheduler(const ReplicateScheduler&) = delete;
+    ReplicateScheduler& operator=(const ReplicateScheduler&) = delete;
+
+    // run the node as soon as possible. it is merged with the pending run if the node is queued or running
+    void Post(const std::shared_ptr<ReplicateNode>& node);
+
+    uint64_t GetQueueSize();
+
+ private:
+    struct Task {
+        std::weak_ptr<ReplicateNode> node;
+        // an idle check runs only if the node is still idle and has not gone idle again since
+        bool idle_check;
+        uint64_t idle_gen;
+    };
+
+    static void* RunWorker(void* args);
+    void Run();
+    void Push(const std::shared_ptr<ReplicateNode>& node, uint64_t delay_ms, bool idle_check = false,
+              uint64_t idle_gen = 0);
+
+ private:
+    bthread::Mutex mu_;
+    bthread::ConditionVariable cv_;
+    std::deque<Task> ready_;
+    // run time in ms -> task
+    std::multimap<uint64_t, Task> delayed_;
+    bool stop_;
+    std::vector<bthread_t> workers_;
+    bvar::PassiveStatus<uint64_t> queue_size_;
+};
+
+}  // namespace replica
+}  // namespace openmldb
+#endif  // SRC_REPLICA_REPLICATE_SCHEDULER_H_
@@ -170,6 +170,32 @@ class RpcClient {
         return true;
     }
 
+    template <class Request, class Response, class Callback>
+    bool SendRequestWithAttachment(void (T::*func)(google::protobuf::RpcController*, const Request*, Response*,
+                                                   Callback*),
+                                   const Request* request, Response* response, uint64_t rpc_timeout, int retry_times,
+                                   const butil::IOBuf& buff) {
+        brpc::Controller cntl;
+        cntl.set_log_id(log_id_++);
+        if (rpc_timeout > 0) {
+            cntl.set_timeout_ms(rpc_timeout);
+        }
+        if (retry_times > 0) {
+            cntl.set_max_retry(retry_times);
+        }
+        if (stub_ == NULL) {
+            PDLOG(WARNING, "stub is null. client must be init before send request");
+            return false;
+        }
+        cntl.request_attachment().append(buff);
+        (stub_->*func)(&cntl, request, response, NULL);
+        if (!cntl.Failed()) {
+            return true;
+        }
+        PDLOG(WARNING, "request error. %s", cntl.ErrorText().c_str());
+        return false;
+    }
+
     template <class Request, class Response>
     bool SendRequest(void (T::*func)(google::protobuf::RpcController*, const Request*, Response*,
                                      google::protobuf::Closure*),
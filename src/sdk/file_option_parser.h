@@ -145,7 +145,25 @@ class FileOptionsParser {
 
 class ReadFileOptionsParser : public FileOptionsParser {
  public:
-    ReadFileOptionsParser() { quote_ = '\0'; }
+    ReadFileOptionsParser() {
+        quote_ = '\0';
+        check_map_.emplace("thread", std::make_pair(CheckThread(), hybridse::node::kInt32));
+    }
+    // the number of threads to parse and insert the rows
+    uint32_t GetThread() const { return thread_; }
+
+ private:
+    uint32_t thread_ = 1;
+    std::function<bool(const hybridse::node::ConstNode* node)> CheckThread() {
+        return [this](const hybridse::node::ConstNode* node) {
+            int thread = node->GetInt();
+            if (thread <= 0 || thread > 64) {
+                return false;
+            }
+            thread_ = thread;
+            return true;
+        };
+    }
 };
 
 class WriteFileOptionsParser : public FileOptionsParser {
@@ -30,20 +30,58 @@ ResultSetBase::ResultSetBase(const butil::IOBuf* buf, uint32_t count, uint32_t b
       row_view_(std::move(row_view)),
       schema_(),
       position_(0),
-      index_(-1) {
+      index_(-1),
+      decoder_(),
+      row_(),
+      next_row_() {
     schema_.SetSchema(schema);
 }
 
+ResultSetBase::ResultSetBase(std::unique_ptr<::openmldb::codec::ColumnBlockDecoder> decoder,
+                             std::unique_ptr<::hybridse::sdk::RowIOBufView> row_view,
+                             const ::hybridse::vm::Schema& schema)
+    : io_buf_(nullptr),
+      count_(decoder->GetCount()),
+      buf_size_(0),
+      row_view_(std::move(row_view)),
+      schema_(),
+      position_(0),
+      index_(-1),
+      decoder_(std::move(decoder)),
+      row_(),
+      next_row_() {
+    schema_.SetSchema(schema);
+}
+
+static void NoopDeleter(void*) {}
+
 ResultSetBase::~ResultSetBase() {}
 
 bool ResultSetBase::Reset() {
     index_ = -1;
     position_ = 0;
+    if (decoder_) {
+        decoder_->Reset();
+    }
     return true;
 }
 
 bool ResultSetBase::Next() {
     index_++;
+    if (decoder_) {
+        // decode into another buffer, so the view keeps the current row if the decoding fails
+        if (index_ >= static_cast<int32_t>(count_) || !decoder_->Next(&next_row_)) {
+            return false;
+        }
+        row_.swap(next_row_);
+        // the view refers to row_ without copying it
+        butil::IOBuf tmp;
+        if (tmp.append_user_data(&row_[0], row_.size(), NoopDeleter) != 0 || !row_view_->Reset(tmp)) {
+            LOG(WARNING) << "reset row buf failed";
+            return false;
+        }
+        return true;
+    }
     if (index_ < static_cast<int32_t>(count_) && position_ < buf_size_) {
         // get row size
         uint32_t row_size = 0;
@@ -20,6 +20,7 @@
 #include <string>
 
 #include "butil/iobuf.h"
+#include "codec/column_block_codec.h"
 #include "sdk/base_impl.h"
 #include "sdk/codec_sdk.h"
 
@@ -30,6 +31,9 @@ class ResultSetBase {
  public:
     ResultSetBase(const butil::IOBuf* buf, uint32_t count, uint32_t buf_size,
                   std::unique_ptr<::hybridse::sdk::RowIOBufView> row_view, const ::hybridse::vm::Schema& schema);
+    // the rows are decoded from the column block one at a time as Next is called
+    ResultSetBase(std::unique_ptr<::openmldb::codec::ColumnBlockDecoder> decoder,
+                  std::unique_ptr<::hybridse::sdk::RowIOBufView> row_view, const ::hybridse::vm::Schema& schema);
     ~ResultSetBase();
 
     bool Reset();
@@ -72,6 +76,11 @@ class ResultSetBase {
     ::hybridse::sdk::SchemaImpl schema_;
     uint32_t position_;
     int32_t index_;
+    // non-null if the rows are from a column block
+    std::unique_ptr<::openmldb::codec::ColumnBlockDecoder> decoder_;
+    // the current row decoded, row_view_ refers to it
+    std::string row_;
+    std::string next_row_;
 };
 
 }  // namespace sdk
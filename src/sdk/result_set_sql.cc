@@ -16,6 +16,8 @@
 
 #include "sdk/result_set_sql.h"
 
+#include <snappy.h>
+
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,6 +26,7 @@
 #include "base/status.h"
 #include "base/time.h"
 #include "catalog/sdk_catalog.h"
+#include "codec/column_block_codec.h"
 #include "codec/fe_schema_codec.h"
 #include "codec/row_codec.h"
 #include "glog/logging.h"
@@ -35,16 +38,22 @@ namespace sdk {
 ResultSetSQL::ResultSetSQL(const ::hybridse::vm::Schema& schema, uint32_t record_cnt, uint32_t buf_size,
                            const std::shared_ptr<brpc::Controller>& cntl)
     : schema_(schema), record_cnt_(record_cnt), buf_size_(buf_size), cntl_(cntl), result_set_base_(nullptr),
-        io_buf_() {}
+        io_buf_(), column_block_() {}
 
 ResultSetSQL::ResultSetSQL(const ::hybridse::vm::Schema& schema, uint32_t record_cnt,
                            const std::shared_ptr<butil::IOBuf>& io_buf)
-    : schema_(schema), record_cnt_(record_cnt), cntl_(), result_set_base_(nullptr), io_buf_(io_buf) {
+    : schema_(schema), record_cnt_(record_cnt), cntl_(), result_set_base_(nullptr), io_buf_(io_buf),
+        column_block_() {
     if (io_buf_) {
         buf_size_ = io_buf_->length();
     }
 }
 
+ResultSetSQL::ResultSetSQL(const ::hybridse::vm::Schema& schema, uint32_t record_cnt,
+                           const std::shared_ptr<std::string>& column_block)
+    : schema_(schema), record_cnt_(record_cnt), buf_size_(0), cntl_(), result_set_base_(nullptr), io_buf_(),
+        column_block_(column_block) {}
+
 ResultSetSQL::~ResultSetSQL() { delete result_set_base_; }
 
 bool ResultSetSQL::Init() {
@@ -59,12 +68,39 @@ bool ResultSetSQL::Init() {
         result_set_base_ = new ResultSetBase(&buf, record_cnt_, buf_size_, std::move(row_view), schema_);
     } else if (io_buf_) {
         result_set_base_ = new ResultSetBase(io_buf_.get(), record_cnt_, buf_size_, std::move(row_view), schema_);
+    } else if (column_block_) {
+        std::unique_ptr<::openmldb::codec::ColumnBlockDecoder> decoder(new ::openmldb::codec::ColumnBlockDecoder());
+        if (!decoder->Init(column_block_->data(), column_block_->size()) || decoder->GetCount() != record_cnt_) {
+            LOG(WARNING) << "invalid column block of " << record_cnt_ << " rows";
+            return false;
+        }
+        result_set_base_ = new ResultSetBase(std::move(decoder), std::move(row_view), schema_);
     } else {
         return false;
     }
     return true;
 }
 
+void ResultSetSQL::AppendEncodedRows(butil::IOBuf* buf) const {
+    if (buf == nullptr) {
+        return;
+    }
+    if (cntl_) {
+        cntl_->response_attachment().append_to(buf, buf_size_);
+    } else if (io_buf_) {
+        io_buf_->append_to(buf, buf_size_);
+    } else if (column_block_) {
+        ::openmldb::codec::ColumnBlockDecoder decoder;
+        if (!decoder.Init(column_block_->data(), column_block_->size())) {
+            return;
+        }
+        std::string row;
+        while (decoder.Next(&row)) {
+            buf->append(row);
+        }
+    }
+}
+
 std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
     const std::shared_ptr<::openmldb::api::QueryResponse>& response, const std::shared_ptr<brpc::Controller>& cntl,
     hybridse::sdk::Status* status) {
@@ -85,6 +121,24 @@ std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
     return rs;
 }
 
+bool ResultSetSQL::UncompressScanAttachment(const ::openmldb::api::ScanResponse& response,
+                                            const butil::IOBuf& attachment, std::string* buf,
+                                            ::hybridse::sdk::Status* status) {
+    if (response.compress_type() == ::openmldb::type::kSnappy) {
+        std::string compressed = attachment.to_string();
+        if (!::snappy::Uncompress(compressed.data(), compressed.size(), buf)) {
+            *status = {::hybridse::common::StatusCode::kCmdError, "fail to uncompress scan response"};
+            return false;
+        }
+    } else if (response.compress_type() == ::openmldb::type::kNoCompress) {
+        attachment.copy_to(buf);
+    } else {
+        *status = {::hybridse::common::StatusCode::kCmdError, "unsupported compress type of scan response"};
+        return false;
+    }
+    return true;
+}
+
 std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
     const std::shared_ptr<::openmldb::api::ScanResponse>& response,
     const ::google::protobuf::RepeatedField<uint32_t>& projection, const std::shared_ptr<brpc::Controller>& cntl,
@@ -94,17 +148,33 @@ std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
     }
     std::shared_ptr<::openmldb::sdk::ResultSetSQL> rs;
     auto sdk_table_handler = dynamic_cast<::openmldb::catalog::SDKTableHandler*>(table_handler.get());
+    ::hybridse::vm::Schema schema;
     if (projection.size() > 0) {
-        ::hybridse::vm::Schema schema;
         bool ok = ::openmldb::schema::SchemaAdapter::SubSchema(sdk_table_handler->GetSchema(), projection, &schema);
         if (!ok) {
             *status = {::hybridse::common::StatusCode::kCmdError, "fail to get sub schema"};
             return {};
         }
+    } else {
+        schema = *(sdk_table_handler->GetSchema());
+    }
+    if (response->format() == ::openmldb::api::kRowFormat &&
+        response->compress_type() == ::openmldb::type::kNoCompress) {
         rs = std::make_shared<openmldb::sdk::ResultSetSQL>(schema, response->count(), response->buf_size(), cntl);
     } else {
-        rs = std::make_shared<openmldb::sdk::ResultSetSQL>(
-            *(sdk_table_handler->GetSchema()), response->count(), response->buf_size(), cntl);
+        // the attachment is uncompressed only when the result set is made, which is out of the rpc callback
+        // for an async scan. the rows of a column block are decoded one by one as they are read
+        auto buf = std::make_shared<std::string>();
+        if (!UncompressScanAttachment(*response, cntl->response_attachment(), buf.get(), status)) {
+            return {};
+        }
+        if (response->format() == ::openmldb::api::kColumnFormat) {
+            rs = std::make_shared<openmldb::sdk::ResultSetSQL>(schema, response->count(), buf);
+        } else {
+            auto io_buf = std::make_shared<butil::IOBuf>();
+            io_buf->append(*buf);
+            rs = std::make_shared<openmldb::sdk::ResultSetSQL>(schema, response->count(), io_buf);
+        }
     }
     if (!rs->Init()) {
         *status = {::hybridse::common::StatusCode::kCmdError, "request error, ResultSetSQL init failed"};
@@ -41,6 +41,10 @@ class ResultSetSQL : public ::hybridse::sdk::ResultSet {
     ResultSetSQL(const ::hybridse::vm::Schema& schema, uint32_t record_cnt,
                  const std::shared_ptr<butil::IOBuf>& io_buf);
 
+    // the rows are decoded from the column block only as the result set advances
+    ResultSetSQL(const ::hybridse::vm::Schema& schema, uint32_t record_cnt,
+                 const std::shared_ptr<std::string>& column_block);
+
     ~ResultSetSQL();
 
     static std::shared_ptr<::hybridse::sdk::ResultSet> MakeResultSet(
@@ -96,6 +100,15 @@ class ResultSetSQL : public ::hybridse::sdk::ResultSet {
 
     int32_t Size() override { return result_set_base_->Size(); }
 
+    // append the rows to `buf` as they are encoded, one after another
+    void AppendEncodedRows(butil::IOBuf* buf) const;
+
+ private:
+    // uncompress the attachment into buf, which is the encoded rows or a column block as the format of response
+    static bool UncompressScanAttachment(const ::openmldb::api::ScanResponse& response,
+                                         const butil::IOBuf& attachment, std::string* buf,
+                                         ::hybridse::sdk::Status* status);
+
  private:
     ::hybridse::vm::Schema schema_;
     uint32_t record_cnt_;
@@ -103,6 +116,7 @@ class ResultSetSQL : public ::hybridse::sdk::ResultSet {
     std::shared_ptr<brpc::Controller> cntl_;
     ResultSetBase* result_set_base_;
     std::shared_ptr<butil::IOBuf> io_buf_;
+    std::shared_ptr<std::string> column_block_;
 };
 
 class MultipleResultSetSQL : public ::hybridse::sdk::ResultSet {
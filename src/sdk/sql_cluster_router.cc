@@ -17,8 +17,11 @@
 #include "sdk/sql_cluster_router.h"
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -30,6 +33,7 @@
 #include "base/ddl_parser.h"
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
+#include "base/taskpool.hpp"
 #include "boost/none.hpp"
 #include "boost/property_tree/ini_parser.hpp"
 #include "boost/property_tree/ptree.hpp"
@@ -52,6 +56,7 @@
 
 DECLARE_string(bucket_size);
 DECLARE_uint32(replica_num);
+DECLARE_uint32(put_batch_max_rows);
 
 namespace openmldb {
 namespace sdk {
@@ -189,6 +194,78 @@ class BatchQueryFutureImpl : public QueryFuture {
     openmldb::RpcCallback<openmldb::api::SQLBatchRequestQueryResponse>* callback_;
 };
 
+// a write may send requests to several partitions, the future waits for all of them
+template <class Response>
+class WriteFutureImpl : public WriteFuture {
+ public:
+    // `ignored_code` is the response code taken as success besides kOk
+    explicit WriteFutureImpl(int32_t ignored_code = ::openmldb::base::kOk) : ignored_code_(ignored_code) {}
+
+    ~WriteFutureImpl() {
+        for (auto callback : callbacks_) {
+            callback->UnRef();
+        }
+    }
+
+    // hold the callback before the request is sent, as the callback may be released once the response arrives
+    void AddCallback(openmldb::RpcCallback<Response>* callback) {
+        callback->Ref();
+        callbacks_.push_back(callback);
+    }
+
+    bool Wait(hybridse::sdk::Status* status) override {
+        if (!status) {
+            return false;
+        }
+        for (auto callback : callbacks_) {
+            brpc::Join(callback->GetController()->call_id());
+        }
+        for (auto callback : callbacks_) {
+            if (callback->GetController()->Failed()) {
+                status->code = hybridse::common::kRpcError;
+                status->msg = "request error, " + callback->GetController()->ErrorText();
+                return false;
+            }
+            int32_t code = callback->GetResponse()->code();
+            if (code != ::openmldb::base::kOk && code != ignored_code_) {
+                status->code = code;
+                status->msg = "request error, " + callback->GetResponse()->msg();
+                return false;
+            }
+        }
+        *status = {};
+        return true;
+    }
+
+    bool IsDone() const override {
+        for (auto callback : callbacks_) {
+            if (!callback->IsDone()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+ private:
+    int32_t ignored_code_;
+    std::vector<openmldb::RpcCallback<Response>*> callbacks_;
+};
+
+// send the request with a new callback held by the future
+template <class Response, class SendFunc>
+static bool AsyncSend(int64_t timeout_ms, WriteFutureImpl<Response>* future, SendFunc send) {
+    auto cntl = std::make_shared<brpc::Controller>();
+    cntl->set_timeout_ms(timeout_ms);
+    auto* callback = new openmldb::RpcCallback<Response>(std::make_shared<Response>(), cntl);
+    future->AddCallback(callback);
+    if (!send(callback)) {
+        // the callback never runs, so release the reference it was created with
+        callback->UnRef();
+        return false;
+    }
+    return true;
+}
+
 SQLClusterRouter::SQLClusterRouter(const SQLRouterOptions& options)
     : options_(std::make_shared<SQLRouterOptions>(options)),
       is_cluster_mode_(true),
@@ -1271,6 +1348,43 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLRequest(co
     return rs;
 }
 
+std::shared_ptr<QueryFuture> SQLClusterRouter::AsyncExecuteSQLRequest(const std::string& db, const std::string& sql,
+                                                                      std::shared_ptr<SQLRequestRow> row,
+                                                                      int64_t timeout_ms,
+                                                                      hybridse::sdk::Status* status) {
+    if (!row || !status) {
+        LOG(WARNING) << "input is invalid";
+        return {};
+    }
+    if (!row->OK()) {
+        status->code = -1;
+        status->msg = "make sure the request row is built before execute sql";
+        LOG(WARNING) << status->msg;
+        return {};
+    }
+    auto client = GetTabletClient(db, sql, hybridse::vm::kRequestMode, row, status);
+    if (0 != status->code) {
+        return {};
+    }
+    if (!client) {
+        status->code = -1;
+        status->msg = "not tablet found";
+        return {};
+    }
+    auto cntl = std::make_shared<::brpc::Controller>();
+    cntl->set_timeout_ms(timeout_ms);
+    auto response = std::make_shared<::openmldb::api::QueryResponse>();
+    auto* callback = new openmldb::RpcCallback<openmldb::api::QueryResponse>(response, cntl);
+    auto future = std::make_shared<QueryFutureImpl>(callback);
+    if (!client->AsyncQuery(db, sql, row->GetRow(), options_->enable_debug, callback)) {
+        callback->UnRef();
+        status->code = -1;
+        status->msg = "fail to send the query to tablet " + client->GetEndpoint();
+        return {};
+    }
+    return future;
+}
+
 std::shared_ptr<::hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLParameterized(
     const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLRequestRow> parameter,
     ::hybridse::sdk::Status* status) {
@@ -1300,6 +1414,40 @@ std::shared_ptr<::hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLParamete
     return ResultSetSQL::MakeResultSet(response, cntl, status);
 }
 
+std::shared_ptr<QueryFuture> SQLClusterRouter::AsyncExecuteSQLParameterized(
+    const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLRequestRow> parameter,
+    int64_t timeout_ms, ::hybridse::sdk::Status* status) {
+    if (!status) {
+        return {};
+    }
+    std::vector<openmldb::type::DataType> parameter_types;
+    if (parameter && !ExtractDBTypes(parameter->GetSchema(), &parameter_types)) {
+        status->msg = "convert parameter types error";
+        status->code = -1;
+        return {};
+    }
+    auto client = GetTabletClientForBatchQuery(db, sql, parameter, status);
+    if (!status->IsOK() || !client) {
+        DLOG(INFO) << "no tablet available for sql '" << sql << "': " << status->msg;
+        status->msg = absl::StrCat("no tablet available for sql: ", status->msg);
+        status->code = -1;
+        return {};
+    }
+    auto cntl = std::make_shared<::brpc::Controller>();
+    cntl->set_timeout_ms(timeout_ms);
+    auto response = std::make_shared<::openmldb::api::QueryResponse>();
+    auto* callback = new openmldb::RpcCallback<openmldb::api::QueryResponse>(response, cntl);
+    auto future = std::make_shared<QueryFutureImpl>(callback);
+    if (!client->AsyncQuery(db, sql, parameter_types, parameter ? parameter->GetRow() : "", options_->enable_debug,
+                            callback)) {
+        callback->UnRef();
+        status->msg = "fail to send the query to tablet " + client->GetEndpoint();
+        status->code = -1;
+        return {};
+    }
+    return future;
+}
+
 std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLBatchRequest(
     const std::string& db, const std::string& sql, std::shared_ptr<SQLRequestRowBatch> row_batch,
     hybridse::sdk::Status* status) {
@@ -1422,8 +1570,137 @@ bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>&
     return true;
 }
 
+// a PutBatch request and the indexes of its rows in the SQLInsertRows
+using PutBatchTask = std::pair<::openmldb::api::PutBatchRequest, std::vector<uint32_t>>;
+
+// group the rows by partition, and split the rows of a partition into requests of put_batch_max_rows at most
+static std::map<uint32_t, std::vector<PutBatchTask>> SplitPutBatchRequests(
+    uint32_t tid, const std::shared_ptr<SQLInsertRows>& rows) {
+    uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
+    std::map<uint32_t, PutBatchTask> requests;
+    for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
+        std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
+        for (const auto& kv : row->GetDimensions()) {
+            auto& request = requests[kv.first];
+            auto put_row = request.first.add_rows();
+            put_row->set_time(cur_ts);
+            put_row->set_value(row->GetRow());
+            for (const auto& dim : kv.second) {
+                auto dimension = put_row->add_dimensions();
+                dimension->set_key(dim.first);
+                dimension->set_idx(dim.second);
+            }
+            request.second.push_back(i);
+        }
+    }
+    uint32_t max_rows = std::max(FLAGS_put_batch_max_rows, 1u);
+    std::map<uint32_t, std::vector<PutBatchTask>> split_requests;
+    for (auto& kv : requests) {
+        uint32_t pid = kv.first;
+        auto& all_rows = *kv.second.first.mutable_rows();
+        const auto& all_idx = kv.second.second;
+        int pos = 0;
+        while (pos < all_rows.size()) {
+            int end = std::min(all_rows.size(), pos + static_cast<int>(max_rows));
+            auto& task = split_requests[pid].emplace_back();
+            task.first.set_tid(tid);
+            task.first.set_pid(pid);
+            for (int idx = pos; idx < end; idx++) {
+                task.first.add_rows()->Swap(all_rows.Mutable(idx));
+                task.second.push_back(all_idx[idx]);
+            }
+            pos = end;
+        }
+    }
+    return split_requests;
+}
+
+bool SQLClusterRouter::PutRows(uint32_t tid, const std::shared_ptr<SQLInsertRows>& rows,
+                               const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                               ::hybridse::sdk::Status* status, uint32_t* put_cnt) {
+    if (status == nullptr) {
+        return false;
+    }
+    // the partitions every row waits for, a row is put once all of its requests succeed
+    std::vector<uint32_t> pending(rows->GetCnt(), 0);
+    for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
+        pending[i] = rows->GetRow(i)->GetDimensions().size();
+    }
+    auto count_put = [&]() {
+        if (put_cnt != nullptr) {
+            *put_cnt = static_cast<uint32_t>(std::count(pending.begin(), pending.end(), 0u));
+        }
+    };
+    for (const auto& kv : SplitPutBatchRequests(tid, rows)) {
+        uint32_t pid = kv.first;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        if (pid < tablets.size() && tablets[pid]) {
+            client = tablets[pid]->GetClient();
+        }
+        if (!client) {
+            status->msg = "fail to get tablet client. pid " + std::to_string(pid);
+            LOG(WARNING) << status->msg;
+            count_put();
+            return false;
+        }
+        bool unsupported = false;
+        for (const auto& task : kv.second) {
+            const auto& request = task.first;
+            DLOG(INFO) << "put batch to endpoint " << client->GetEndpoint() << " pid " << pid << " with rows "
+                       << request.rows_size();
+            std::string msg;
+            if (unsupported || !client->PutBatch(request, &msg, &unsupported)) {
+                if (!unsupported) {
+                    status->msg = "fail to make a put batch request to table. tid " + std::to_string(tid) +
+                                  ", pid " + std::to_string(pid) + ", msg " + msg;
+                    LOG(WARNING) << status->msg;
+                    count_put();
+                    return false;
+                }
+                // the tablet is of an old version, put the rows one by one
+                if (!PutBatchByRow(client, request, status)) {
+                    count_put();
+                    return false;
+                }
+            }
+            for (auto idx : task.second) {
+                pending[idx]--;
+            }
+        }
+    }
+    count_put();
+    return true;
+}
+
+bool SQLClusterRouter::PutBatchByRow(const std::shared_ptr<::openmldb::client::TabletClient>& client,
+                                     const ::openmldb::api::PutBatchRequest& request,
+                                     ::hybridse::sdk::Status* status) {
+    std::vector<std::pair<std::string, uint32_t>> dimensions;
+    for (const auto& row : request.rows()) {
+        dimensions.clear();
+        for (const auto& dim : row.dimensions()) {
+            dimensions.emplace_back(dim.key(), dim.idx());
+        }
+        if (!client->Put(request.tid(), request.pid(), row.time(), row.value(), dimensions)) {
+            status->msg = "fail to make a put request to table. tid " + std::to_string(request.tid()) + ", pid " +
+                          std::to_string(request.pid());
+            LOG(WARNING) << status->msg;
+            return false;
+        }
+    }
+    return true;
+}
+
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                                      hybridse::sdk::Status* status) {
+    return ExecuteInsert(db, sql, rows, status, nullptr);
+}
+
+bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
+                                     hybridse::sdk::Status* status, uint32_t* put_cnt) {
+    if (put_cnt != nullptr) {
+        *put_cnt = 0;
+    }
     if (!rows || !status) {
         LOG(WARNING) << "input is invalid";
         return false;
@@ -1436,13 +1713,7 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             status->msg = "fail to get table " + cache->GetTableName() + " tablet";
             return false;
         }
-        for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
-            std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
-            if (!PutRow(cache->GetTableId(), row, tablets, status)) {
-                return false;
-            }
-        }
-        return true;
+        return PutRows(cache->GetTableId(), rows, tablets, status, put_cnt);
     } else {
         status->msg = "please use getInsertRow with " + sql + " first";
         return false;
@@ -1472,6 +1743,105 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
     }
 }
 
+std::shared_ptr<WriteFuture> SQLClusterRouter::AsyncExecuteInsert(const std::string& db, const std::string& sql,
+                                                                  std::shared_ptr<SQLInsertRow> row,
+                                                                  int64_t timeout_ms, hybridse::sdk::Status* status) {
+    if (!row || !status) {
+        return {};
+    }
+    std::shared_ptr<SQLCache> cache = GetCache(db, sql, hybridse::vm::kBatchMode);
+    if (!cache) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "please use getInsertRow with " + sql + " first"};
+        return {};
+    }
+    std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>> tablets;
+    bool ret = cluster_sdk_->GetTablet(db, cache->GetTableName(), &tablets);
+    if (!ret || tablets.empty()) {
+        *status = {::hybridse::common::StatusCode::kCmdError,
+                   "fail to get table " + cache->GetTableName() + " tablet"};
+        return {};
+    }
+    uint32_t tid = cache->GetTableId();
+    uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
+    auto future = std::make_shared<WriteFutureImpl<::openmldb::api::PutResponse>>();
+    for (const auto& kv : row->GetDimensions()) {
+        uint32_t pid = kv.first;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        if (pid < tablets.size() && tablets[pid]) {
+            client = tablets[pid]->GetClient();
+        }
+        if (!client) {
+            *status = {::hybridse::common::StatusCode::kCmdError,
+                       "fail to get tablet client. pid " + std::to_string(pid)};
+            LOG(WARNING) << status->msg;
+            return {};
+        }
+        const auto& dimensions = kv.second;
+        bool ok = AsyncSend(timeout_ms, future.get(),
+                            [&](openmldb::RpcCallback<::openmldb::api::PutResponse>* callback) {
+                                return client->AsyncPut(tid, pid, cur_ts, row->GetRow(), dimensions, callback);
+                            });
+        if (!ok) {
+            *status = {::hybridse::common::StatusCode::kCmdError,
+                       "fail to make a put request to table. tid " + std::to_string(tid)};
+            LOG(WARNING) << status->msg;
+            return {};
+        }
+    }
+    *status = {};
+    return future;
+}
+
+std::shared_ptr<WriteFuture> SQLClusterRouter::AsyncExecuteInsert(const std::string& db, const std::string& sql,
+                                                                  std::shared_ptr<SQLInsertRows> rows,
+                                                                  int64_t timeout_ms, hybridse::sdk::Status* status) {
+    if (!rows || !status) {
+        return {};
+    }
+    std::shared_ptr<SQLCache> cache = GetCache(db, sql, hybridse::vm::kBatchMode);
+    if (!cache) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "please use getInsertRow with " + sql + " first"};
+        return {};
+    }
+    std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>> tablets;
+    bool ret = cluster_sdk_->GetTablet(db, cache->GetTableName(), &tablets);
+    if (!ret || tablets.empty()) {
+        *status = {::hybridse::common::StatusCode::kCmdError,
+                   "fail to get table " + cache->GetTableName() + " tablet"};
+        return {};
+    }
+    uint32_t tid = cache->GetTableId();
+    auto future = std::make_shared<WriteFutureImpl<::openmldb::api::PutBatchResponse>>();
+    for (const auto& kv : SplitPutBatchRequests(tid, rows)) {
+        uint32_t pid = kv.first;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        if (pid < tablets.size() && tablets[pid]) {
+            client = tablets[pid]->GetClient();
+        }
+        if (!client) {
+            *status = {::hybridse::common::StatusCode::kCmdError,
+                       "fail to get tablet client. pid " + std::to_string(pid)};
+            LOG(WARNING) << status->msg;
+            return {};
+        }
+        for (const auto& task : kv.second) {
+            bool ok = AsyncSend(timeout_ms, future.get(),
+                                [&](openmldb::RpcCallback<::openmldb::api::PutBatchResponse>* callback) {
+                                    return client->AsyncPutBatch(task.first, callback);
+                                });
+            if (!ok) {
+                *status = {::hybridse::common::StatusCode::kCmdError,
+                           "fail to make a put batch request to table. tid " + std::to_string(tid) + ", pid " +
+                               std::to_string(pid)};
+                LOG(WARNING) << status->msg;
+                return {};
+            }
+        }
+    }
+    *status = {};
+    return future;
+}
+
 bool SQLClusterRouter::GetSQLPlan(const std::string& sql, ::hybridse::node::NodeManager* nm,
                                   ::hybridse::node::PlanNodeList* plan) {
     if (nm == NULL || plan == NULL) return false;
@@ -2964,7 +3334,11 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
     if (!base::IsExists(file_path)) {
         return {::hybridse::common::StatusCode::kCmdError, "file not exist"};
     }
-    std::ifstream file(file_path);
+    // read the file in large chunks
+    std::vector<char> read_buf(4 * 1024 * 1024);
+    std::ifstream file;
+    file.rdbuf()->pubsetbuf(read_buf.data(), read_buf.size());
+    file.open(file_path);
     if (!file.is_open()) {
         return {::hybridse::common::StatusCode::kCmdError, "open file failed"};
     }
@@ -2992,7 +3366,9 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
             }
         }
         // then read the first row of data
-        std::getline(file, line);
+        if (!std::getline(file, line)) {
+            return {0, "Load 0 rows"};
+        }
     }
 
     // build placeholder
@@ -3008,58 +3384,121 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
             str_cols_idx.emplace_back(i);
         }
     }
-    uint64_t i = 0;
-    do {
-        cols.clear();
-        std::string error;
-        ::openmldb::sdk::SplitLineWithDelimiterForStrings(line, options_parse.GetDelimiter(), &cols,
-                                                          options_parse.GetQuote());
-        auto ret = InsertOneRow(database, insert_placeholder, str_cols_idx, options_parse.GetNullValue(), cols);
-        if (!ret.IsOK()) {
-            return {::hybridse::common::StatusCode::kCmdError, "line [" + line + "] insert failed, " + ret.msg};
-        }
-        ++i;
-    } while (std::getline(file, line));
-    return {0, "Load " + std::to_string(i) + " rows"};
+    // fill the insert cache before the workers start
+    if (!GetInsertRows(database, insert_placeholder, &status)) {
+        return {::hybridse::common::StatusCode::kCmdError, "get insert rows failed, " + status.msg};
+    }
+
+    // the lines are read by this thread and cut into chunks, the workers parse and encode the chunks,
+    // then route the rows to partitions and put them in batch. the bounded queue of the pool limits
+    // the chunks in flight
+    uint32_t chunk_size = std::max(FLAGS_put_batch_max_rows, 1u);
+    uint32_t thread_num = options_parse.GetThread();
+    // the line number in the file of the first line of the next chunk
+    uint64_t line_no = options_parse.GetHeader() ? 2 : 1;
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> load_cnt{0};
+    std::mutex load_mu;
+    hybridse::sdk::Status load_status;
+    // the line ranges of the failed chunks
+    std::vector<std::pair<uint64_t, uint64_t>> failed_chunks;
+    {
+        ::openmldb::base::TaskPool load_pool(thread_num, thread_num * 2);
+        auto submit = [&](std::shared_ptr<std::vector<std::string>> chunk) {
+            uint64_t first_line = line_no;
+            line_no += chunk->size();
+            load_pool.AddTask([&, chunk, first_line] {
+                if (failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                uint32_t put_cnt = 0;
+                auto ret = InsertLines(database, insert_placeholder, str_cols_idx, options_parse.GetNullValue(),
+                                       options_parse.GetDelimiter(), options_parse.GetQuote(), *chunk, &put_cnt);
+                load_cnt.fetch_add(put_cnt, std::memory_order_relaxed);
+                if (!ret.IsOK()) {
+                    std::lock_guard<std::mutex> lock(load_mu);
+                    failed_chunks.emplace_back(first_line, first_line + chunk->size() - 1);
+                    if (!failed.exchange(true)) {
+                        load_status = ret;
+                    }
+                }
+            });
+        };
+        auto chunk = std::make_shared<std::vector<std::string>>();
+        chunk->reserve(chunk_size);
+        do {
+            chunk->emplace_back(std::move(line));
+            if (chunk->size() >= chunk_size) {
+                submit(chunk);
+                chunk = std::make_shared<std::vector<std::string>>();
+                chunk->reserve(chunk_size);
+            }
+        } while (!failed.load(std::memory_order_relaxed) && std::getline(file, line));
+        if (!chunk->empty()) {
+            submit(chunk);
+        }
+        load_pool.Stop();
+    }
+    if (failed.load(std::memory_order_relaxed)) {
+        // the chunks still in the queue are skipped after the first failure
+        std::sort(failed_chunks.begin(), failed_chunks.end());
+        std::string chunks_msg;
+        for (const auto& range : failed_chunks) {
+            chunks_msg += (chunks_msg.empty() ? "" : ", ") + std::to_string(range.first) + "-" +
+                          std::to_string(range.second);
+        }
+        return {::hybridse::common::StatusCode::kCmdError,
+                load_status.msg + ", " + std::to_string(load_cnt.load(std::memory_order_relaxed)) +
+                    " rows have been loaded. the failed chunks of lines " + chunks_msg +
+                    " may be partially loaded, and the lines after the first failure may not be loaded"};
+    }
+    return {0, "Load " + std::to_string(load_cnt.load(std::memory_order_relaxed)) + " rows"};
 }
 
-hybridse::sdk::Status SQLClusterRouter::InsertOneRow(const std::string& database, const std::string& insert_placeholder,
-                                                     const std::vector<int>& str_col_idx, const std::string& null_value,
-                                                     const std::vector<std::string>& cols) {
-    if (cols.empty()) {
-        return {::hybridse::common::StatusCode::kCmdError, "cols is empty"};
-    }
+hybridse::sdk::Status SQLClusterRouter::InsertLines(const std::string& database, const std::string& insert_placeholder,
+                                                    const std::vector<int>& str_col_idx, const std::string& null_value,
+                                                    const std::string& delimiter, char quote,
+                                                    const std::vector<std::string>& lines, uint32_t* put_cnt) {
+    *put_cnt = 0;
     if (database.empty()) {
         return {::hybridse::common::StatusCode::kCmdError, "database is empty"};
     }
     hybridse::sdk::Status status;
-    auto row = GetInsertRow(database, insert_placeholder, &status);
-    if (!row) {
+    auto rows = GetInsertRows(database, insert_placeholder, &status);
+    if (!rows) {
         return status;
     }
-    // build row from cols
-    auto& schema = row->GetSchema();
+    auto schema = rows->GetSchema();
     auto cnt = schema->GetColumnCnt();
-    if (cnt != static_cast<int>(cols.size())) {
-        return {::hybridse::common::StatusCode::kCmdError, "col size mismatch"};
-    }
-    // scan all strings , calc the sum, to init SQLInsertRow's string length
-    std::string::size_type str_len_sum = 0;
-    for (auto idx : str_col_idx) {
-        if (cols[idx] != null_value) {
-            str_len_sum += cols[idx].length();
+    std::vector<std::string> cols;
+    for (const auto& line : lines) {
+        cols.clear();
+        ::openmldb::sdk::SplitLineWithDelimiterForStrings(line, delimiter, &cols, quote);
+        if (cnt != static_cast<int>(cols.size())) {
+            return {::hybridse::common::StatusCode::kCmdError, "line [" + line + "] insert failed, col size mismatch"};
+        }
+        // scan all strings , calc the sum, to init SQLInsertRow's string length
+        std::string::size_type str_len_sum = 0;
+        for (auto idx : str_col_idx) {
+            if (cols[idx] != null_value) {
+                str_len_sum += cols[idx].length();
+            }
         }
-    }
-    row->Init(static_cast<int>(str_len_sum));
-
-    for (int i = 0; i < cnt; ++i) {
-        if (!::openmldb::codec::AppendColumnValue(cols[i], schema->GetColumnType(i), schema->IsColumnNotNull(i),
-                                                  null_value, row)) {
-            return {::hybridse::common::StatusCode::kCmdError, "translate to insert row failed"};
+        auto row = rows->NewRow();
+        if (!row) {
+            return {::hybridse::common::StatusCode::kCmdError, "line [" + line + "] insert failed, new row failed"};
+        }
+        row->Init(static_cast<int>(str_len_sum));
+        for (int i = 0; i < cnt; ++i) {
+            if (!::openmldb::codec::AppendColumnValue(cols[i], schema->GetColumnType(i), schema->IsColumnNotNull(i),
+                                                      null_value, row)) {
+                return {::hybridse::common::StatusCode::kCmdError,
+                        "line [" + line + "] insert failed, translate to insert row failed"};
+            }
         }
     }
-    if (!ExecuteInsert(database, insert_placeholder, row, &status)) {
-        return {::hybridse::common::StatusCode::kCmdError, "insert row failed"};
+    if (!ExecuteInsert(database, insert_placeholder, rows, &status, put_cnt)) {
+        return {::hybridse::common::StatusCode::kCmdError, "insert rows failed, " + status.msg};
     }
     return {};
 }
@@ -3167,6 +3606,47 @@ bool SQLClusterRouter::ExecuteDelete(std::shared_ptr<SQLDeleteRow> row, hybridse
     return true;
 }
 
+std::shared_ptr<WriteFuture> SQLClusterRouter::AsyncExecuteDelete(std::shared_ptr<SQLDeleteRow> row,
+                                                                  int64_t timeout_ms, hybridse::sdk::Status* status) {
+    if (!row || !status) {
+        return {};
+    }
+    const auto& db = row->GetDatabase();
+    const auto& table_name = row->GetTableName();
+    auto table_info = cluster_sdk_->GetTableInfo(db, table_name);
+    if (!table_info) {
+        *status = {::hybridse::common::StatusCode::kCmdError,
+                   "table " + table_name + " in db " + db + " does not exist"};
+        return {};
+    }
+    const auto& pk = row->GetValue();
+    const auto& index_name = row->GetIndexName();
+    uint32_t pid = ::openmldb::base::hash64(pk) % table_info->table_partition_size();
+    auto tablet = cluster_sdk_->GetTablet(db, table_name, pk);
+    if (!tablet) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "cannot connect tablet"};
+        return {};
+    }
+    auto tablet_client = tablet->GetClient();
+    if (!tablet_client) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "tablet client is null"};
+        return {};
+    }
+    // deleting a key that does not exist is not an error, the same as ExecuteDelete
+    auto future = std::make_shared<WriteFutureImpl<::openmldb::api::GeneralResponse>>(
+        ::openmldb::base::ReturnCode::kDeleteFailed);
+    bool ok = AsyncSend(timeout_ms, future.get(),
+                        [&](openmldb::RpcCallback<::openmldb::api::GeneralResponse>* callback) {
+                            return tablet_client->AsyncDelete(table_info->tid(), pid, pk, index_name, callback);
+                        });
+    if (!ok) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "fail to send the delete request"};
+        return {};
+    }
+    *status = {};
+    return future;
+}
+
 hybridse::sdk::Status SQLClusterRouter::HandleCreateFunction(const hybridse::node::CreateFunctionPlanNode* node) {
     if (node == nullptr) {
         return {::hybridse::common::StatusCode::kCmdError, "illegal create function statement"};
@@ -74,6 +74,17 @@ class SQLClusterRouter : public SQLRouter {
 
     bool ExecuteDelete(std::shared_ptr<SQLDeleteRow> row, hybridse::sdk::Status* status) override;
 
+    std::shared_ptr<WriteFuture> AsyncExecuteInsert(const std::string& db, const std::string& sql,
+                                                    std::shared_ptr<SQLInsertRow> row, int64_t timeout_ms,
+                                                    hybridse::sdk::Status* status) override;
+
+    std::shared_ptr<WriteFuture> AsyncExecuteInsert(const std::string& db, const std::string& sql,
+                                                    std::shared_ptr<SQLInsertRows> rows, int64_t timeout_ms,
+                                                    hybridse::sdk::Status* status) override;
+
+    std::shared_ptr<WriteFuture> AsyncExecuteDelete(std::shared_ptr<SQLDeleteRow> row, int64_t timeout_ms,
+                                                    hybridse::sdk::Status* status) override;
+
     std::shared_ptr<TableReader> GetTableReader() override;
 
     std::shared_ptr<ExplainInfo> Explain(const std::string& db, const std::string& sql,
@@ -97,6 +108,10 @@ class SQLClusterRouter : public SQLRouter {
                                                                 std::shared_ptr<SQLRequestRow> row,
                                                                 hybridse::sdk::Status* status) override;
 
+    std::shared_ptr<QueryFuture> AsyncExecuteSQLRequest(const std::string& db, const std::string& sql,
+                                                        std::shared_ptr<SQLRequestRow> row, int64_t timeout_ms,
+                                                        hybridse::sdk::Status* status) override;
+
     std::shared_ptr<hybridse::sdk::ResultSet> ExecuteSQL(const std::string& sql,
                                                          ::hybridse::sdk::Status* status) override;
 
@@ -115,6 +130,11 @@ class SQLClusterRouter : public SQLRouter {
     std::shared_ptr<hybridse::sdk::ResultSet> ExecuteSQLParameterized(const std::string& db, const std::string& sql,
                                                                       std::shared_ptr<SQLRequestRow> parameter,
                                                                       ::hybridse::sdk::Status* status) override;
+    /// Execute batch SQL with parameter row, return once the query is sent
+    std::shared_ptr<QueryFuture> AsyncExecuteSQLParameterized(const std::string& db, const std::string& sql,
+                                                              std::shared_ptr<SQLRequestRow> parameter,
+                                                              int64_t timeout_ms,
+                                                              hybridse::sdk::Status* status) override;
 
     std::shared_ptr<hybridse::sdk::ResultSet> ExecuteSQLBatchRequest(const std::string& db, const std::string& sql,
                                                                      std::shared_ptr<SQLRequestRowBatch> row_batch,
@@ -258,6 +278,20 @@ class SQLClusterRouter : public SQLRouter {
                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
                 ::hybridse::sdk::Status* status);
 
+    // insert the rows and set `put_cnt` to the rows acknowledged by all of their partitions, even if it fails
+    bool ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
+                       hybridse::sdk::Status* status, uint32_t* put_cnt);
+
+    // group the rows by partition and send one PutBatch request per partition. it falls back
+    // to put the rows one by one if the tablet does not support PutBatch. `put_cnt` is set to
+    // the rows whose requests all succeed, if not null
+    bool PutRows(uint32_t tid, const std::shared_ptr<SQLInsertRows>& rows,
+                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                 ::hybridse::sdk::Status* status, uint32_t* put_cnt = nullptr);
+
+    bool PutBatchByRow(const std::shared_ptr<::openmldb::client::TabletClient>& client,
+                       const ::openmldb::api::PutBatchRequest& request, ::hybridse::sdk::Status* status);
+
     bool IsConstQuery(::hybridse::vm::PhysicalOpNode* node);
     std::shared_ptr<SQLCache> GetCache(const std::string& db, const std::string& sql,
                                        hybridse::vm::EngineMode engine_mode);
@@ -303,9 +337,11 @@ class SQLClusterRouter : public SQLRouter {
                                                const std::string& file_path,
                                                const std::shared_ptr<hybridse::node::OptionsMap>& options);
 
-    hybridse::sdk::Status InsertOneRow(const std::string& database, const std::string& insert_placeholder,
-                                       const std::vector<int>& str_col_idx, const std::string& null_value,
-                                       const std::vector<std::string>& cols);
+    // parse the csv lines and insert them in batch, `put_cnt` is set to the rows acknowledged by the tablets
+    hybridse::sdk::Status InsertLines(const std::string& database, const std::string& insert_placeholder,
+                                      const std::vector<int>& str_col_idx, const std::string& null_value,
+                                      const std::string& delimiter, char quote, const std::vector<std::string>& lines,
+                                      uint32_t* put_cnt);
 
     hybridse::sdk::Status HandleDeploy(const std::string& db, const hybridse::node::DeployPlanNode* deploy_node);
 
@@ -85,6 +85,16 @@ class QueryFuture {
     virtual bool IsDone() const = 0;
 };
 
+class WriteFuture {
+ public:
+    WriteFuture() {}
+    virtual ~WriteFuture() {}
+
+    // wait for all the requests of the write, return false if any of them fails
+    virtual bool Wait(hybridse::sdk::Status* status) = 0;
+    virtual bool IsDone() const = 0;
+};
+
 class SQLRouter {
  public:
     SQLRouter() {}
@@ -110,6 +120,26 @@ class SQLRouter {
 
     virtual bool ExecuteDelete(std::shared_ptr<openmldb::sdk::SQLDeleteRow> row, hybridse::sdk::Status* status) = 0;
 
+    // the async apis return once the requests are sent, and nullptr if any of them can not be sent.
+    // the requests have been sent may still take effect in that case. the routers without them
+    // return nullptr with kCmdError
+    virtual std::shared_ptr<openmldb::sdk::WriteFuture> AsyncExecuteInsert(
+        const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLInsertRow> row,
+        int64_t timeout_ms, hybridse::sdk::Status* status) {
+        return AsyncNotSupported<openmldb::sdk::WriteFuture>(status);
+    }
+
+    virtual std::shared_ptr<openmldb::sdk::WriteFuture> AsyncExecuteInsert(
+        const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLInsertRows> rows,
+        int64_t timeout_ms, hybridse::sdk::Status* status) {
+        return AsyncNotSupported<openmldb::sdk::WriteFuture>(status);
+    }
+
+    virtual std::shared_ptr<openmldb::sdk::WriteFuture> AsyncExecuteDelete(
+        std::shared_ptr<openmldb::sdk::SQLDeleteRow> row, int64_t timeout_ms, hybridse::sdk::Status* status) {
+        return AsyncNotSupported<openmldb::sdk::WriteFuture>(status);
+    }
+
     virtual std::shared_ptr<openmldb::sdk::TableReader> GetTableReader() = 0;
 
     virtual std::shared_ptr<ExplainInfo> Explain(const std::string& db, const std::string& sql,
@@ -134,6 +164,12 @@ class SQLRouter {
         const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLRequestRow> row,
         hybridse::sdk::Status* status) = 0;
 
+    virtual std::shared_ptr<openmldb::sdk::QueryFuture> AsyncExecuteSQLRequest(
+        const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLRequestRow> row,
+        int64_t timeout_ms, hybridse::sdk::Status* status) {
+        return AsyncNotSupported<openmldb::sdk::QueryFuture>(status);
+    }
+
     virtual std::shared_ptr<hybridse::sdk::ResultSet> ExecuteSQL(const std::string& db, const std::string& sql,
                                                                  hybridse::sdk::Status* status) = 0;
 
@@ -153,6 +189,12 @@ class SQLRouter {
         const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLRequestRow> parameter,
         hybridse::sdk::Status* status) = 0;
 
+    virtual std::shared_ptr<openmldb::sdk::QueryFuture> AsyncExecuteSQLParameterized(
+        const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLRequestRow> parameter,
+        int64_t timeout_ms, hybridse::sdk::Status* status) {
+        return AsyncNotSupported<openmldb::sdk::QueryFuture>(status);
+    }
+
     virtual std::shared_ptr<hybridse::sdk::ResultSet> ExecuteSQLBatchRequest(
         const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLRequestRowBatch> row_batch,
         ::hybridse::sdk::Status* status) = 0;
@@ -205,6 +247,15 @@ class SQLRouter {
     virtual bool NotifyTableChange() = 0;
 
     virtual bool IsOnlineMode() = 0;
+
+ protected:
+    template <class Future>
+    static std::shared_ptr<Future> AsyncNotSupported(hybridse::sdk::Status* status) {
+        if (status != nullptr) {
+            *status = {::hybridse::common::StatusCode::kCmdError, "async api is not supported"};
+        }
+        return {};
+    }
 };
 
 std::shared_ptr<SQLRouter> NewClusterSQLRouter(const SQLRouterOptions& options);
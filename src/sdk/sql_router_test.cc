@@ -923,6 +923,89 @@ TEST_F(SQLRouterTest, smoketest_on_sql) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(SQLRouterTest, smoketest_async_api) {
+    std::string name = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router_->CreateDB(db, &status));
+    std::string ddl = "create table " + name + "(col1 string, col2 bigint, index(key=col1, ts=col2)) "
+                      "options(partitionnum=4);";
+    ASSERT_TRUE(router_->ExecuteDDL(db, ddl, &status)) << status.msg;
+    ASSERT_TRUE(router_->RefreshCatalog());
+    std::string insert = "insert into " + name + " values(?, ?);";
+
+    std::vector<std::shared_ptr<WriteFuture>> futures;
+    for (int i = 0; i < 10; i++) {
+        auto row = router_->GetInsertRow(db, insert, &status);
+        ASSERT_TRUE(row != nullptr);
+        std::string key = "key" + std::to_string(i);
+        ASSERT_TRUE(row->Init(key.size()));
+        ASSERT_TRUE(row->AppendString(key));
+        ASSERT_TRUE(row->AppendInt64(1000 + i));
+        ASSERT_TRUE(row->Build());
+        auto future = router_->AsyncExecuteInsert(db, insert, row, 1000, &status);
+        ASSERT_TRUE(future != nullptr) << status.msg;
+        futures.push_back(future);
+    }
+    auto rows = router_->GetInsertRows(db, insert, &status);
+    ASSERT_TRUE(rows != nullptr);
+    for (int i = 10; i < 20; i++) {
+        auto row = rows->NewRow();
+        std::string key = "key" + std::to_string(i);
+        ASSERT_TRUE(row->Init(key.size()));
+        ASSERT_TRUE(row->AppendString(key));
+        ASSERT_TRUE(row->AppendInt64(1000 + i));
+        ASSERT_TRUE(row->Build());
+    }
+    auto rows_future = router_->AsyncExecuteInsert(db, insert, rows, 1000, &status);
+    ASSERT_TRUE(rows_future != nullptr) << status.msg;
+    futures.push_back(rows_future);
+    for (auto& future : futures) {
+        ASSERT_TRUE(future->Wait(&status)) << status.msg;
+        ASSERT_TRUE(future->IsDone());
+    }
+
+    auto delete_row = router_->GetDeleteRow(db, "delete from " + name + " where col1 = ?;", &status);
+    ASSERT_TRUE(delete_row != nullptr) << status.msg;
+    ASSERT_TRUE(delete_row->SetString(1, "key0"));
+    ASSERT_TRUE(delete_row->Build());
+    auto delete_future = router_->AsyncExecuteDelete(delete_row, 1000, &status);
+    ASSERT_TRUE(delete_future != nullptr) << status.msg;
+    ASSERT_TRUE(delete_future->Wait(&status)) << status.msg;
+
+    std::string sql_select = "select col1, col2 from " + name + " where col2 > ?;";
+    auto parameter_types = std::make_shared<hybridse::sdk::ColumnTypes>();
+    parameter_types->AddColumnType(::hybridse::sdk::kTypeInt64);
+    auto parameter = SQLRequestRow::CreateSQLRequestRowFromColumnTypes(parameter_types);
+    ASSERT_TRUE(parameter->Init(0));
+    ASSERT_TRUE(parameter->AppendInt64(1009));
+    ASSERT_TRUE(parameter->Build());
+    auto query_future = router_->AsyncExecuteSQLParameterized(db, sql_select, parameter, 1000, &status);
+    ASSERT_TRUE(query_future != nullptr) << status.msg;
+    auto rs = query_future->GetResultSet(&status);
+    ASSERT_TRUE(rs != nullptr) << status.msg;
+    ASSERT_EQ(10, rs->Size());
+
+    std::string sql_window = "select col1, sum(col2) over w as sum_col2 from " + name +
+                             " window w as (partition by col1 order by col2 ROWS BETWEEN 3 PRECEDING AND CURRENT ROW);";
+    auto request_row = router_->GetRequestRow(db, sql_window, &status);
+    ASSERT_TRUE(request_row != nullptr) << status.msg;
+    ASSERT_TRUE(request_row->Init(5));
+    ASSERT_TRUE(request_row->AppendString("key15"));
+    ASSERT_TRUE(request_row->AppendInt64(2000));
+    ASSERT_TRUE(request_row->Build());
+    query_future = router_->AsyncExecuteSQLRequest(db, sql_window, request_row, 1000, &status);
+    ASSERT_TRUE(query_future != nullptr) << status.msg;
+    rs = query_future->GetResultSet(&status);
+    ASSERT_TRUE(rs != nullptr) << status.msg;
+    ASSERT_EQ(1, rs->Size());
+    ASSERT_TRUE(rs->Next());
+    ASSERT_EQ(3015, rs->GetInt64Unsafe(1));
+
+    ASSERT_TRUE(router_->ExecuteDDL(db, "drop table " + name + ";", &status));
+    ASSERT_TRUE(router_->DropDB(db, &status));
+}
+
 TEST_F(SQLRouterTest, smoke_explain_on_sql) {
     std::string name = "test" + GenRand();
     std::string db = "db" + GenRand();
@@ -30,6 +30,11 @@ struct ScanOption {
     std::string idx_name;
     uint32_t limit = 0;
     std::vector<std::string> projection;
+    // return the projected columns column by column, which is smaller after compression.
+    // it only takes effect with projection
+    bool column_format = false;
+    // compress the scan response with snappy
+    bool compress = false;
 };
 
 class ScanFuture {
@@ -137,6 +137,12 @@ std::shared_ptr<openmldb::sdk::ScanFuture> TableReaderImpl::AsyncScan(const std:
     if (!so.idx_name.empty()) {
         request.set_idx_name(so.idx_name);
     }
+    if (so.column_format) {
+        request.set_format(::openmldb::api::kColumnFormat);
+    }
+    if (so.compress) {
+        request.set_compress_type(::openmldb::type::kSnappy);
+    }
     auto scan_future = std::make_shared<ScanFutureImpl>(callback, request.projection(), table_handler);
     client->AsyncScan(request, callback);
     return scan_future;
@@ -185,6 +191,12 @@ std::shared_ptr<hybridse::sdk::ResultSet> TableReaderImpl::Scan(const std::strin
     if (!so.idx_name.empty()) {
         request.set_idx_name(so.idx_name);
     }
+    if (so.column_format) {
+        request.set_format(::openmldb::api::kColumnFormat);
+    }
+    if (so.compress) {
+        request.set_compress_type(::openmldb::type::kSnappy);
+    }
     auto response = std::make_shared<::openmldb::api::ScanResponse>();
     auto cntl = std::make_shared<::brpc::Controller>();
     client->Scan(request, cntl.get(), response.get());
@@ -1055,6 +1055,115 @@ bool AvgAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
     return true;
 }
 
+MergeableAggregator::MergeableAggregator(const ::openmldb::api::TableMeta& base_meta,
+                                         const ::openmldb::api::TableMeta& aggr_meta,
+                                         std::shared_ptr<Table> aggr_table,
+                                         std::shared_ptr<LogReplicator> aggr_replicator, const uint32_t& index_pos,
+                                         const std::string& aggr_col, const AggrType& aggr_type,
+                                         const std::string& ts_col, WindowType window_tpye, uint32_t window_size)
+    : Aggregator(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos, aggr_col, aggr_type, ts_col, window_tpye,
+                 window_size) {}
+
+bool MergeableAggregator::UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr,
+                                        AggrBuffer* aggr_buffer) {
+    if (row_view.IsNULL(row_ptr, aggr_col_idx_)) {
+        return true;
+    }
+    if (!aggr_buffer->state_) {
+        aggr_buffer->state_ = NewState();
+    }
+    if (!UpdateState(row_view, row_ptr, aggr_buffer->state_.get())) {
+        return false;
+    }
+    aggr_buffer->non_null_cnt_++;
+    return true;
+}
+
+bool MergeableAggregator::EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) {
+    if (buffer.state_) {
+        buffer.state_->Encode(aggr_val);
+    } else {
+        NewState()->Encode(aggr_val);
+    }
+    return true;
+}
+
+bool MergeableAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
+    char* aggr_val = NULL;
+    uint32_t ch_length = 0;
+    if (aggr_row_view_.GetValue(row_ptr, 4, &aggr_val, &ch_length) == 1) {
+        return true;
+    }
+    auto state = NewState();
+    if (!state->Decode(aggr_val, ch_length)) {
+        PDLOG(ERROR, "decode aggr state failed");
+        return false;
+    }
+    buffer->state_ = std::move(state);
+    return true;
+}
+
+DistinctCountAggregator::DistinctCountAggregator(const ::openmldb::api::TableMeta& base_meta,
+                                                 const ::openmldb::api::TableMeta& aggr_meta,
+                                                 std::shared_ptr<Table> aggr_table,
+                                                 std::shared_ptr<LogReplicator> aggr_replicator,
+                                                 const uint32_t& index_pos, const std::string& aggr_col,
+                                                 const AggrType& aggr_type, const std::string& ts_col,
+                                                 WindowType window_tpye, uint32_t window_size)
+    : MergeableAggregator(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos, aggr_col, aggr_type, ts_col,
+                          window_tpye, window_size) {}
+
+bool DistinctCountAggregator::UpdateState(const codec::RowView& row_view, const int8_t* row_ptr, AggrState* state) {
+    auto distinct_state = static_cast<DistinctState*>(state);
+    switch (aggr_col_type_) {
+        case DataType::kSmallInt: {
+            int16_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            distinct_state->Add(reinterpret_cast<char*>(&val), sizeof(int16_t));
+            break;
+        }
+        case DataType::kDate:
+        case DataType::kInt: {
+            int32_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            distinct_state->Add(reinterpret_cast<char*>(&val), sizeof(int32_t));
+            break;
+        }
+        case DataType::kTimestamp:
+        case DataType::kBigInt: {
+            int64_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            distinct_state->Add(reinterpret_cast<char*>(&val), sizeof(int64_t));
+            break;
+        }
+        case DataType::kFloat: {
+            float val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            distinct_state->Add(reinterpret_cast<char*>(&val), sizeof(float));
+            break;
+        }
+        case DataType::kDouble: {
+            double val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            distinct_state->Add(reinterpret_cast<char*>(&val), sizeof(double));
+            break;
+        }
+        case DataType::kString:
+        case DataType::kVarchar: {
+            char* ch = NULL;
+            uint32_t ch_length = 0;
+            row_view.GetValue(row_ptr, aggr_col_idx_, &ch, &ch_length);
+            distinct_state->Add(ch, ch_length);
+            break;
+        }
+        default: {
+            PDLOG(ERROR, "Unsupported data type");
+            return false;
+        }
+    }
+    return true;
+}
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              const ::openmldb::api::TableMeta& aggr_meta,
                                              std::shared_ptr<Table> aggr_table,
@@ -1117,6 +1226,10 @@ std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& b
     } else if (aggr_type == "avg" || aggr_type == "avg_where") {
         agg = std::make_shared<AvgAggregator>(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos, aggr_col,
                                               AggrType::kAvg, ts_col, window_type, window_size);
+    } else if (aggr_type == "distinct_count") {
+        agg = std::make_shared<DistinctCountAggregator>(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos,
+                                                        aggr_col, AggrType::kDistinctCount, ts_col, window_type,
+                                                        window_size);
     } else {
         PDLOG(ERROR, "Unsupported aggregate function type");
         return {};
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "codec/codec.h"
+#include "codec/distinct_values.h"
 #include "proto/tablet.pb.h"
 #include "proto/type.pb.h"
 #include "replica/log_replicator.h"
@@ -43,6 +44,7 @@ enum class AggrType {
     kMax = 3,
     kCount = 4,
     kAvg = 5,
+    kDistinctCount = 6,
 };
 
 enum class WindowType {
@@ -56,6 +58,35 @@ enum class AggrStat {
     kInited = 3,
 };
 
+// The partial state of an aggregate function which does not fit in AggrVal, e.g. the distinct values of
+// distinct_count. It is encoded into the aggr_val column of the pre-aggr table, and the request path merges
+// the states of the buckets instead of scanning the base rows.
+class AggrState {
+ public:
+    virtual ~AggrState() = default;
+    virtual std::unique_ptr<AggrState> Clone() const = 0;
+    virtual void Encode(std::string* output) const = 0;
+    virtual bool Decode(const char* data, uint32_t size) = 0;
+};
+
+// the distinct values, each value is kept as its encoded bytes in the row. the values and their encoding are
+// shared with the request path of hybridse. a bucket of more than DistinctValues::kDefaultMaxExact values is
+// marked overflowed instead, and the request path counts the base rows of its range
+class DistinctState : public AggrState {
+ public:
+    std::unique_ptr<AggrState> Clone() const override { return std::make_unique<DistinctState>(*this); }
+    void Encode(std::string* output) const override { vals_.Encode(output); }
+    // merge the encoded values into the state
+    bool Decode(const char* data, uint32_t size) override { return vals_.MergeEncoded(data, size); }
+
+    void Add(const char* data, uint32_t size) { vals_.Add(data, size); }
+    uint64_t Count() const { return vals_.Count(); }
+    bool IsOverflowed() const { return vals_.IsOverflowed(); }
+
+ private:
+    ::hybridse::codec::DistinctValues vals_{::hybridse::codec::DistinctValues::kDefaultMaxExact};
+};
+
 class AggrBuffer {
  public:
     union AggrVal {
@@ -75,6 +106,8 @@ class AggrBuffer {
     int64_t non_null_cnt_;
     int32_t aggr_cnt_;
     DataType data_type_;
+    // only used by the mergeable aggregators, null until the first value is updated
+    std::unique_ptr<AggrState> state_;
     AggrBuffer() : aggr_val_(), ts_begin_(-1), ts_end_(0), binlog_offset_(0), non_null_cnt_(0), aggr_cnt_(0) {}
     AggrBuffer(const AggrBuffer& buffer) {
         memcpy(&aggr_val_, &buffer.aggr_val_, sizeof(aggr_val_));
@@ -84,6 +117,9 @@ class AggrBuffer {
         binlog_offset_ = buffer.binlog_offset_;
         non_null_cnt_ = buffer.non_null_cnt_;
         data_type_ = buffer.data_type_;
+        if (buffer.state_) {
+            state_ = buffer.state_->Clone();
+        }
         if (data_type_ == DataType::kString || data_type_ == DataType::kVarchar) {
             if (buffer.aggr_val_.vstring.data != NULL) {
                 aggr_val_.vstring.data = new char[buffer.aggr_val_.vstring.len];
@@ -100,6 +136,7 @@ class AggrBuffer {
             }
         }
         memset(&aggr_val_, 0, sizeof(aggr_val_));
+        state_.reset();
         ts_begin_ = -1;
         ts_end_ = 0;
         aggr_cnt_ = 0;
@@ -303,6 +340,47 @@ class AvgAggregator : public Aggregator {
     bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
 };
 
+// The base of the aggregators whose bucket value is an AggrState. A new aggregate function only needs
+// to define its state and how a base row updates it, the states of the buckets are merged in the
+// request path by the aggregator of hybridse with the same encoding.
+class MergeableAggregator : public Aggregator {
+ public:
+    MergeableAggregator(const ::openmldb::api::TableMeta& base_meta, const ::openmldb::api::TableMeta& aggr_meta,
+                        std::shared_ptr<Table> aggr_table, std::shared_ptr<LogReplicator> aggr_replicator,
+                        const uint32_t& index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+                        const std::string& ts_col, WindowType window_tpye, uint32_t window_size);
+
+    ~MergeableAggregator() = default;
+
+ protected:
+    virtual std::unique_ptr<AggrState> NewState() const = 0;
+
+    // update the state by a not null value of the aggr column
+    virtual bool UpdateState(const codec::RowView& row_view, const int8_t* row_ptr, AggrState* state) = 0;
+
+ private:
+    bool UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) override;
+
+    bool EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) override;
+
+    bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
+};
+
+class DistinctCountAggregator : public MergeableAggregator {
+ public:
+    DistinctCountAggregator(const ::openmldb::api::TableMeta& base_meta, const ::openmldb::api::TableMeta& aggr_meta,
+                            std::shared_ptr<Table> aggr_table, std::shared_ptr<LogReplicator> aggr_replicator,
+                            const uint32_t& index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+                            const std::string& ts_col, WindowType window_tpye, uint32_t window_size);
+
+    ~DistinctCountAggregator() = default;
+
+ private:
+    std::unique_ptr<AggrState> NewState() const override { return std::make_unique<DistinctState>(); }
+
+    bool UpdateState(const codec::RowView& row_view, const int8_t* row_ptr, AggrState* state) override;
+};
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              const ::openmldb::api::TableMeta& aggr_meta,
                                              std::shared_ptr<Table> aggr_table,
@@ -701,6 +701,90 @@ TEST_F(AggregatorTest, AvgAggregatorUpdate) {
     ASSERT_EQ(last_buffer->non_null_cnt_, static_cast<int64_t>(0));
 }
 
+void CheckDistinctCountAggrResult(std::shared_ptr<Table> aggr_table, uint64_t count) {
+    ASSERT_EQ(aggr_table->GetRecordCnt(), 50);
+    auto it = aggr_table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    for (int i = 50 - 1; i >= 0; --i) {
+        ASSERT_TRUE(it->Valid());
+        auto tmp_val = it->GetValue();
+        std::string origin_data = tmp_val.ToString();
+        codec::RowView origin_row_view(aggr_table->GetTableMeta()->column_desc(),
+                                       reinterpret_cast<int8_t*>(const_cast<char*>(origin_data.c_str())),
+                                       origin_data.size());
+        char* ch = NULL;
+        uint32_t ch_length = 0;
+        origin_row_view.GetString(4, &ch, &ch_length);
+        DistinctState state;
+        ASSERT_TRUE(state.Decode(ch, ch_length));
+        ASSERT_EQ(state.Count(), count);
+        it->Next();
+    }
+    return;
+}
+
+TEST_F(AggregatorTest, DistinctState) {
+    DistinctState state;
+    std::string encoded;
+    state.Encode(&encoded);
+    DistinctState empty_state;
+    ASSERT_TRUE(empty_state.Decode(encoded.c_str(), encoded.size()));
+    ASSERT_EQ(empty_state.Count(), 0u);
+
+    for (int64_t i = 0; i < 10; i++) {
+        int64_t val = i % 3;
+        state.Add(reinterpret_cast<char*>(&val), sizeof(int64_t));
+    }
+    ASSERT_EQ(state.Count(), 3u);
+    state.Encode(&encoded);
+    // merge with another state
+    DistinctState merged;
+    int64_t val = 5;
+    merged.Add(reinterpret_cast<char*>(&val), sizeof(int64_t));
+    ASSERT_TRUE(merged.Decode(encoded.c_str(), encoded.size()));
+    ASSERT_EQ(merged.Count(), 4u);
+    auto cloned = merged.Clone();
+    ASSERT_EQ(dynamic_cast<DistinctState*>(cloned.get())->Count(), 4u);
+    // truncated state
+    DistinctState bad_state;
+    ASSERT_FALSE(bad_state.Decode(encoded.c_str(), encoded.size() - 1));
+
+    // the state of too many values is marked overflowed instead of growing
+    DistinctState large_state;
+    for (int64_t i = 0; i < 100000; i++) {
+        large_state.Add(reinterpret_cast<char*>(&i), sizeof(int64_t));
+    }
+    ASSERT_TRUE(large_state.IsOverflowed());
+    large_state.Encode(&encoded);
+    ASSERT_EQ(encoded.size(), sizeof(uint32_t));
+    ASSERT_TRUE(::hybridse::codec::DistinctValues::IsOverflowed(encoded.c_str(), encoded.size()));
+    DistinctState merged_overflow;
+    ASSERT_TRUE(merged_overflow.Decode(encoded.c_str(), encoded.size()));
+    ASSERT_TRUE(merged_overflow.IsOverflowed());
+}
+
+TEST_F(AggregatorTest, DistinctCountAggregatorUpdate) {
+    std::shared_ptr<Aggregator> aggregator;
+    AggrBuffer* last_buffer;
+    std::shared_ptr<Table> aggr_table;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col3", "distinct_count", "1s", aggregator, aggr_table, &last_buffer));
+    ASSERT_EQ(aggregator->GetAggrType(), AggrType::kDistinctCount);
+    CheckDistinctCountAggrResult(aggr_table, 2);
+    ASSERT_EQ(last_buffer->non_null_cnt_, 1);
+    ASSERT_EQ(dynamic_cast<DistinctState*>(last_buffer->state_.get())->Count(), 1u);
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col9", "DISTINCT_COUNT", "1m", aggregator, aggr_table, &last_buffer));
+    CheckDistinctCountAggrResult(aggr_table, 2);
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col8", "distinct_count", "1h", aggregator, aggr_table, &last_buffer));
+    CheckDistinctCountAggrResult(aggr_table, 2);
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col_null", "distinct_count", "1d", aggregator, aggr_table, &last_buffer));
+    CheckDistinctCountAggrResult(aggr_table, 0);
+    ASSERT_EQ(last_buffer->non_null_cnt_, 0);
+    ASSERT_EQ(last_buffer->state_, nullptr);
+}
+
 TEST_F(AggregatorTest, CountWhereAggregatorUpdate) {
     std::shared_ptr<Aggregator> aggregator;
     AggrBuffer* last_buffer;
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/cold_block.h"
+
+#include <snappy.h>
+
+namespace openmldb {
+namespace storage {
+
+static void PutVarint64(std::string* dst, uint64_t v) {
+    while (v >= 0x80) {
+        dst->push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    dst->push_back(static_cast<char>(v));
+}
+
+static bool GetVarint64(const Slice& src, uint32_t* offset, uint64_t* v) {
+    uint64_t result = 0;
+    for (uint32_t shift = 0; shift <= 63 && *offset < src.size(); shift += 7) {
+        uint64_t byte = static_cast<uint8_t>(src.data()[*offset]);
+        (*offset)++;
+        result |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+ColdBlock::ColdBlock(const std::vector<std::pair<uint64_t, Slice>>& rows, bool compress)
+    : count_(rows.size()), max_time_(0), min_time_(0), compressed_(false), data_() {
+    if (rows.empty()) {
+        return;
+    }
+    max_time_ = rows.front().first;
+    min_time_ = rows.back().first;
+    uint64_t total = 0;
+    for (const auto& row : rows) {
+        total += row.second.size() + 8;
+    }
+    std::string raw;
+    raw.reserve(total);
+    uint64_t last_time = max_time_;
+    for (const auto& row : rows) {
+        PutVarint64(&raw, last_time - row.first);
+        PutVarint64(&raw, row.second.size());
+        raw.append(row.second.data(), row.second.size());
+        last_time = row.first;
+    }
+    if (compress) {
+        std::string compressed;
+        ::snappy::Compress(raw.data(), raw.size(), &compressed);
+        if (compressed.size() < raw.size()) {
+            data_.swap(compressed);
+            compressed_ = true;
+        }
+    }
+    if (!compressed_) {
+        data_.swap(raw);
+    }
+    data_.shrink_to_fit();
+}
+
+bool ColdBlock::GetPayload(std::string* buf, Slice* payload) const {
+    if (!compressed_) {
+        *payload = Slice(data_.data(), data_.size());
+        return true;
+    }
+    buf->clear();
+    if (!::snappy::Uncompress(data_.data(), data_.size(), buf)) {
+        return false;
+    }
+    *payload = Slice(buf->data(), buf->size());
+    return true;
+}
+
+bool ColdBlock::ReadRow(const Slice& payload, uint32_t* offset, uint64_t* time, Slice* row) {
+    uint64_t delta = 0;
+    uint64_t size = 0;
+    if (!GetVarint64(payload, offset, &delta) || !GetVarint64(payload, offset, &size)) {
+        return false;
+    }
+    if (delta > *time || size > payload.size() - *offset) {
+        return false;
+    }
+    *time -= delta;
+    *row = Slice(payload.data() + *offset, size);
+    *offset += size;
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_COLD_BLOCK_H_
+#define SRC_STORAGE_COLD_BLOCK_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::base::Slice;
+
+// Immutable block of the rows frozen from the tail of a KeyEntry. The rows are sorted by time desc,
+// every row is encoded as varint(time delta to the previous row) varint(size) data. The payload
+// is compressed with snappy if it is required and makes the block smaller.
+class ColdBlock {
+ public:
+    // the rows must be sorted by time desc
+    ColdBlock(const std::vector<std::pair<uint64_t, Slice>>& rows, bool compress);
+
+    ColdBlock(const ColdBlock&) = delete;
+    ColdBlock& operator=(const ColdBlock&) = delete;
+
+    uint32_t GetCount() const { return count_; }
+    uint64_t GetMaxTime() const { return max_time_; }
+    uint64_t GetMinTime() const { return min_time_; }
+    bool IsCompressed() const { return compressed_; }
+
+    // the memory taken by the block
+    uint64_t GetByteSize() const { return sizeof(ColdBlock) + data_.capacity(); }
+
+    // return the encoded rows, the compressed payload is uncompressed into buf
+    bool GetPayload(std::string* buf, Slice* payload) const;
+
+    // decode the row at offset of the payload and move offset to the next row.
+    // time is the time of the previous row as input, it is the max time for the first row
+    static bool ReadRow(const Slice& payload, uint32_t* offset, uint64_t* time, Slice* row);
+
+ private:
+    uint32_t count_;
+    uint64_t max_time_;
+    uint64_t min_time_;
+    bool compressed_;
+    std::string data_;
+};
+
+// the cold blocks of a KeyEntry, newest first. it is replaced as a whole when the blocks change,
+// the old one is freed after the gc rounds, so the iterators can keep reading it
+struct ColdBlockList {
+    std::vector<std::shared_ptr<const ColdBlock>> blocks;
+    uint64_t count = 0;
+
+    uint64_t GetMinTime() const { return blocks.back()->GetMinTime(); }
+    uint64_t GetMaxTime() const { return blocks.front()->GetMaxTime(); }
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_COLD_BLOCK_H_
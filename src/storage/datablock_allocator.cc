@@ -0,0 +1,153 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/datablock_allocator.h"
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <new>
+
+#include "storage/record.h"
+
+namespace openmldb {
+namespace storage {
+
+namespace {
+
+// 16 bytes step up to 128 bytes, then 4 classes for every power of two up to 16KB
+std::vector<uint32_t> BuildClassSizes() {
+    std::vector<uint32_t> sizes;
+    for (uint32_t size = 32; size <= 128; size += 16) {
+        sizes.push_back(size);
+    }
+    for (uint32_t base = 128; base < 16 * 1024; base *= 2) {
+        for (uint32_t i = 1; i <= 4; i++) {
+            sizes.push_back(base + base / 4 * i);
+        }
+    }
+    return sizes;
+}
+
+const std::vector<uint32_t>& ClassSizes() {
+    static const std::vector<uint32_t> sizes = BuildClassSizes();
+    return sizes;
+}
+
+}  // namespace
+
+DataBlockAllocator::DataBlockAllocator(uint32_t shard_cnt, uint32_t slab_size)
+    : slab_size_(std::max(slab_size, ClassSizes().back())), allocated_byte_size_(0), used_byte_size_(0) {
+    shard_cnt = std::min(std::max(shard_cnt, 1u), static_cast<uint32_t>(UINT8_MAX));
+    for (uint32_t i = 0; i < shard_cnt; i++) {
+        auto shard = std::make_unique<Shard>();
+        shard->free_lists.resize(ClassSizes().size(), nullptr);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+DataBlockAllocator::~DataBlockAllocator() {
+    for (auto& shard : shards_) {
+        for (char* slab : shard->slabs) {
+            delete[] slab;
+        }
+        shard->slabs.clear();
+    }
+}
+
+uint32_t DataBlockAllocator::GetClassSize(uint8_t cls) { return ClassSizes()[cls]; }
+
+uint8_t DataBlockAllocator::GetSizeClass(uint32_t chunk_size) {
+    const auto& sizes = ClassSizes();
+    auto it = std::lower_bound(sizes.begin(), sizes.end(), chunk_size);
+    if (it == sizes.end()) {
+        return HEAP_DATA_BLOCK;
+    }
+    return static_cast<uint8_t>(it - sizes.begin());
+}
+
+uint32_t DataBlockAllocator::GetBlockByteSize(const DataBlock* block) {
+    if (block->IsHeapBlock()) {
+        return GetRecordSize(block->size);
+    }
+    return GetClassSize(block->slab_class);
+}
+
+uint32_t DataBlockAllocator::GetChunkByteSize(uint32_t len) {
+    uint8_t cls = GetSizeClass(sizeof(DataBlock) + len);
+    if (cls == HEAP_DATA_BLOCK) {
+        return GetRecordSize(len);
+    }
+    return GetClassSize(cls);
+}
+
+char* DataBlockAllocator::AllocChunk(Shard* shard, uint8_t cls) {
+    FreeChunk* chunk = shard->free_lists[cls];
+    if (chunk != nullptr) {
+        shard->free_lists[cls] = chunk->next;
+        return reinterpret_cast<char*>(chunk);
+    }
+    uint32_t class_size = GetClassSize(cls);
+    if (shard->remain < class_size) {
+        // the tail of the old slab is wasted, it is small compared with the slab size
+        shard->cur = new char[slab_size_];
+        shard->remain = slab_size_;
+        shard->slabs.push_back(shard->cur);
+        allocated_byte_size_.fetch_add(slab_size_, std::memory_order_relaxed);
+    }
+    char* ptr = shard->cur;
+    shard->cur += class_size;
+    shard->remain -= class_size;
+    return ptr;
+}
+
+DataBlock* DataBlockAllocator::New(uint32_t shard, uint8_t dim_cnt, const char* data, uint32_t len) {
+    uint8_t cls = GetSizeClass(sizeof(DataBlock) + len);
+    if (cls == HEAP_DATA_BLOCK) {
+        return new DataBlock(dim_cnt, data, len);
+    }
+    uint8_t shard_idx = shard % shards_.size();
+    Shard* cur_shard = shards_[shard_idx].get();
+    char* chunk = nullptr;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(cur_shard->mu);
+        chunk = AllocChunk(cur_shard, cls);
+    }
+    used_byte_size_.fetch_add(GetClassSize(cls), std::memory_order_relaxed);
+    return new (chunk) DataBlock(dim_cnt, data, len, cls, shard_idx);
+}
+
+void DataBlockAllocator::Free(DataBlock* block) {
+    if (block == nullptr) {
+        return;
+    }
+    if (block->IsHeapBlock()) {
+        delete block;
+        return;
+    }
+    uint8_t cls = block->slab_class;
+    Shard* shard = shards_[block->slab_shard].get();
+    block->~DataBlock();
+    auto* chunk = reinterpret_cast<FreeChunk*>(block);
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(shard->mu);
+        chunk->next = shard->free_lists[cls];
+        shard->free_lists[cls] = chunk;
+    }
+    used_byte_size_.fetch_sub(GetClassSize(cls), std::memory_order_relaxed);
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_DATABLOCK_ALLOCATOR_H_
+#define SRC_STORAGE_DATABLOCK_ALLOCATOR_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "base/spinlock.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+// Slab allocator of DataBlock. The header and the payload of a block are placed in one chunk,
+// the chunks of the same size class are carved from slabs and recycled through a free list.
+// Every shard has its own lock, so the put threads of different segments do not contend.
+// The slabs are returned to the system only when the allocator is destroyed.
+class DataBlockAllocator {
+ public:
+    DataBlockAllocator(uint32_t shard_cnt, uint32_t slab_size);
+    ~DataBlockAllocator();
+
+    DataBlockAllocator(const DataBlockAllocator&) = delete;
+    DataBlockAllocator& operator=(const DataBlockAllocator&) = delete;
+
+    // fallback to heap if the row is larger than the max size class
+    DataBlock* New(uint32_t shard, uint8_t dim_cnt, const char* data, uint32_t len);
+
+    void Free(DataBlock* block);
+
+    // the exact bytes a block takes
+    static uint32_t GetBlockByteSize(const DataBlock* block);
+
+    // the bytes a block with len bytes payload will take if allocated by New
+    static uint32_t GetChunkByteSize(uint32_t len);
+
+    // bytes of the slabs requested from system
+    uint64_t GetAllocatedByteSize() const { return allocated_byte_size_.load(std::memory_order_relaxed); }
+
+    // bytes of the chunks in use
+    uint64_t GetUsedByteSize() const { return used_byte_size_.load(std::memory_order_relaxed); }
+
+    uint32_t GetShardCnt() const { return shards_.size(); }
+
+    static uint32_t GetClassSize(uint8_t cls);
+
+    // return HEAP_DATA_BLOCK if the chunk is larger than the max size class
+    static uint8_t GetSizeClass(uint32_t chunk_size);
+
+ private:
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    struct Shard {
+        ::openmldb::base::SpinMutex mu;
+        std::vector<FreeChunk*> free_lists;
+        std::vector<char*> slabs;
+        char* cur = nullptr;
+        uint32_t remain = 0;
+    };
+
+    char* AllocChunk(Shard* shard, uint8_t cls);
+
+ private:
+    uint32_t slab_size_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> allocated_byte_size_;
+    std::atomic<uint64_t> used_byte_size_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_DATABLOCK_ALLOCATOR_H_
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/datablock_allocator.h"
+
+#include <gflags/gflags.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/glog_wrapper.h"
+#include "gtest/gtest.h"
+#include "storage/mem_table.h"
+#include "storage/record.h"
+#include "test/util.h"
+
+DECLARE_bool(enable_datablock_slab);
+
+namespace openmldb {
+namespace storage {
+
+class DataBlockAllocatorTest : public ::testing::Test {
+ public:
+    DataBlockAllocatorTest() {}
+    ~DataBlockAllocatorTest() {}
+};
+
+TEST_F(DataBlockAllocatorTest, SizeClass) {
+    ASSERT_EQ(0, DataBlockAllocator::GetSizeClass(1));
+    ASSERT_EQ(0, DataBlockAllocator::GetSizeClass(32));
+    ASSERT_EQ(1, DataBlockAllocator::GetSizeClass(33));
+    uint8_t last_cls = 0;
+    for (uint32_t size = 1; size <= 16 * 1024; size++) {
+        uint8_t cls = DataBlockAllocator::GetSizeClass(size);
+        ASSERT_NE(HEAP_DATA_BLOCK, cls);
+        ASSERT_GE(DataBlockAllocator::GetClassSize(cls), size);
+        ASSERT_EQ(0u, DataBlockAllocator::GetClassSize(cls) % 16);
+        ASSERT_GE(cls, last_cls);
+        last_cls = cls;
+    }
+    ASSERT_EQ(HEAP_DATA_BLOCK, DataBlockAllocator::GetSizeClass(16 * 1024 + 1));
+}
+
+TEST_F(DataBlockAllocatorTest, NewAndFree) {
+    DataBlockAllocator allocator(4, 64 * 1024);
+    std::vector<DataBlock*> blocks;
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        std::string value(i % 300 + 1, 'a' + i % 26);
+        DataBlock* block = allocator.New(i, 1, value.data(), value.size());
+        ASSERT_FALSE(block->IsHeapBlock());
+        ASSERT_EQ(value, std::string(block->data, block->size));
+        bytes += DataBlockAllocator::GetBlockByteSize(block);
+        ASSERT_EQ(DataBlockAllocator::GetChunkByteSize(value.size()), DataBlockAllocator::GetBlockByteSize(block));
+        blocks.push_back(block);
+    }
+    ASSERT_EQ(bytes, allocator.GetUsedByteSize());
+    uint64_t allocated = allocator.GetAllocatedByteSize();
+    ASSERT_GE(allocated, bytes);
+    for (auto block : blocks) {
+        allocator.Free(block);
+    }
+    ASSERT_EQ(0u, allocator.GetUsedByteSize());
+    // the freed chunks are reused
+    for (uint32_t i = 0; i < 1000; i++) {
+        std::string value(i % 300 + 1, 'b');
+        blocks[i] = allocator.New(i, 1, value.data(), value.size());
+    }
+    ASSERT_EQ(allocated, allocator.GetAllocatedByteSize());
+    ASSERT_EQ(bytes, allocator.GetUsedByteSize());
+    for (auto block : blocks) {
+        allocator.Free(block);
+    }
+
+    // large rows fallback to heap
+    std::string large(32 * 1024, 'c');
+    DataBlock* block = allocator.New(0, 1, large.data(), large.size());
+    ASSERT_TRUE(block->IsHeapBlock());
+    ASSERT_EQ(GetRecordSize(large.size()), DataBlockAllocator::GetBlockByteSize(block));
+    allocator.Free(block);
+    ASSERT_EQ(0u, allocator.GetUsedByteSize());
+}
+
+TEST_F(DataBlockAllocatorTest, MemTableGc) {
+    FLAGS_enable_datablock_slab = true;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    MemTable table("tx_log", 1, 1, 8, mapping, 1, ::openmldb::type::kLatestTime);
+    table.Init();
+    FLAGS_enable_datablock_slab = false;
+    const DataBlockAllocator* allocator = table.GetDataBlockAllocator();
+    ASSERT_TRUE(allocator != nullptr);
+    for (int i = 0; i < 100; i++) {
+        std::string key = "test" + std::to_string(i % 10);
+        std::string value = ::openmldb::test::EncodeKV(key, "value" + std::to_string(i));
+        ASSERT_TRUE(table.Put(key, i + 1, value.data(), value.size()));
+    }
+    ASSERT_EQ(100u, table.GetRecordCnt());
+    ASSERT_EQ(allocator->GetUsedByteSize(), table.GetRecordByteSize());
+    // latest ttl 1 keeps one record per key
+    table.SchedGc();
+    ASSERT_EQ(10u, table.GetRecordCnt());
+    ASSERT_EQ(allocator->GetUsedByteSize(), table.GetRecordByteSize());
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::openmldb::base::SetLogLevel(INFO);
+    ::testing::InitGoogleTest(&argc, argv);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -16,6 +16,7 @@
 
 #include "storage/disk_table.h"
 #include <snappy.h>
+#include <mutex>  // NOLINT
 #include <utility>
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
@@ -30,13 +31,21 @@ DECLARE_uint32(block_cache_mb);
 DECLARE_uint32(write_buffer_mb);
 DECLARE_uint32(block_cache_shardbits);
 DECLARE_bool(verify_compression);
+DECLARE_uint32(disk_table_bloom_bits_per_key);
+DECLARE_bool(disk_table_partition_filters);
+DECLARE_double(disk_table_memtable_bloom_ratio);
+DECLARE_bool(disk_table_statistics);
+DECLARE_uint32(write_buffer_manager_mb);
 
 namespace openmldb {
 namespace storage {
 
 static rocksdb::Options ssd_option_template;
 static rocksdb::Options hdd_option_template;
-static bool options_template_initialized = false;
+static std::once_flag options_template_once;
+// shared by all the disk tables of the tablet
+static std::shared_ptr<rocksdb::Cache> block_cache;
+static std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager;
 
 DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
                      uint64_t ttl, ::openmldb::type::TTLType ttl_type, ::openmldb::common::StorageMode storage_mode,
@@ -46,9 +55,7 @@ DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const s
       write_opts_(),
       offset_(0),
       table_path_(table_path) {
-    if (!options_template_initialized) {
-        initOptionTemplate();
-    }
+    std::call_once(options_template_once, initOptionTemplate);
     write_opts_.disableWAL = FLAGS_disable_wal;
     db_ = nullptr;
 }
@@ -60,9 +67,7 @@ DiskTable::DiskTable(const ::openmldb::api::TableMeta& table_meta, const std::st
       write_opts_(),
       offset_(0),
       table_path_(table_path) {
-    if (!options_template_initialized) {
-        initOptionTemplate();
-    }
+    std::call_once(options_template_once, initOptionTemplate);
     diskused_ = 0;
     write_opts_.disableWAL = FLAGS_disable_wal;
     db_ = nullptr;
@@ -80,13 +85,23 @@ DiskTable::~DiskTable() {
 }
 
 void DiskTable::initOptionTemplate() {
-    std::shared_ptr<rocksdb::Cache> cache = rocksdb::NewLRUCache(FLAGS_block_cache_mb << 20,
+    std::shared_ptr<rocksdb::Cache> cache = rocksdb::NewLRUCache(static_cast<size_t>(FLAGS_block_cache_mb) << 20,
                                                                  FLAGS_block_cache_shardbits);  // Can be set by flags
+    block_cache = cache;
+    if (FLAGS_write_buffer_manager_mb > 0) {
+        // the memtables of all the tables are charged to the block cache, so block_cache_mb is the memory
+        // budget of both. a memtable is flushed early if the total size is beyond write_buffer_manager_mb
+        write_buffer_manager =
+            std::make_shared<rocksdb::WriteBufferManager>(static_cast<size_t>(FLAGS_write_buffer_manager_mb) << 20,
+                                                          cache);
+        ssd_option_template.write_buffer_manager = write_buffer_manager;
+        hdd_option_template.write_buffer_manager = write_buffer_manager;
+    }
     // SSD options template
     ssd_option_template.max_open_files = -1;
     ssd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::HIGH);  // flush threads
     ssd_option_template.env->SetBackgroundThreads(4, rocksdb::Env::Priority::LOW);   // compaction threads
-    ssd_option_template.memtable_prefix_bloom_size_ratio = 0.02;
+    ssd_option_template.memtable_prefix_bloom_size_ratio = FLAGS_disk_table_memtable_bloom_ratio;
     ssd_option_template.compaction_style = rocksdb::kCompactionStyleLevel;
     ssd_option_template.write_buffer_size = FLAGS_write_buffer_mb << 20;  // L0 file size = write_buffer_size
     ssd_option_template.level0_file_num_compaction_trigger = 1 << 4;      // L0 total size = write_buffer_size * 16
@@ -99,11 +114,20 @@ void DiskTable::initOptionTemplate() {
         ssd_option_template.max_bytes_for_level_base >> 4;  // number of L1 files = 16
 
     rocksdb::BlockBasedTableOptions table_options;
-    // table_options.cache_index_and_filter_blocks = true;
-    // table_options.pin_l0_filter_and_index_blocks_in_cache = true;
     table_options.block_cache = cache;
-    // table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10,
-    // false));
+    // the filter is built on the prefix (the index key) by KeyTsPrefixTransform,
+    // the whole key (with ts) is never looked up by Get
+    if (FLAGS_disk_table_bloom_bits_per_key > 0) {
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(FLAGS_disk_table_bloom_bits_per_key, false));
+    }
+    if (FLAGS_disk_table_partition_filters) {
+        table_options.index_type = rocksdb::BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch;
+        table_options.partition_filters = table_options.filter_policy != nullptr;
+        table_options.cache_index_and_filter_blocks = true;
+        table_options.cache_index_and_filter_blocks_with_high_priority = true;
+        table_options.pin_top_level_index_and_filter = true;
+        table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+    }
     table_options.whole_key_filtering = false;
     table_options.block_size = 256 << 10;
     table_options.use_delta_encoding = false;
@@ -128,7 +152,7 @@ void DiskTable::initOptionTemplate() {
     hdd_option_template.max_open_files = -1;
     hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::HIGH);  // flush threads
     hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::LOW);   // compaction threads
-    hdd_option_template.memtable_prefix_bloom_size_ratio = 0.02;
+    hdd_option_template.memtable_prefix_bloom_size_ratio = FLAGS_disk_table_memtable_bloom_ratio;
     hdd_option_template.optimize_filters_for_hits = true;
     hdd_option_template.level_compaction_dynamic_level_bytes = true;
     hdd_option_template.max_file_opening_threads =
@@ -143,8 +167,6 @@ void DiskTable::initOptionTemplate() {
     hdd_option_template.target_file_size_base = 256 << 20;
     hdd_option_template.max_bytes_for_level_base = 1024 << 20;
     hdd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
-
-    options_template_initialized = true;
 }
 
 bool DiskTable::InitColumnFamilyDescriptor() {
@@ -192,6 +214,11 @@ bool DiskTable::Init() {
     options_.create_if_missing = true;
     options_.error_if_exists = false;
     options_.create_missing_column_families = true;
+    if (FLAGS_disk_table_statistics) {
+        // one db per table partition, so the tickers are the stats of this partition
+        options_.statistics = rocksdb::CreateDBStatistics();
+        options_.statistics->set_stats_level(rocksdb::StatsLevel::kExceptHistogramOrTimers);
+    }
     rocksdb::Status s = rocksdb::DB::Open(options_, path, cf_ds_, &cf_hs_, &db_);
     if (!s.ok()) {
         PDLOG(WARNING, "rocksdb open failed. tid %u pid %u error %s", id_, pid_, s.ToString().c_str());
@@ -334,7 +361,8 @@ void DiskTable::GcHead() {
         rocksdb::ReadOptions ro = rocksdb::ReadOptions();
         const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
         ro.snapshot = snapshot;
-        // ro.prefix_same_as_start = true;
+        // walk across the keys, the prefix bloom filters must not be used
+        ro.total_order_seek = true;
         ro.pin_data = true;
         rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[idx + 1]);
         it->SeekToFirst();
@@ -518,7 +546,7 @@ TraverseIterator* DiskTable::NewTraverseIterator(uint32_t index) {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -852,7 +880,7 @@ void DiskTableTraverseIterator::NextPK() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -965,7 +993,7 @@ std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
     return std::make_unique<DiskTableRowIterator>(db_, it, snapshot, ttl_type_, expire_time_,
@@ -976,7 +1004,7 @@ std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
     return new DiskTableRowIterator(db_, it, snapshot, ttl_type_, expire_time_, expire_cnt_, pk_, ts_, has_ts_idx_,
@@ -1139,7 +1167,7 @@ int DiskTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count)
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
 
@@ -1180,5 +1208,45 @@ int DiskTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count)
     return 0;
 }
 
+void DiskTable::GetMemoryUsage(::openmldb::api::DiskTableStatus* status) const {
+    uint64_t memtable_size = 0;
+    uint64_t table_readers_size = 0;
+    for (auto cf : cf_hs_) {
+        uint64_t value = 0;
+        if (db_->GetIntProperty(cf, rocksdb::DB::Properties::kCurSizeAllMemTables, &value)) {
+            memtable_size += value;
+        }
+        if (db_->GetIntProperty(cf, rocksdb::DB::Properties::kEstimateTableReadersMem, &value)) {
+            table_readers_size += value;
+        }
+    }
+    status->set_memtable_bytes(memtable_size);
+    status->set_table_readers_bytes(table_readers_size);
+    if (block_cache) {
+        status->set_block_cache_usage(block_cache->GetUsage());
+        status->set_block_cache_capacity(block_cache->GetCapacity());
+    }
+    if (write_buffer_manager) {
+        status->set_write_buffer_usage(write_buffer_manager->memory_usage());
+        status->set_write_buffer_limit(write_buffer_manager->buffer_size());
+    }
+}
+
+bool DiskTable::GetStatistics(::openmldb::api::DiskTableStatus* status) const {
+    if (!options_.statistics) {
+        return false;
+    }
+    const auto& stats = options_.statistics;
+    status->set_bloom_prefix_checked(stats->getTickerCount(rocksdb::BLOOM_FILTER_PREFIX_CHECKED));
+    status->set_bloom_prefix_useful(stats->getTickerCount(rocksdb::BLOOM_FILTER_PREFIX_USEFUL));
+    status->set_block_cache_hit(stats->getTickerCount(rocksdb::BLOCK_CACHE_HIT));
+    status->set_block_cache_miss(stats->getTickerCount(rocksdb::BLOCK_CACHE_MISS));
+    status->set_block_cache_filter_hit(stats->getTickerCount(rocksdb::BLOCK_CACHE_FILTER_HIT));
+    status->set_block_cache_filter_miss(stats->getTickerCount(rocksdb::BLOCK_CACHE_FILTER_MISS));
+    status->set_block_cache_index_hit(stats->getTickerCount(rocksdb::BLOCK_CACHE_INDEX_HIT));
+    status->set_block_cache_index_miss(stats->getTickerCount(rocksdb::BLOCK_CACHE_INDEX_MISS));
+    return true;
+}
+
 }  // namespace storage
 }  // namespace openmldb
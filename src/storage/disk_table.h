@@ -34,9 +34,11 @@
 #include "rocksdb/options.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
+#include "rocksdb/statistics.h"
 #include "rocksdb/status.h"
 #include "rocksdb/table.h"
 #include "rocksdb/utilities/checkpoint.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "storage/iterator.h"
 #include "storage/table.h"
 
@@ -425,6 +427,12 @@ class DiskTable : public Table {
 
     int GetCount(uint32_t index, const std::string& pk, uint64_t& count) override; // NOLINT
 
+    // fill the memory used by this partition and the usage of the block cache and write buffers shared by the tablet
+    void GetMemoryUsage(::openmldb::api::DiskTableStatus* status) const;
+
+    // fill the bloom filter and block cache counters. return false if disk_table_statistics is off
+    bool GetStatistics(::openmldb::api::DiskTableStatus* status) const;
+
  private:
     rocksdb::DB* db_;
     rocksdb::WriteOptions write_opts_;
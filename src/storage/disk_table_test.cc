@@ -33,6 +33,8 @@ DECLARE_string(ssd_root_path);
 DECLARE_string(hdd_root_path);
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_int32(gc_safe_offset);
+DECLARE_uint32(block_cache_mb);
+DECLARE_bool(disk_table_statistics);
 
 namespace openmldb {
 namespace storage {
@@ -1198,6 +1200,83 @@ TEST_F(DiskTableTest, CheckPoint) {
     RemoveData(table_path);
 }
 
+TEST_F(DiskTableTest, PrefixBloomFilter) {
+    FLAGS_disk_table_statistics = true;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_ssd_root_path + "/16_1";
+    DiskTable* table = new DiskTable("t1", 16, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kSSD, table_path);
+    ASSERT_TRUE(table->Init());
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 10; k++) {
+            ASSERT_TRUE(table->Put(key, 9537 + k, "value", 5));
+        }
+    }
+    // flush the memtable into sst files which have the filters
+    table->CompactDB();
+
+    Ticket ticket;
+    for (int idx = 0; idx < 100; idx++) {
+        // the keys are in the range of the sst file but not exist
+        TableIterator* it = table->NewIterator("test" + std::to_string(idx) + "x", ticket);
+        it->SeekToFirst();
+        ASSERT_FALSE(it->Valid());
+        delete it;
+    }
+    TableIterator* it = table->NewIterator("test35", ticket);
+    it->SeekToFirst();
+    int count = 0;
+    while (it->Valid()) {
+        ASSERT_EQ("test35", it->GetPK());
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(10, count);
+    delete it;
+
+    // the traverse is not affected by the prefix filters
+    it = table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    count = 0;
+    while (it->Valid()) {
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(1000, count);
+    delete it;
+
+    ::openmldb::api::DiskTableStatus status;
+    ASSERT_TRUE(table->GetStatistics(&status));
+    ASSERT_GT(status.bloom_prefix_checked(), 0u);
+    ASSERT_GT(status.bloom_prefix_useful(), 0u);
+    ASSERT_GT(status.block_cache_hit() + status.block_cache_miss(), 0u);
+    delete table;
+    RemoveData(table_path);
+    FLAGS_disk_table_statistics = false;
+}
+
+TEST_F(DiskTableTest, MemoryUsage) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/17_1";
+    DiskTable* table = new DiskTable("t1", 17, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        ASSERT_TRUE(table->Put(key, 9537, "value", 5));
+    }
+    ::openmldb::api::DiskTableStatus status;
+    table->GetMemoryUsage(&status);
+    ASSERT_GT(status.memtable_bytes(), 0u);
+    // the block cache is shared by the tablet
+    ASSERT_EQ(status.block_cache_capacity(), static_cast<uint64_t>(FLAGS_block_cache_mb) << 20);
+    delete table;
+    RemoveData(table_path);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
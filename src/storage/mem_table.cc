@@ -18,7 +18,9 @@
 
 #include <snappy.h>
 #include <algorithm>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wrapper.h"
 #include "base/hash.h"
@@ -34,6 +36,13 @@ DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_bool(enable_datablock_slab);
+DECLARE_uint32(datablock_slab_size);
+DECLARE_uint32(key_entry_compact_hot_cnt);
+DECLARE_uint32(key_entry_compact_block_rows);
+DECLARE_bool(key_entry_compact_compress);
+DECLARE_bool(gc_expiry_index);
+DECLARE_uint32(gc_segment_thread_num);
 
 namespace openmldb {
 namespace storage {
@@ -82,6 +91,15 @@ MemTable::~MemTable() {
     PDLOG(INFO, "drop memtable. tid %u pid %u", id_, pid_);
 }
 
+// the height to seek among keep_cnt rows, as the skiplist of a key entry has a branching factor of 4
+static uint32_t GetLatestKeyEntryHeight(uint64_t keep_cnt) {
+    uint32_t height = 1;
+    for (uint64_t cnt = 4; cnt < keep_cnt && height < FLAGS_key_entry_max_height; cnt *= 4) {
+        height++;
+    }
+    return height;
+}
+
 bool MemTable::Init() {
     key_entry_max_height_ = FLAGS_key_entry_max_height;
     if (!InitFromMeta()) {
@@ -95,6 +113,9 @@ bool MemTable::Init() {
         table_meta_->key_entry_max_height() > 0) {
         global_key_entry_max_height = table_meta_->key_entry_max_height();
     }
+    if (FLAGS_enable_datablock_slab) {
+        allocator_ = std::make_unique<DataBlockAllocator>(seg_cnt_, FLAGS_datablock_slab_size);
+    }
     auto inner_indexs = table_index_.GetAllInnerIndex();
     for (uint32_t i = 0; i < inner_indexs->size(); i++) {
         const std::vector<uint32_t>& ts_vec = inner_indexs->at(i)->GetTsIdx();
@@ -104,6 +125,10 @@ bool MemTable::Init() {
         } else {
             cur_key_entry_max_height = inner_indexs->at(i)->GetKeyEntryMaxHeight(FLAGS_absolute_default_skiplist_height,
                                                                                  FLAGS_latest_default_skiplist_height);
+            uint64_t keep_cnt = inner_indexs->at(i)->GetLatestKeepCnt();
+            if (keep_cnt > 0) {
+                cur_key_entry_max_height = std::max(cur_key_entry_max_height, GetLatestKeyEntryHeight(keep_cnt));
+            }
         }
         Segment** seg_arr = new Segment*[seg_cnt_];
         if (!ts_vec.empty()) {
@@ -118,13 +143,31 @@ bool MemTable::Init() {
                 PDLOG(INFO, "init %u, %u segment. height %u tid %u pid %u", i, j, cur_key_entry_max_height, id_, pid_);
             }
         }
+        SetSegmentAllocator(seg_arr);
         segments_[i] = seg_arr;
         key_entry_max_height_ = cur_key_entry_max_height;
     }
+    UpdateSegmentGcOptions();
     PDLOG(INFO, "init table name %s, id %d, pid %d, seg_cnt %d", name_.c_str(), id_, pid_, seg_cnt_);
     return true;
 }
 
+void MemTable::SetSegmentAllocator(Segment** seg_arr) {
+    if (!allocator_) {
+        return;
+    }
+    for (uint32_t j = 0; j < seg_cnt_; j++) {
+        seg_arr[j]->SetDataBlockAllocator(allocator_.get(), j % allocator_->GetShardCnt());
+    }
+}
+
+DataBlock* MemTable::NewDataBlock(uint32_t seg_idx, uint8_t dim_cnt, const char* data, uint32_t len) {
+    if (allocator_) {
+        return allocator_->New(seg_idx, dim_cnt, data, len);
+    }
+    return new DataBlock(dim_cnt, data, len);
+}
+
 void MemTable::SetCompressType(::openmldb::type::CompressType compress_type) { compress_type_ = compress_type; }
 
 ::openmldb::type::CompressType MemTable::GetCompressType() { return compress_type_; }
@@ -139,7 +182,7 @@ bool MemTable::Put(const std::string& pk, uint64_t time, const char* data, uint3
     Slice spk(pk);
     segment->Put(spk, time, data, size);
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
-    record_byte_size_.fetch_add(GetRecordSize(size));
+    record_byte_size_.fetch_add(allocator_ ? DataBlockAllocator::GetChunkByteSize(size) : GetRecordSize(size));
     return true;
 }
 
@@ -201,7 +244,13 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
     if (ts_map.empty()) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    // the block is allocated from the shard of the first dimension's segment
+    uint32_t alloc_seg_idx = 0;
+    if (seg_cnt_ > 1) {
+        const auto& first_key = inner_index_key_map.begin()->second;
+        alloc_seg_idx = ::openmldb::base::hash(first_key.data(), first_key.size(), SEED) % seg_cnt_;
+    }
+    auto* block = NewDataBlock(alloc_seg_idx, real_ref_cnt, value.c_str(), value.length());
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -222,10 +271,17 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         }
     }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
-    record_byte_size_.fetch_add(GetRecordSize(value.length()));
+    record_byte_size_.fetch_add(DataBlockAllocator::GetBlockByteSize(block));
     return true;
 }
 
+uint32_t MemTable::GetSegIdx(const std::string& key) const {
+    if (seg_cnt_ <= 1) {
+        return 0;
+    }
+    return ::openmldb::base::hash(key.data(), key.size(), SEED) % seg_cnt_;
+}
+
 bool MemTable::Delete(const std::string& pk, uint32_t idx) {
     std::shared_ptr<IndexDef> index_def = GetIndex(idx);
     if (!index_def || !index_def->IsReady()) {
@@ -261,12 +317,25 @@ uint64_t MemTable::Release() {
     return total_cnt;
 }
 
+namespace {
+// the counters of the segments collected by one gc thread
+struct SegmentGcStat {
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    uint64_t compact_freed_byte_size = 0;
+    uint64_t compact_block_byte_size = 0;
+};
+}  // namespace
+
 void MemTable::SchedGc() {
     uint64_t consumed = ::baidu::common::timer::get_micros();
     PDLOG(INFO, "start making gc for table %s, tid %u, pid %u", name_.c_str(), id_, pid_);
     uint64_t gc_idx_cnt = 0;
     uint64_t gc_record_cnt = 0;
     uint64_t gc_record_byte_size = 0;
+    uint64_t compact_freed_byte_size = 0;
+    uint64_t compact_block_byte_size = 0;
     auto inner_indexs = table_index_.GetAllInnerIndex();
     for (uint32_t i = 0; i < inner_indexs->size(); i++) {
         const std::vector<std::shared_ptr<IndexDef>>& real_index = inner_indexs->at(i)->GetIndex();
@@ -306,19 +375,50 @@ void MemTable::SchedGc() {
         if (deleted_num == real_index.size() || ttl_st_map.empty()) {
             continue;
         }
-        for (uint32_t j = 0; j < seg_cnt_; j++) {
-            uint64_t seg_gc_time = ::baidu::common::timer::get_micros() / 1000;
-            Segment* segment = segments_[i][j];
-            segment->IncrGcVersion();
-            segment->GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-            if (ttl_st_map.size() == 1) {
-                segment->ExecuteGc(ttl_st_map.begin()->second, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-            } else {
-                segment->ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        // the segments share nothing but the datablock allocator, so they can be collected in parallel
+        uint32_t thread_num = std::min(std::max(FLAGS_gc_segment_thread_num, 1u), seg_cnt_);
+        std::vector<SegmentGcStat> stats(thread_num);
+        auto gc_segments = [&](uint32_t thread_idx) {
+            SegmentGcStat& stat = stats[thread_idx];
+            for (uint32_t j = thread_idx; j < seg_cnt_; j += thread_num) {
+                uint64_t seg_gc_time = ::baidu::common::timer::get_micros() / 1000;
+                Segment* segment = segments_[i][j];
+                segment->IncrGcVersion();
+                segment->GcFreeList(stat.gc_idx_cnt, stat.gc_record_cnt, stat.gc_record_byte_size);
+                if (ttl_st_map.size() == 1) {
+                    segment->ExecuteGc(ttl_st_map.begin()->second, stat.gc_idx_cnt, stat.gc_record_cnt,
+                                       stat.gc_record_byte_size);
+                } else {
+                    segment->ExecuteGc(ttl_st_map, stat.gc_idx_cnt, stat.gc_record_cnt, stat.gc_record_byte_size);
+                }
+                if (FLAGS_key_entry_compact_hot_cnt > 0 && ttl_st_map.size() == 1) {
+                    segment->Compact(FLAGS_key_entry_compact_hot_cnt, FLAGS_key_entry_compact_block_rows,
+                                     FLAGS_key_entry_compact_compress, stat.compact_freed_byte_size,
+                                     stat.compact_block_byte_size);
+                }
+                seg_gc_time = ::baidu::common::timer::get_micros() / 1000 - seg_gc_time;
+                PDLOG(INFO, "gc segment[%u][%u] done consumed %lu for table %s tid %u pid %u", i, j, seg_gc_time,
+                      name_.c_str(), id_, pid_);
+            }
+        };
+        if (thread_num == 1) {
+            gc_segments(0);
+        } else {
+            std::vector<std::thread> threads;
+            threads.reserve(thread_num);
+            for (uint32_t k = 0; k < thread_num; k++) {
+                threads.emplace_back(gc_segments, k);
             }
-            seg_gc_time = ::baidu::common::timer::get_micros() / 1000 - seg_gc_time;
-            PDLOG(INFO, "gc segment[%u][%u] done consumed %lu for table %s tid %u pid %u", i, j, seg_gc_time,
-                  name_.c_str(), id_, pid_);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+        for (const auto& stat : stats) {
+            gc_idx_cnt += stat.gc_idx_cnt;
+            gc_record_cnt += stat.gc_record_cnt;
+            gc_record_byte_size += stat.gc_record_byte_size;
+            compact_freed_byte_size += stat.compact_freed_byte_size;
+            compact_block_byte_size += stat.compact_block_byte_size;
         }
     }
     consumed = ::baidu::common::timer::get_micros() - consumed;
@@ -328,7 +428,44 @@ void MemTable::SchedGc() {
           "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu ms for "
           "table %s tid %u pid %u",
           gc_idx_cnt, gc_record_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+    if (compact_freed_byte_size > 0) {
+        record_byte_size_.fetch_add(compact_block_byte_size, std::memory_order_relaxed);
+        record_byte_size_.fetch_sub(compact_freed_byte_size, std::memory_order_relaxed);
+        PDLOG(INFO, "compact finished, freed %lu bytes into %lu bytes of cold blocks for table %s tid %u pid %u",
+              compact_freed_byte_size, compact_block_byte_size, name_.c_str(), id_, pid_);
+    }
     UpdateTTL();
+    UpdateSegmentGcOptions();
+}
+
+void MemTable::UpdateSegmentGcOptions() {
+    if (segments_.empty() || segments_[0] == NULL) {
+        return;
+    }
+    bool enable_gc = enable_gc_.load(std::memory_order_relaxed);
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    uint64_t keep_cnt = 0;
+    // the rows shared with other indexes can not be freed on put
+    if (enable_gc && inner_indexs->size() == 1) {
+        keep_cnt = inner_indexs->at(0)->GetLatestKeepCnt();
+    }
+    for (uint32_t j = 0; j < seg_cnt_; j++) {
+        segments_[0][j]->SetKeepCnt(keep_cnt);
+    }
+    for (uint32_t i = 0; i < inner_indexs->size() && i < segments_.size(); i++) {
+        if (segments_[i] == NULL) {
+            continue;
+        }
+        const auto& real_index = inner_indexs->at(i)->GetIndex();
+        bool expiry_index = FLAGS_gc_expiry_index && enable_gc && real_index.size() == 1 &&
+                            real_index[0]->GetTTLType() == ::openmldb::storage::TTLType::kAbsoluteTime;
+        // the gc compacts only the indexes of a single ttl
+        bool compact = FLAGS_key_entry_compact_hot_cnt > 0 && real_index.size() == 1;
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            segments_[i][j]->SetExpiryIndex(expiry_index);
+            segments_[i][j]->SetCompact(compact);
+        }
+    }
 }
 
 // tll as ms
@@ -601,6 +738,11 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
             PDLOG(INFO, "init %u, %u segment. height %u, ts col num %u. tid %u pid %u", inner_id, j,
                   FLAGS_absolute_default_skiplist_height, ts_vec.size(), id_, pid_);
         }
+        SetSegmentAllocator(seg_arr);
+        // the rows will be shared with the new index
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            segments_[0][j]->SetKeepCnt(0);
+        }
         index_def = std::make_shared<IndexDef>(column_key.index_name(), table_index_.GetMaxIndexId() + 1,
                 IndexStatus::kReady, ::openmldb::type::IndexType::kTimeSerise, col_vec);
         if (table_index_.AddIndex(index_def) < 0) {
@@ -851,11 +993,10 @@ void MemTableTraverseIterator::NextPK() {
         }
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[0];  // NOLINT
-            it_ = entry->entries.NewIterator();
+            it_ = entry->NewIterator();
             ticket_.Push(entry);
         } else {
-            it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                      ->entries.NewIterator();
+            it_ = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
         }
         it_->SeekToFirst();
@@ -887,11 +1028,10 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
             ticket_.Push(entry);
-            it_ = entry->entries.NewIterator();
+            it_ = entry->NewIterator();
         } else {
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-            it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                      ->entries.NewIterator();
+            it_ = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
         }
         if (spk.compare(pk_it_->GetKey()) != 0 || ts == 0) {
             it_->SeekToFirst();
@@ -930,7 +1070,7 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
 }
 
 openmldb::base::Slice MemTableTraverseIterator::GetValue() const {
-    return openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
+    return it_->GetValue();
 }
 
 uint64_t MemTableTraverseIterator::GetKey() const {
@@ -964,11 +1104,10 @@ void MemTableTraverseIterator::SeekToFirst() {
             if (segments_[seg_idx_]->GetTsCnt() > 1) {
                 KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
                 ticket_.Push(entry);
-                it_ = entry->entries.NewIterator();
+                it_ = entry->NewIterator();
             } else {
                 ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-                it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                          ->entries.NewIterator();
+                it_ = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
             }
             it_->SeekToFirst();
             traverse_cnt_++;
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "proto/tablet.pb.h"
+#include "storage/datablock_allocator.h"
 #include "storage/iterator.h"
 #include "storage/segment.h"
 #include "storage/table.h"
@@ -58,7 +59,7 @@ class MemTableTraverseIterator : public TraverseIterator {
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
     KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
     uint32_t record_idx_;
     uint32_t ts_idx_;
     // uint64_t expire_value_;
@@ -120,7 +121,13 @@ class MemTable : public Table {
 
     inline uint32_t GetSegCnt() const { return seg_cnt_; }
 
-    inline void SetExpire(bool is_expire) { enable_gc_.store(is_expire, std::memory_order_relaxed); }
+    // the segment a key is put into, it is the same for all the indexes
+    uint32_t GetSegIdx(const std::string& key) const;
+
+    inline void SetExpire(bool is_expire) {
+        enable_gc_.store(is_expire, std::memory_order_relaxed);
+        UpdateSegmentGcOptions();
+    }
 
     uint64_t GetExpireTime(const TTLSt& ttl_st) override;
 
@@ -138,11 +145,21 @@ class MemTable : public Table {
 
     bool AddIndex(const ::openmldb::common::ColumnKey& column_key);
 
+    // nullptr if datablock slab is disabled
+    const DataBlockAllocator* GetDataBlockAllocator() const { return allocator_.get(); }
+
  private:
+    DataBlock* NewDataBlock(uint32_t seg_idx, uint8_t dim_cnt, const char* data, uint32_t len);
+
+    void SetSegmentAllocator(Segment** seg_arr);
+
     bool CheckAbsolute(const TTLSt& ttl, uint64_t ts);
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
 
+    // let the segments of a single latest index trim the key entries on put
+    void UpdateSegmentGcOptions();
+
  private:
     uint32_t seg_cnt_;
     std::vector<Segment**> segments_;
@@ -152,6 +169,8 @@ class MemTable : public Table {
     bool segment_released_;
     std::atomic<uint64_t> record_byte_size_;
     uint32_t key_entry_max_height_;
+    // destroyed after the segments are released in ~MemTable
+    std::unique_ptr<DataBlockAllocator> allocator_;
 };
 
 }  // namespace storage
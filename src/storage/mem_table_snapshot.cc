@@ -16,6 +16,7 @@
 
 #include "storage/mem_table_snapshot.h"
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #ifdef DISALLOW_COPY_AND_ASSIGN
 #undef DISALLOW_COPY_AND_ASSIGN
@@ -23,6 +24,7 @@
 #include <snappy.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <set>
 #include <utility>
 
@@ -32,7 +34,6 @@
 #include "base/slice.h"
 #include "base/strings.h"
 #include "base/taskpool.hpp"
-#include "boost/bind.hpp"
 #include "codec/row_codec.h"
 #include "common/thread_pool.h"
 #include "common/timer.h"
@@ -40,6 +41,7 @@
 #include "log/log_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
 
 using google::protobuf::RepeatedPtrField;
 using ::openmldb::codec::SchemaCodec;
@@ -50,6 +52,7 @@ DECLARE_uint32(make_snapshot_max_deleted_keys);
 DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
+DECLARE_uint32(load_table_read_buffer_size);
 DECLARE_string(snapshot_compression);
 
 namespace openmldb {
@@ -105,92 +108,146 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
     }
 }
 
-void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
-                                             std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
-    ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
-    std::atomic<uint64_t> succ_cnt, failed_cnt;
-    succ_cnt = failed_cnt = 0;
+namespace {
 
-    do {
-        if (table == NULL) {
-            PDLOG(WARNING, "table input is NULL");
-            break;
-        }
-        FILE* fd = fopen(path.c_str(), "rb");
-        if (fd == NULL) {
-            PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
-            break;
-        }
-        bool compressed = IsCompressed(path);
-        ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
-        std::string buffer;
-        // second
-        uint64_t consumed = ::baidu::common::timer::now_time();
-        std::vector<std::string*> recordPtr;
-        recordPtr.reserve(FLAGS_load_table_batch);
+// the raw records read from a snapshot file are appended to one buffer instead of one string per record
+struct RecordBatch {
+    std::string buf;
+    std::vector<std::pair<uint32_t, uint32_t>> pos;
+};
 
-        while (true) {
-            buffer.clear();
-            ::openmldb::base::Slice record;
-            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
-            if (status.IsWaitRecord() || status.IsEof()) {
-                consumed = ::baidu::common::timer::now_time() - consumed;
-                PDLOG(INFO,
-                      "read path %s for table tid %u pid %u completed, "
-                      "succ_cnt %lu, failed_cnt %lu, consumed %us",
-                      path.c_str(), tid_, pid_, succ_cnt.load(std::memory_order_relaxed),
-                      failed_cnt.load(std::memory_order_relaxed), consumed);
-                break;
-            }
+// the entries parsed from a RecordBatch, allocated on the arena and grouped by put worker
+struct EntryBatch {
+    ::google::protobuf::Arena arena;
+    std::vector<std::vector<::openmldb::api::LogEntry*>> groups;
+};
 
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
-                      status.ToString().c_str());
-                failed_cnt.fetch_add(1, std::memory_order_relaxed);
-                continue;
-            }
-            std::string* sp = new std::string(record.data(), record.size());
-            recordPtr.push_back(sp);
-            if (recordPtr.size() >= FLAGS_load_table_batch) {
-                load_pool_.AddTask(
-                    boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
-                recordPtr.clear();
-            }
+struct RecoverContext {
+    std::string path;
+    std::shared_ptr<Table> table;
+    std::shared_ptr<MemTable> mem_table;
+    // every put worker owns the segments with seg_idx % put_pools.size() == worker id,
+    // so the workers do not contend on the segment lock of the first dimension
+    std::vector<std::unique_ptr<::openmldb::base::TaskPool>> put_pools;
+    std::atomic<uint64_t> succ_cnt{0};
+    std::atomic<uint64_t> failed_cnt{0};
+};
+
+void PutEntries(RecoverContext* ctx, const std::shared_ptr<EntryBatch>& batch, uint32_t group) {
+    for (const auto* entry : batch->groups[group]) {
+        auto scount = ctx->succ_cnt.fetch_add(1, std::memory_order_relaxed);
+        if (scount % 100000 == 0) {
+            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", ctx->path.c_str(), scount,
+                  ctx->failed_cnt.load(std::memory_order_relaxed));
         }
-        if (recordPtr.size() > 0) {
-            load_pool_.AddTask(
-                boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
+        ctx->table->Put(*entry);
+    }
+}
+
+void ParseRecords(RecoverContext* ctx, const std::shared_ptr<RecordBatch>& records) {
+    auto batch = std::make_shared<EntryBatch>();
+    uint32_t group_cnt = ctx->put_pools.size();
+    batch->groups.resize(group_cnt);
+    for (const auto& pos : records->pos) {
+        auto* entry = ::google::protobuf::Arena::CreateMessage<::openmldb::api::LogEntry>(&batch->arena);
+        if (!entry->ParseFromArray(records->buf.data() + pos.first, pos.second)) {
+            ctx->failed_cnt.fetch_add(1, std::memory_order_relaxed);
+            continue;
         }
-        // will close the fd atomic
-        delete seq_file;
-        if (g_succ_cnt) {
-            g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
+        uint32_t group = 0;
+        if (group_cnt > 1 && ctx->mem_table && entry->dimensions_size() > 0) {
+            group = ctx->mem_table->GetSegIdx(entry->dimensions(0).key()) % group_cnt;
         }
-        if (g_failed_cnt) {
-            g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+        batch->groups[group].push_back(entry);
+    }
+    for (uint32_t i = 0; i < group_cnt; i++) {
+        if (!batch->groups[i].empty()) {
+            ctx->put_pools[i]->AddTask([ctx, batch, i] { PutEntries(ctx, batch, i); });
         }
-    } while (false);
-    load_pool_.Stop();
+    }
 }
 
-void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std::vector<std::string*> recordPtr,
-                           std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt) {
-    ::openmldb::api::LogEntry entry;
-    for (auto it = recordPtr.cbegin(); it != recordPtr.cend(); it++) {
-        bool ok = entry.ParseFromString(**it);
-        if (!ok) {
-            failed_cnt->fetch_add(1, std::memory_order_relaxed);
-            delete *it;
+}  // namespace
+
+// the records are read by the caller thread, parsed by the parse pool and put by the put pools
+void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
+                                             std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
+    if (table == NULL) {
+        PDLOG(WARNING, "table input is NULL");
+        return;
+    }
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return;
+    }
+    if (FLAGS_load_table_read_buffer_size > 0) {
+        setvbuf(fd, NULL, _IOFBF, FLAGS_load_table_read_buffer_size);
+    }
+    uint32_t thread_num = std::max(FLAGS_load_table_thread_num, 1u);
+    uint32_t batch_size = std::max(FLAGS_load_table_batch, 1u);
+    RecoverContext ctx;
+    ctx.path = path;
+    ctx.table = table;
+    ctx.mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    for (uint32_t i = 0; i < thread_num; i++) {
+        ctx.put_pools.emplace_back(new ::openmldb::base::TaskPool(1, FLAGS_load_table_queue_size));
+    }
+    ::openmldb::base::TaskPool parse_pool(thread_num, FLAGS_load_table_queue_size);
+
+    bool compressed = IsCompressed(path);
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
+    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    std::string buffer;
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint64_t read_cnt = 0;
+    uint64_t read_bytes = 0;
+    auto records = std::make_shared<RecordBatch>();
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            break;
+        }
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            ctx.failed_cnt.fetch_add(1, std::memory_order_relaxed);
             continue;
         }
-        auto scount = succ_cnt->fetch_add(1, std::memory_order_relaxed);
-        if (scount % 100000 == 0) {
-            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), scount,
-                  failed_cnt->load(std::memory_order_relaxed));
+        records->pos.emplace_back(records->buf.size(), record.size());
+        records->buf.append(record.data(), record.size());
+        read_cnt++;
+        read_bytes += record.size();
+        if (records->pos.size() >= batch_size) {
+            parse_pool.AddTask([&ctx, records] { ParseRecords(&ctx, records); });
+            records = std::make_shared<RecordBatch>();
         }
-        table->Put(entry);
-        delete *it;
+    }
+    if (!records->pos.empty()) {
+        parse_pool.AddTask([&ctx, records] { ParseRecords(&ctx, records); });
+    }
+    // will close the fd atomic
+    delete seq_file;
+    // the parse pool must be drained before the put pools as it adds tasks to them
+    parse_pool.Stop();
+    for (auto& pool : ctx.put_pools) {
+        pool->Stop();
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros() - start_time;
+    uint64_t consumed_ms = std::max(consumed / 1000, static_cast<uint64_t>(1));
+    PDLOG(INFO,
+          "read path %s for table tid %u pid %u completed, succ_cnt %lu, failed_cnt %lu, consumed %lums, "
+          "%lu records/s, %.2f MB/s",
+          path.c_str(), tid_, pid_, ctx.succ_cnt.load(std::memory_order_relaxed),
+          ctx.failed_cnt.load(std::memory_order_relaxed), consumed_ms, read_cnt * 1000 / consumed_ms,
+          static_cast<double>(read_bytes) * 1000 / consumed_ms / 1024 / 1024);
+    if (g_succ_cnt) {
+        g_succ_cnt->fetch_add(ctx.succ_cnt, std::memory_order_relaxed);
+    }
+    if (g_failed_cnt) {
+        g_failed_cnt->fetch_add(ctx.failed_cnt, std::memory_order_relaxed);
     }
 }
 
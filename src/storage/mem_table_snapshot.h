@@ -61,9 +61,6 @@ class MemTableSnapshot : public Snapshot {
                     uint64_t& count, uint64_t& expired_key_num,  // NOLINT
                     uint64_t& deleted_key_num);                  // NOLINT
 
-    void Put(std::string& path, std::shared_ptr<Table>& table,  // NOLINT
-             std::vector<std::string*> recordPtr, std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
-
     std::string GenSnapshotName();
 
     base::Status GetAllDecoder(std::shared_ptr<Table> table, std::map<uint8_t, codec::RowView>* decoder_map);
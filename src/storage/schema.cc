@@ -129,6 +129,17 @@ uint32_t InnerIndexSt::GetKeyEntryMaxHeight(uint32_t abs_max_height, uint32_t la
     return max_height;
 }
 
+uint64_t InnerIndexSt::GetLatestKeepCnt() const {
+    if (index_.size() != 1) {
+        return 0;
+    }
+    auto ttl = index_[0]->GetTTL();
+    if (!ttl || ttl->ttl_type != ::openmldb::storage::TTLType::kLatestTime) {
+        return 0;
+    }
+    return ttl->lat_ttl;
+}
+
 bool ColumnDefSortFunc(const ColumnDef& cd_a, const ColumnDef& cd_b) { return (cd_a.GetId() < cd_b.GetId()); }
 
 TableIndex::TableIndex() {
@@ -233,6 +233,8 @@ class InnerIndexSt {
     inline const std::vector<uint32_t>& GetTsIdx() const { return ts_; }
     inline const std::vector<std::shared_ptr<IndexDef>>& GetIndex() const { return index_; }
     uint32_t GetKeyEntryMaxHeight(uint32_t abs_max_height, uint32_t lat_max_height) const;
+    // the lat_ttl if it is a single latest index, otherwise 0
+    uint64_t GetLatestKeepCnt() const;
 
  private:
     const uint32_t id_;
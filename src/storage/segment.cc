@@ -18,19 +18,35 @@
 
 #include <gflags/gflags.h>
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
 #include "common/timer.h"
+#include "storage/datablock_allocator.h"
 #include "storage/record.h"
 
 DECLARE_int32(gc_safe_offset);
 DECLARE_uint32(skiplist_max_height);
 DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_uint32(gc_expiry_index_full_scan_round);
+DECLARE_uint32(gc_pace_keys);
 
 namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+// the width of the buckets of the expiry index
+static constexpr uint64_t EXPIRY_BUCKET_MS = 60 * 1000;
+
+// yield the cpu to the puts and reads every gc_pace_keys keys
+static inline void PaceGc(uint64_t* visited) {
+    if (FLAGS_gc_pace_keys > 0 && ++(*visited) % FLAGS_gc_pace_keys == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
 Segment::Segment()
     : entries_(NULL),
       mu_(),
@@ -39,10 +55,23 @@ Segment::Segment()
       pk_cnt_(0),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      allocator_(nullptr),
+      allocator_shard_(0),
+      keep_cnt_(0),
+      expiry_index_(false),
+      compact_(false),
+      expiry_mu_(),
+      expiry_buckets_(),
+      expiry_byte_size_(0),
+      expiry_index_ready_(false),
+      ttl_gc_round_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    node_free_list_ = new DataNodeList(4, 4, tcmp);
+    compact_node_free_list_ = new DataNodeList(4, 4, tcmp);
+    cold_free_list_ = new ColdBlockFreeList(4, 4, tcmp);
 }
 
 Segment::Segment(uint8_t height)
@@ -54,9 +83,22 @@ Segment::Segment(uint8_t height)
       key_entry_max_height_(height),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      allocator_(nullptr),
+      allocator_shard_(0),
+      keep_cnt_(0),
+      expiry_index_(false),
+      compact_(false),
+      expiry_mu_(),
+      expiry_buckets_(),
+      expiry_byte_size_(0),
+      expiry_index_ready_(false),
+      ttl_gc_round_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    node_free_list_ = new DataNodeList(4, 4, tcmp);
+    compact_node_free_list_ = new DataNodeList(4, 4, tcmp);
+    cold_free_list_ = new ColdBlockFreeList(4, 4, tcmp);
 }
 
 Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
@@ -68,9 +110,22 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      allocator_(nullptr),
+      allocator_shard_(0),
+      keep_cnt_(0),
+      expiry_index_(false),
+      compact_(false),
+      expiry_mu_(),
+      expiry_buckets_(),
+      expiry_byte_size_(0),
+      expiry_index_ready_(false),
+      ttl_gc_round_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    node_free_list_ = new DataNodeList(4, 4, tcmp);
+    compact_node_free_list_ = new DataNodeList(4, 4, tcmp);
+    cold_free_list_ = new ColdBlockFreeList(4, 4, tcmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
         ts_idx_map_[ts_idx_vec[i]] = i;
         idx_cnt_vec_.push_back(std::make_shared<std::atomic<uint64_t>>(0));
@@ -80,6 +135,9 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
 Segment::~Segment() {
     delete entries_;
     delete entry_free_list_;
+    delete node_free_list_;
+    delete compact_node_free_list_;
+    delete cold_free_list_;
 }
 
 uint64_t Segment::Release() {
@@ -93,13 +151,13 @@ uint64_t Segment::Release() {
                 KeyEntry** entry_arr = (KeyEntry**)it->GetValue();  // NOLINT
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     cnt += entry_arr[i]->Release();
-                    delete entry_arr[i];
+                    KeyEntry::Delete(entry_arr[i]);
                 }
                 delete[] entry_arr;
             } else {
                 KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
                 cnt += entry->Release();
-                delete entry;
+                KeyEntry::Delete(entry);
             }
         }
         it->Next();
@@ -116,19 +174,41 @@ uint64_t Segment::Release() {
             KeyEntry** entry_arr = (KeyEntry**)node->GetValue();  // NOLINT
             for (uint32_t i = 0; i < ts_cnt_; i++) {
                 entry_arr[i]->Release();
-                delete entry_arr[i];
+                KeyEntry::Delete(entry_arr[i]);
             }
             delete[] entry_arr;
         } else {
             KeyEntry* entry = (KeyEntry*)node->GetValue();  // NOLINT
             entry->Release();
-            delete entry;
+            KeyEntry::Delete(entry);
         }
         delete node;
         f_it->Next();
     }
     delete f_it;
     entry_free_list_->Clear();
+
+    DataNodeList::Iterator* n_it = node_free_list_->NewIterator();
+    n_it->SeekToFirst();
+    while (n_it->Valid()) {
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = n_it->GetValue();
+        while (node != NULL) {
+            cnt++;
+            DataBlock* block = node->GetValue();
+            if (block->dim_cnt_down > 1) {
+                block->dim_cnt_down--;
+            } else if (block->IsHeapBlock()) {
+                delete block;
+            }
+            ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = node;
+            node = node->GetNextNoBarrier(0);
+            delete tmp;
+        }
+        n_it->Next();
+    }
+    delete n_it;
+    node_free_list_->Clear();
+    GcCompactFreeList(UINT64_MAX);
     idx_cnt_vec_.clear();
     return cnt;
 }
@@ -142,6 +222,9 @@ void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uin
         {
             std::lock_guard<std::mutex> lock(mu_);
             entry_node = entries_->Remove(key);
+            if (entry_node != NULL) {
+                SetRemoved(entry_node->GetValue());
+            }
         }
         if (entry_node != NULL) {
             FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
@@ -152,6 +235,8 @@ void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uin
     delete it;
     uint64_t cur_version = gc_version_.load(std::memory_order_relaxed);
     GcEntryFreeList(cur_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    GcNodeFreeList(cur_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    GcCompactFreeList(cur_version);
     Release();
 }
 
@@ -159,7 +244,12 @@ void Segment::Put(const Slice& key, uint64_t time, const char* data, uint32_t si
     if (ts_cnt_ > 1) {
         return;
     }
-    auto* db = new DataBlock(1, data, size);
+    DataBlock* db = nullptr;
+    if (allocator_ != nullptr) {
+        db = allocator_->New(allocator_shard_, 1, data, size);
+    } else {
+        db = new DataBlock(1, data, size);
+    }
     Put(key, time, db);
 }
 
@@ -167,61 +257,135 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
+    // the key exists in most cases, only the lock of its entry is needed
+    void* entry = nullptr;
+    int ret = entries_->Get(key, entry);
+    bool expiry_index = expiry_index_.load(std::memory_order_relaxed);
+    uint64_t last_time = 0;
+    if (ret == 0 && entry != nullptr &&
+        PutToEntry((KeyEntry*)entry, time, row, expiry_index ? &last_time : nullptr)) {  // NOLINT
+        idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+        if (expiry_index) {
+            UpdateExpiryKey(key, time, last_time);
+        }
+        return;
+    }
     std::lock_guard<std::mutex> lock(mu_);
     PutUnlock(key, time, row);
 }
 
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
+    KeyEntry* entry = (KeyEntry*)GetOrCreateEntry(key);  // NOLINT
+    // the entry can not be removed while holding mu_
+    uint64_t last_time = 0;
+    PutToEntry(entry, time, row, &last_time);
+    idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+    // a new key has no last time, so it is always indexed
+    UpdateExpiryKey(key, time, last_time);
+}
+
+void* Segment::GetOrCreateEntry(const Slice& key) {
     void* entry = nullptr;
-    uint32_t byte_size = 0;
     int ret = entries_->Get(key, entry);
-    if (ret < 0 || entry == NULL) {
-        char* pk = new char[key.size()];
-        memcpy(pk, key.data(), key.size());
-        // need to delete memory when free node
-        Slice skey(pk, key.size());
-        entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
+    if (ret == 0 && entry != nullptr) {
+        return entry;
+    }
+    char* pk = new char[key.size()];
+    memcpy(pk, key.data(), key.size());
+    // need to delete memory when free node
+    Slice skey(pk, key.size());
+    uint32_t byte_size = 0;
+    if (ts_cnt_ > 1) {
+        KeyEntry** entry_arr = new KeyEntry*[ts_cnt_];
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            entry_arr[i] = new KeyEntry(key_entry_max_height_);
+        }
+        entry = (void*)entry_arr;  // NOLINT
+        uint8_t height = entries_->Insert(skey, entry);
+        byte_size = GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
+    } else {
+        if (compact_.load(std::memory_order_relaxed)) {
+            entry = (void*)new ColdKeyEntry(key_entry_max_height_);  // NOLINT
+        } else {
+            entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
+        }
         uint8_t height = entries_->Insert(skey, entry);
-        byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
-        pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        byte_size = GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
     }
-    idx_cnt_.fetch_add(1, std::memory_order_relaxed);
-    uint8_t height = ((KeyEntry*)entry)->entries.Insert(time, row);  // NOLINT
-    ((KeyEntry*)entry)                                               // NOLINT
-        ->count_.fetch_add(1, std::memory_order_relaxed);
-    byte_size += GetRecordTsIdxSize(height);
     idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return entry;
+}
+
+bool Segment::PutToEntry(KeyEntry* entry, uint64_t time, DataBlock* row, uint64_t* last_time) {
+    uint8_t height = 0;
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = nullptr;
+    uint64_t keep_cnt = keep_cnt_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+        if (entry->removed_) {
+            return false;
+        }
+        if (last_time != nullptr && !entry->GetLastTime(last_time)) {
+            *last_time = UINT64_MAX;
+        }
+        height = entry->entries.Insert(time, row);
+        uint64_t cnt = entry->count_.fetch_add(1, std::memory_order_relaxed) + 1;
+        // trim with a slack of keep_cnt / 8 rows, so walking to the split position is amortized
+        if (keep_cnt > 0 && cnt > keep_cnt + keep_cnt / 8 && entry->GetColdBlocks() == nullptr) {
+            node = entry->entries.SplitByPos(keep_cnt);
+        }
+    }
+    idx_byte_size_.fetch_add(GetRecordTsIdxSize(height), std::memory_order_relaxed);
+    if (node != nullptr) {
+        uint64_t split_cnt = 0;
+        for (auto cur = node; cur != nullptr; cur = cur->GetNextNoBarrier(0)) {
+            split_cnt++;
+        }
+        entry->count_.fetch_sub(split_cnt, std::memory_order_relaxed);
+        idx_cnt_.fetch_sub(split_cnt, std::memory_order_relaxed);
+        // the readers may still be in the split nodes, they are freed after gc_deleted_pk_version_delta gc rounds
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        node_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), node);
+    }
+    return true;
+}
+
+uint32_t Segment::PutToEntries(KeyEntry** entry_arr, const std::vector<std::pair<uint32_t, uint64_t>>& ts_vec,
+                               uint32_t start, DataBlock* row) {
+    for (uint32_t i = start; i < ts_vec.size(); i++) {
+        // the entries of a key are removed together, the rest of ts_vec will fail too
+        if (!PutToEntry(entry_arr[ts_vec[i].first], ts_vec[i].second, row)) {
+            return i;
+        }
+        idx_cnt_vec_[ts_vec[i].first]->fetch_add(1, std::memory_order_relaxed);
+    }
+    return ts_vec.size();
+}
+
+void Segment::SetRemoved(void* entry) {
+    if (ts_cnt_ > 1) {
+        KeyEntry** entry_arr = (KeyEntry**)entry;  // NOLINT
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry_arr[i]->mu_);
+            entry_arr[i]->removed_ = true;
+        }
+    } else {
+        KeyEntry* key_entry = (KeyEntry*)entry;  // NOLINT
+        std::lock_guard<::openmldb::base::SpinMutex> lock(key_entry->mu_);
+        key_entry->removed_ = true;
+    }
 }
 
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
-    void* key_entry_or_list = nullptr;
-    uint32_t byte_size = 0;
     std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
-    int ret = entries_->Get(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
         PutUnlock(key, time, row);
-    } else {
-        if (ret < 0 || key_entry_or_list == nullptr) {
-            char* pk = new char[key.size()];
-            memcpy(pk, key.data(), key.size());
-            Slice skey(pk, key.size());
-            auto** entry_arr_tmp = new KeyEntry*[ts_cnt_];
-            for (uint32_t i = 0; i < ts_cnt_; i++) {
-                entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
-            }
-            auto entry_arr = (void*)entry_arr_tmp;  // NOLINT
-            uint8_t height = entries_->Insert(skey, entry_arr);
-            byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
-            pk_cnt_.fetch_add(1, std::memory_order_relaxed);
-        }
-        uint8_t height = ((KeyEntry**)key_entry_or_list)[key_entry_id]->entries.Insert(  // NOLINT
-            time, row);
-        ((KeyEntry**)key_entry_or_list)[key_entry_id]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
-        byte_size += GetRecordTsIdxSize(height);
-        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
-        idx_cnt_vec_[key_entry_id]->fetch_add(1, std::memory_order_relaxed);
+        return;
     }
+    KeyEntry** entry_arr = (KeyEntry**)GetOrCreateEntry(key);  // NOLINT
+    PutToEntry(entry_arr[key_entry_id], time, row);
+    idx_cnt_vec_[key_entry_id]->fetch_add(1, std::memory_order_relaxed);
 }
 
 void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
@@ -236,38 +400,30 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
         }
         return;
     }
-    void* entry_arr = NULL;
-    std::lock_guard<std::mutex> lock(mu_);
+    std::vector<std::pair<uint32_t, uint64_t>> ts_vec;
+    ts_vec.reserve(ts_size);
     for (const auto& kv : ts_map) {
-        uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(kv.first);
         if (pos == ts_idx_map_.end()) {
             continue;
         }
-        if (entry_arr == NULL) {
-            int ret = entries_->Get(key, entry_arr);
-            if (ret < 0 || entry_arr == NULL) {
-                char* pk = new char[key.size()];
-                memcpy(pk, key.data(), key.size());
-                Slice skey(pk, key.size());
-                KeyEntry** entry_arr_tmp = new KeyEntry*[ts_cnt_];
-                for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
-                }
-                entry_arr = (void*)entry_arr_tmp;  // NOLINT
-                uint8_t height = entries_->Insert(skey, entry_arr);
-                byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
-                pk_cnt_.fetch_add(1, std::memory_order_relaxed);
-            }
+        ts_vec.emplace_back(pos->second, kv.second);
+    }
+    if (ts_vec.empty()) {
+        return;
+    }
+    uint32_t start = 0;
+    void* entry_arr = nullptr;
+    int ret = entries_->Get(key, entry_arr);
+    if (ret == 0 && entry_arr != nullptr) {
+        start = PutToEntries((KeyEntry**)entry_arr, ts_vec, 0, row);  // NOLINT
+        if (start == ts_vec.size()) {
+            return;
         }
-        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.Insert(  // NOLINT
-            kv.second, row);
-        ((KeyEntry**)entry_arr)[pos->second]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
-        byte_size += GetRecordTsIdxSize(height);
-        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
-        idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
     }
+    std::lock_guard<std::mutex> lock(mu_);
+    entry_arr = GetOrCreateEntry(key);
+    PutToEntries((KeyEntry**)entry_arr, ts_vec, start, row);  // NOLINT
 }
 
 bool Segment::Delete(const Slice& key) {
@@ -278,6 +434,7 @@ bool Segment::Delete(const Slice& key) {
         if (entry_node == NULL) {
             return false;
         }
+        SetRemoved(entry_node->GetValue());
     }
     {
         std::lock_guard<std::mutex> lock(gc_mu_);
@@ -298,8 +455,12 @@ void Segment::FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint6
             tmp->GetValue()->dim_cnt_down--;
         } else {
             DEBUGLOG("delele data block for key %lu", tmp->GetKey());
-            gc_record_byte_size += GetRecordSize(tmp->GetValue()->size);
-            delete tmp->GetValue();
+            gc_record_byte_size += DataBlockAllocator::GetBlockByteSize(tmp->GetValue());
+            if (allocator_ != nullptr) {
+                allocator_->Free(tmp->GetValue());
+            } else {
+                delete tmp->GetValue();
+            }
             gc_record_cnt++;
         }
         delete tmp;
@@ -326,7 +487,7 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
                 FreeList(data_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
             delete it;
-            delete entry;
+            KeyEntry::Delete(entry);
             idx_cnt_vec_[i]->fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
         }
         delete[] entry_arr;
@@ -344,7 +505,12 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
             FreeList(data_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         }
         delete it;
-        delete entry;
+        const ColdBlockList* cold = entry->GetColdBlocks();
+        if (cold != nullptr) {
+            FreeColdBlocks(cold->blocks, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        }
+        // the cold blocks are freed with the entry
+        KeyEntry::Delete(entry);
         uint64_t byte_size =
             GetRecordPkIdxSize(entry_node->Height(), entry_node->GetKey().size(), key_entry_max_height_);
         idx_byte_size_.fetch_sub(byte_size, std::memory_order_relaxed);
@@ -370,6 +536,23 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
     }
 }
 
+void Segment::GcNodeFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                             uint64_t& gc_record_byte_size) {
+    ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<uint64_t, DataBlock*>*>* node = NULL;
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        node = node_free_list_->Split(version);
+    }
+    while (node != NULL) {
+        // the index count has been decreased when the nodes were split off
+        uint64_t freed_idx_cnt = 0;
+        FreeList(node->GetValue(), freed_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<uint64_t, DataBlock*>*>* tmp = node;
+        node = node->GetNextNoBarrier(0);
+        delete tmp;
+    }
+}
+
 void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
     uint64_t cur_version = gc_version_.load(std::memory_order_relaxed);
     if (cur_version < FLAGS_gc_deleted_pk_version_delta) {
@@ -377,6 +560,54 @@ void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t
     }
     uint64_t free_list_version = cur_version - FLAGS_gc_deleted_pk_version_delta;
     GcEntryFreeList(free_list_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    GcNodeFreeList(free_list_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    GcCompactFreeList(free_list_version);
+}
+
+void Segment::GcCompactFreeList(uint64_t version) {
+    ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<uint64_t, DataBlock*>*>* node = NULL;
+    ::openmldb::base::Node<uint64_t, const ColdBlockList*>* cold_node = NULL;
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        node = compact_node_free_list_->Split(version);
+        cold_node = cold_free_list_->Split(version);
+    }
+    while (node != NULL) {
+        ::openmldb::base::Node<uint64_t, DataBlock*>* data_node = node->GetValue();
+        while (data_node != NULL) {
+            ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = data_node;
+            data_node = data_node->GetNextNoBarrier(0);
+            if (allocator_ != nullptr) {
+                allocator_->Free(tmp->GetValue());
+            } else {
+                delete tmp->GetValue();
+            }
+            delete tmp;
+        }
+        ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<uint64_t, DataBlock*>*>* tmp = node;
+        node = node->GetNextNoBarrier(0);
+        delete tmp;
+    }
+    while (cold_node != NULL) {
+        // the dropped blocks are freed with the last list refers to them
+        delete cold_node->GetValue();
+        ::openmldb::base::Node<uint64_t, const ColdBlockList*>* tmp = cold_node;
+        cold_node = cold_node->GetNextNoBarrier(0);
+        delete tmp;
+    }
+}
+
+void Segment::SetColdBlocks(KeyEntry* entry, const ColdBlockList* list) {
+    if (!entry->IsCompactable()) {
+        delete list;
+        return;
+    }
+    const ColdBlockList* old =
+        static_cast<ColdKeyEntry*>(entry)->cold_.exchange(list, std::memory_order_acq_rel);
+    if (old != nullptr) {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        cold_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), old);
+    }
 }
 
 void Segment::ExecuteGc(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
@@ -450,19 +681,24 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
     }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
+    uint64_t visited = 0;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
+        PaceGc(&visited);
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+        std::vector<std::shared_ptr<const ColdBlock>> dropped;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByPos(keep_cnt);
             }
+            SplitColdBlocks(entry, 0, keep_cnt, false, &dropped);
         }
         uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        FreeColdBlocks(dropped, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
         it->Next();
@@ -477,9 +713,11 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         uint64_t& gc_record_byte_size) {
     uint64_t old = gc_idx_cnt;
     uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t visited = 0;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
+        PaceGc(&visited);
         KeyEntry** entry_arr = (KeyEntry**)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
@@ -502,7 +740,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
                         SplitList(entry, kv.second.abs_ttl, &node);
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
@@ -511,7 +749,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     break;
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
                     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                         node = entry->entries.SplitByPos(kv.second.lat_ttl);
                     }
@@ -523,7 +761,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
                         }
@@ -536,7 +774,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             if (kv.second.abs_ttl == 0) {
                                 node = entry->entries.SplitByPos(kv.second.lat_ttl);
@@ -569,14 +807,21 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
             {
                 std::lock_guard<std::mutex> lock(mu_);
+                // hold the locks of all the entries, so no put can slip in between the check and the removal
+                std::vector<std::unique_lock<::openmldb::base::SpinMutex>> entry_locks;
+                entry_locks.reserve(ts_cnt_);
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    if (!entry_arr[i]->entries.IsEmpty()) {
+                    entry_locks.emplace_back(entry_arr[i]->mu_);
+                    if (entry_arr[i]->removed_ || !entry_arr[i]->entries.IsEmpty()) {
                         is_empty = false;
                         break;
                     }
                 }
                 if (is_empty) {
                     entry_node = entries_->Remove(key);
+                    for (uint32_t i = 0; i < ts_cnt_; i++) {
+                        entry_arr[i]->removed_ = true;
+                    }
                 }
             }
             if (entry_node != NULL) {
@@ -597,44 +842,309 @@ void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uin
     }
 }
 
-// fast gc with no global pause
-void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
-                     uint64_t& gc_record_byte_size) {
+void Segment::SplitColdBlocks(KeyEntry* entry, uint64_t expire_time, uint64_t keep_cnt, bool and_mode,
+                              std::vector<std::shared_ptr<const ColdBlock>>* dropped) {
+    const ColdBlockList* cold = entry->GetColdBlocks();
+    if (cold == nullptr || entry->refs_.load(std::memory_order_acquire) > 0) {
+        return;
+    }
+    // the blocks are older than the rows of entries, so the expired blocks are a suffix of the list
+    uint64_t cnt = keep_cnt > 0 ? entry->entries.GetSize() : 0;
+    uint32_t pos = 0;
+    for (; pos < cold->blocks.size(); pos++) {
+        const auto& block = cold->blocks[pos];
+        bool abs_expired = expire_time > 0 && block->GetMaxTime() <= expire_time;
+        bool lat_expired = keep_cnt > 0 && cnt >= keep_cnt;
+        if (and_mode ? (abs_expired && lat_expired) : (abs_expired || lat_expired)) {
+            break;
+        }
+        cnt += block->GetCount();
+    }
+    if (pos == cold->blocks.size()) {
+        return;
+    }
+    dropped->assign(cold->blocks.begin() + pos, cold->blocks.end());
+    ColdBlockList* remain = nullptr;
+    if (pos > 0) {
+        remain = new ColdBlockList();
+        remain->blocks.assign(cold->blocks.begin(), cold->blocks.begin() + pos);
+        remain->count = cold->count;
+        for (const auto& block : *dropped) {
+            remain->count -= block->GetCount();
+        }
+    }
+    SetColdBlocks(entry, remain);
+}
+
+void Segment::FreeColdBlocks(const std::vector<std::shared_ptr<const ColdBlock>>& dropped, uint64_t& gc_idx_cnt,
+                             uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    // the blocks are freed with the replaced list by GcCompactFreeList
+    for (const auto& block : dropped) {
+        gc_idx_cnt += block->GetCount();
+        gc_record_cnt += block->GetCount();
+        gc_record_byte_size += block->GetByteSize();
+    }
+}
+
+void Segment::Compact(uint32_t hot_cnt, uint32_t block_rows, bool compress, uint64_t& freed_byte_size,
+                      uint64_t& block_byte_size) {
+    if (ts_cnt_ > 1 || block_rows == 0) {
+        return;
+    }
     uint64_t consumed = ::baidu::common::timer::get_micros();
-    uint64_t old = gc_idx_cnt;
+    uint64_t compacted_cnt = 0;
+    std::vector<std::pair<uint64_t, Slice>> rows;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
-        Slice key = it->GetKey();
         it->Next();
-        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == NULL) {
-            continue;
-        } else if (node->GetKey() > time) {
-            DEBUGLOG(
-                "[Gc4TTL] segment gc with key %lu need not ttl, last node "
-                "key %lu",
-                time, node->GetKey());
+        // the entries created before compaction was turned on stay hot
+        if (!entry->IsCompactable()) {
             continue;
         }
-        node = NULL;
-        ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
-            SplitList(entry, time, &node);
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+            if (entry->removed_ || entry->refs_.load(std::memory_order_acquire) > 0) {
+                continue;
+            }
+            rows.clear();
+            bool shared = false;
+            TimeEntries::Iterator* time_it = entry->entries.NewIterator();
+            time_it->SeekToFirst();
+            for (uint32_t i = 0; i < hot_cnt && time_it->Valid(); i++) {
+                time_it->Next();
+            }
+            while (time_it->Valid()) {
+                DataBlock* block = time_it->GetValue();
+                // the row is still referred by other indexes
+                if (block->dim_cnt_down > 1) {
+                    shared = true;
+                    break;
+                }
+                rows.emplace_back(time_it->GetKey(), Slice(block->data, block->size));
+                time_it->Next();
+            }
+            delete time_it;
+            // only full blocks are frozen, the rest rows stay in entries
+            uint64_t frozen_cnt = rows.size() / block_rows * block_rows;
+            if (shared || frozen_cnt == 0) {
+                continue;
             }
+            uint64_t start = rows.size() - frozen_cnt;
+            const ColdBlockList* cold = entry->GetColdBlocks();
+            if (cold != nullptr && rows.back().first < cold->GetMaxTime()) {
+                // the late rows would break the order of the blocks
+                continue;
+            }
+            ColdBlockList* list = new ColdBlockList();
+            for (uint64_t i = start; i < rows.size(); i += block_rows) {
+                std::vector<std::pair<uint64_t, Slice>> block_rows_vec(rows.begin() + i,
+                                                                        rows.begin() + i + block_rows);
+                auto block = std::make_shared<const ColdBlock>(block_rows_vec, compress);
+                block_byte_size += block->GetByteSize();
+                list->blocks.push_back(block);
+            }
+            list->count = frozen_cnt;
+            if (cold != nullptr) {
+                list->blocks.insert(list->blocks.end(), cold->blocks.begin(), cold->blocks.end());
+                list->count += cold->count;
+            }
+            // publish the blocks before removing the rows, so a reader never misses them
+            SetColdBlocks(entry, list);
+            node = entry->entries.SplitByPos(hot_cnt + start);
         }
-        if (entry_node != NULL) {
-            std::lock_guard<std::mutex> lock(gc_mu_);
-            entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+        if (node == NULL) {
+            continue;
         }
-        uint64_t entry_gc_idx_cnt = 0;
-        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-        entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
-        gc_idx_cnt += entry_gc_idx_cnt;
+        for (auto cur = node; cur != NULL; cur = cur->GetNextNoBarrier(0)) {
+            idx_byte_size_.fetch_sub(GetRecordTsIdxSize(cur->Height()));
+            freed_byte_size += DataBlockAllocator::GetBlockByteSize(cur->GetValue());
+            compacted_cnt++;
+        }
+        // the readers may still be in the split nodes, they are freed after gc_deleted_pk_version_delta gc rounds
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        compact_node_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), node);
+    }
+    DEBUGLOG("[Compact] segment compact consumed %lu, count %lu",
+             (::baidu::common::timer::get_micros() - consumed) / 1000, compacted_cnt);
+    delete it;
+}
+
+::openmldb::base::Node<Slice, void*>* Segment::RemoveIfEmpty(const Slice& key, KeyEntry* entry) {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::lock_guard<::openmldb::base::SpinMutex> entry_lock(entry->mu_);
+    // a put may have come in after the split
+    if (entry->removed_ || !entry->IsEmpty()) {
+        return NULL;
+    }
+    entry->removed_ = true;
+    return entries_->Remove(key);
+}
+
+void Segment::SetCompact(bool enable) {
+    if (ts_cnt_ > 1) {
+        return;
+    }
+    compact_.store(enable, std::memory_order_relaxed);
+}
+
+void Segment::SetExpiryIndex(bool enable) {
+    if (ts_cnt_ > 1) {
+        return;
+    }
+    if (expiry_index_.exchange(enable, std::memory_order_relaxed) && !enable) {
+        std::lock_guard<std::mutex> lock(expiry_mu_);
+        expiry_buckets_.clear();
+        idx_byte_size_.fetch_sub(expiry_byte_size_, std::memory_order_relaxed);
+        expiry_byte_size_ = 0;
+        expiry_index_ready_ = false;
+    }
+}
+
+void Segment::AddExpiryKey(const Slice& key, uint64_t time, uint64_t last_time) {
+    if (!expiry_index_.load(std::memory_order_relaxed) || ts_cnt_ > 1) {
+        return;
+    }
+    uint64_t bucket = time / EXPIRY_BUCKET_MS * EXPIRY_BUCKET_MS;
+    std::string pk(key.data(), key.size());
+    std::lock_guard<std::mutex> lock(expiry_mu_);
+    auto& keys = expiry_buckets_[bucket];
+    if (last_time != UINT64_MAX) {
+        auto iter = expiry_buckets_.find(last_time / EXPIRY_BUCKET_MS * EXPIRY_BUCKET_MS);
+        if (iter != expiry_buckets_.end() && iter->second.count(pk) > 0) {
+            // reuse the copy of the key, the memory is unchanged
+            keys.insert(iter->second.extract(pk));
+            if (iter->second.empty()) {
+                expiry_buckets_.erase(iter);
+            }
+            return;
+        }
+    }
+    uint64_t byte_size = sizeof(std::string) + key.size();
+    if (keys.insert(std::move(pk)).second) {
+        expiry_byte_size_ += byte_size;
+        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    }
+}
+
+void Segment::UpdateExpiryKey(const Slice& key, uint64_t time, uint64_t last_time) {
+    if (time / EXPIRY_BUCKET_MS < last_time / EXPIRY_BUCKET_MS) {
+        AddExpiryKey(key, time, last_time);
+    }
+}
+
+bool Segment::GcEntry4TTL(const Slice& key, KeyEntry* entry, const uint64_t time, uint64_t& gc_idx_cnt,
+                          uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    uint64_t last_time = 0;
+    if (!entry->GetLastTime(&last_time)) {
+        return true;
+    } else if (last_time > time) {
+        DEBUGLOG(
+            "[Gc4TTL] segment gc with key %lu need not ttl, last node "
+            "key %lu",
+            time, last_time);
+        return true;
+    }
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+    std::vector<std::shared_ptr<const ColdBlock>> dropped;
+    bool is_empty = false;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+        SplitList(entry, time, &node);
+        SplitColdBlocks(entry, time, 0, false, &dropped);
+        is_empty = entry->IsEmpty();
+    }
+    ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+    if (is_empty) {
+        entry_node = RemoveIfEmpty(key, entry);
+    }
+    if (entry_node != NULL) {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+    }
+    uint64_t entry_gc_idx_cnt = 0;
+    FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    FreeColdBlocks(dropped, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
+    gc_idx_cnt += entry_gc_idx_cnt;
+    return entry_node == NULL;
+}
+
+// fast gc with no global pause
+void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                     uint64_t& gc_record_byte_size) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = gc_idx_cnt;
+    bool use_index = expiry_index_.load(std::memory_order_relaxed);
+    bool incremental = false;
+    std::vector<std::string> keys;
+    if (use_index) {
+        std::lock_guard<std::mutex> lock(expiry_mu_);
+        ttl_gc_round_++;
+        if (expiry_index_ready_ && (FLAGS_gc_expiry_index_full_scan_round == 0 ||
+                                    ttl_gc_round_ % FLAGS_gc_expiry_index_full_scan_round != 0)) {
+            // the buckets starting after time have no expired rows
+            auto end = expiry_buckets_.upper_bound(time);
+            uint64_t byte_size = 0;
+            for (auto iter = expiry_buckets_.begin(); iter != end; ++iter) {
+                auto& bucket_keys = iter->second;
+                while (!bucket_keys.empty()) {
+                    auto key = bucket_keys.extract(bucket_keys.begin());
+                    byte_size += sizeof(std::string) + key.value().size();
+                    keys.emplace_back(std::move(key.value()));
+                }
+            }
+            expiry_buckets_.erase(expiry_buckets_.begin(), end);
+            expiry_byte_size_ -= byte_size;
+            idx_byte_size_.fetch_sub(byte_size, std::memory_order_relaxed);
+            incremental = true;
+        } else {
+            // rebuild the index with a full scan, the keys created meanwhile add themselves
+            expiry_buckets_.clear();
+            idx_byte_size_.fetch_sub(expiry_byte_size_, std::memory_order_relaxed);
+            expiry_byte_size_ = 0;
+            expiry_index_ready_ = false;
+        }
+    }
+    if (incremental) {
+        // a key put while the buckets were consumed may be in several of them
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        uint64_t visited = 0;
+        for (const auto& key : keys) {
+            PaceGc(&visited);
+            Slice skey(key.data(), key.size());
+            void* entry = nullptr;
+            if (entries_->Get(skey, entry) < 0 || entry == nullptr) {
+                continue;
+            }
+            if (GcEntry4TTL(skey, (KeyEntry*)entry, time, gc_idx_cnt, gc_record_cnt,  // NOLINT
+                            gc_record_byte_size)) {
+                AddExpiryKey((KeyEntry*)entry, skey);  // NOLINT
+            }
+        }
+        DEBUGLOG("[Gc4TTL] segment gc with key %lu by expiry index, visited %lu consumed %lu, count %lu", time,
+                 keys.size(), (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
+        idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t visited = 0;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        PaceGc(&visited);
+        KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        Slice key = it->GetKey();
+        it->Next();
+        if (GcEntry4TTL(key, entry, time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size) && use_index) {
+            AddExpiryKey(entry, key);
+        }
+    }
+    if (use_index) {
+        std::lock_guard<std::mutex> lock(expiry_mu_);
+        expiry_index_ready_ = true;
     }
     DEBUGLOG("[Gc4TTL] segment gc with key %lu ,consumed %lu, count %lu", time,
              (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
@@ -642,6 +1152,13 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
     delete it;
 }
 
+void Segment::AddExpiryKey(KeyEntry* entry, const Slice& key) {
+    uint64_t last_time = 0;
+    if (entry->GetLastTime(&last_time)) {
+        AddExpiryKey(key, last_time, UINT64_MAX);
+    }
+}
+
 void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                             uint64_t& gc_record_byte_size) {
     if (time == 0 || keep_cnt == 0) {
@@ -650,30 +1167,35 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
     }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
+    uint64_t visited = 0;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
+        PaceGc(&visited);
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
-        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
         it->Next();
-        if (node == NULL) {
+        uint64_t last_time = 0;
+        if (!entry->GetLastTime(&last_time)) {
             continue;
-        } else if (node->GetKey() > time) {
+        } else if (last_time > time) {
             DEBUGLOG(
                 "[Gc4TTLAndHead] segment gc with key %lu need not ttl, last "
                 "node key %lu",
-                time, node->GetKey());
+                time, last_time);
             continue;
         }
-        node = NULL;
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+        std::vector<std::shared_ptr<const ColdBlock>> dropped;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
             }
+            SplitColdBlocks(entry, time, keep_cnt, true, &dropped);
         }
         uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        FreeColdBlocks(dropped, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
     }
@@ -699,26 +1221,31 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
     }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
+    uint64_t visited = 0;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
+        PaceGc(&visited);
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
-        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == NULL) {
+        if (entry->IsEmpty()) {
             continue;
         }
-        node = NULL;
-        ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+        std::vector<std::shared_ptr<const ColdBlock>> dropped;
+        bool is_empty = false;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
             }
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
-            }
+            SplitColdBlocks(entry, time, keep_cnt, false, &dropped);
+            is_empty = entry->IsEmpty();
+        }
+        ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        if (is_empty) {
+            entry_node = RemoveIfEmpty(key, entry);
         }
         if (entry_node != NULL) {
             std::lock_guard<std::mutex> lock(gc_mu_);
@@ -726,6 +1253,7 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         }
         uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        FreeColdBlocks(dropped, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
     }
@@ -776,7 +1304,7 @@ MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket) {
         return new MemTableIterator(NULL);
     }
     ticket.Push((KeyEntry*)entry);                                           // NOLINT
-    return new MemTableIterator(((KeyEntry*)entry)->entries.NewIterator());  // NOLINT
+    return new MemTableIterator(((KeyEntry*)entry)->NewIterator());  // NOLINT
 }
 
 MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket) {
@@ -792,10 +1320,172 @@ MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& t
         return new MemTableIterator(NULL);
     }
     ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                         // NOLINT
-    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->entries.NewIterator());  // NOLINT
+    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->NewIterator());  // NOLINT
+}
+
+uint64_t KeyEntry::Release() {
+    uint64_t cnt = 0;
+    TimeEntries::Iterator* it = entries.NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        cnt += 1;
+        DataBlock* block = it->GetValue();
+        // Avoid double free
+        if (block->dim_cnt_down > 1) {
+            block->dim_cnt_down--;
+        } else if (block->IsHeapBlock()) {
+            // the slab blocks are released with their DataBlockAllocator
+            delete block;
+        }
+        it->Next();
+    }
+    entries.Clear();
+    delete it;
+    if (compactable_) {
+        const ColdBlockList* cold =
+            static_cast<ColdKeyEntry*>(this)->cold_.exchange(nullptr, std::memory_order_relaxed);
+        if (cold != nullptr) {
+            cnt += cold->count;
+            delete cold;
+        }
+    }
+    return cnt;
+}
+
+bool KeyEntry::GetLastTime(uint64_t* time) {
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = entries.GetLast();
+    const ColdBlockList* cold = GetColdBlocks();
+    if (node == NULL && cold == nullptr) {
+        return false;
+    }
+    if (node == NULL) {
+        *time = cold->GetMinTime();
+    } else if (cold == nullptr) {
+        *time = node->GetKey();
+    } else {
+        *time = std::min(node->GetKey(), cold->GetMinTime());
+    }
+    return true;
+}
+
+KeyEntryIterator::KeyEntryIterator(TimeEntries* entries, const ColdBlockList* cold)
+    : it_(entries),
+      hot_end_(false),
+      cold_(cold),
+      bufs_(),
+      block_idx_(0),
+      payload_(),
+      offset_(0),
+      cold_time_(0),
+      cold_row_(),
+      cold_valid_(false) {
+    if (cold_ != nullptr) {
+        bufs_.resize(cold_->blocks.size());
+    }
+}
+
+bool KeyEntryIterator::IsHot() const {
+    if (!HotValid()) {
+        return false;
+    }
+    // the row of entries goes first if the time is the same
+    return !cold_valid_ || it_.GetKey() >= cold_time_;
+}
+
+bool KeyEntryIterator::Valid() const { return HotValid() || cold_valid_; }
+
+void KeyEntryIterator::Next() {
+    if (IsHot()) {
+        it_.Next();
+    } else {
+        NextCold();
+    }
+}
+
+const uint64_t& KeyEntryIterator::GetKey() const {
+    if (IsHot()) {
+        return it_.GetKey();
+    }
+    return cold_time_;
+}
+
+Slice KeyEntryIterator::GetValue() {
+    if (IsHot()) {
+        DataBlock* block = it_.GetValue();
+        return Slice(block->data, block->size);
+    }
+    return cold_row_;
+}
+
+void KeyEntryIterator::LoadBlock(uint32_t idx) {
+    cold_valid_ = false;
+    block_idx_ = idx;
+    if (cold_ == nullptr || idx >= cold_->blocks.size()) {
+        return;
+    }
+    const auto& block = cold_->blocks[idx];
+    if (block->IsCompressed() && !bufs_[idx].empty()) {
+        // keep the rows returned before valid
+        payload_ = Slice(bufs_[idx].data(), bufs_[idx].size());
+    } else if (!block->GetPayload(&bufs_[idx], &payload_)) {
+        PDLOG(WARNING, "fail to uncompress cold block. count %u max time %lu", block->GetCount(),
+              block->GetMaxTime());
+        return;
+    }
+    offset_ = 0;
+    cold_time_ = block->GetMaxTime();
+    cold_valid_ = ColdBlock::ReadRow(payload_, &offset_, &cold_time_, &cold_row_);
+}
+
+void KeyEntryIterator::NextCold() {
+    if (offset_ < payload_.size()) {
+        cold_valid_ = ColdBlock::ReadRow(payload_, &offset_, &cold_time_, &cold_row_);
+    } else {
+        LoadBlock(block_idx_ + 1);
+    }
+}
+
+void KeyEntryIterator::Seek(uint64_t time) {
+    hot_end_ = false;
+    it_.Seek(time);
+    if (cold_ == nullptr) {
+        return;
+    }
+    uint32_t idx = 0;
+    while (idx < cold_->blocks.size() && cold_->blocks[idx]->GetMinTime() > time) {
+        idx++;
+    }
+    LoadBlock(idx);
+    while (cold_valid_ && cold_time_ > time) {
+        NextCold();
+    }
+}
+
+void KeyEntryIterator::SeekToFirst() {
+    hot_end_ = false;
+    it_.SeekToFirst();
+    if (cold_ != nullptr) {
+        LoadBlock(0);
+    }
+}
+
+void KeyEntryIterator::SeekToLast() {
+    hot_end_ = false;
+    it_.SeekToLast();
+    cold_valid_ = false;
+    if (cold_ == nullptr) {
+        return;
+    }
+    if (!it_.Valid() || cold_->GetMinTime() <= it_.GetKey()) {
+        hot_end_ = true;
+        LoadBlock(cold_->blocks.size() - 1);
+        while (cold_valid_ && offset_ < payload_.size()) {
+            cold_valid_ = ColdBlock::ReadRow(payload_, &offset_, &cold_time_, &cold_row_);
+        }
+    }
 }
 
-MemTableIterator::MemTableIterator(TimeEntries::Iterator* it) : it_(it) {}
+MemTableIterator::MemTableIterator(KeyEntryIterator* it) : it_(it) {}
 
 MemTableIterator::~MemTableIterator() {
     if (it_ != NULL) {
@@ -825,7 +1515,7 @@ void MemTableIterator::Next() {
 }
 
 ::openmldb::base::Slice MemTableIterator::GetValue() const {
-    return ::openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
+    return it_->GetValue();
 }
 
 uint64_t MemTableIterator::GetKey() const { return it_->GetKey(); }
@@ -21,11 +21,16 @@
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "base/skiplist.h"
 #include "base/slice.h"
+#include "base/spinlock.h"
 #include "proto/tablet.pb.h"
+#include "storage/cold_block.h"
 #include "storage/iterator.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
@@ -39,20 +44,28 @@ using ::openmldb::base::Slice;
 
 class Segment;
 class Ticket;
+class DataBlockAllocator;
+
+// the block is allocated by new, not by DataBlockAllocator
+static const uint8_t HEAP_DATA_BLOCK = UINT8_MAX;
 
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // the size class and shard in DataBlockAllocator
+    uint8_t slab_class;
+    uint8_t slab_shard;
     uint32_t size;
     char* data;
 
-    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len)
+        : dim_cnt_down(dim_cnt), slab_class(HEAP_DATA_BLOCK), slab_shard(0), size(len), data(NULL) {
         data = new char[len];
         memcpy(data, input, len);
     }
 
     DataBlock(uint8_t dim_cnt, char* input, uint32_t len, bool skip_copy)
-        : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+        : dim_cnt_down(dim_cnt), slab_class(HEAP_DATA_BLOCK), slab_shard(0), size(len), data(NULL) {
         if (skip_copy) {
             data = input;
         } else {
@@ -61,8 +74,19 @@ struct DataBlock {
         }
     }
 
+    // the payload is placed right after the header, used by DataBlockAllocator
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len, uint8_t cls, uint8_t shard)
+        : dim_cnt_down(dim_cnt), slab_class(cls), slab_shard(shard), size(len), data(NULL) {
+        data = reinterpret_cast<char*>(this) + sizeof(DataBlock);
+        memcpy(data, input, len);
+    }
+
+    bool IsHeapBlock() const { return slab_class == HEAP_DATA_BLOCK; }
+
     ~DataBlock() {
-        delete[] data;
+        if (IsHeapBlock()) {
+            delete[] data;
+        }
         data = NULL;
     }
 };
@@ -82,9 +106,50 @@ struct TimeComparator {
 static const TimeComparator tcmp;
 typedef ::openmldb::base::Skiplist<uint64_t, DataBlock*, TimeComparator> TimeEntries;
 
+// Iterate the rows of a KeyEntry in time desc, merging the skiplist and the cold blocks
+class KeyEntryIterator {
+ public:
+    // cold is null if the entry has no cold blocks
+    KeyEntryIterator(TimeEntries* entries, const ColdBlockList* cold);
+    ~KeyEntryIterator() {}
+
+    KeyEntryIterator(const KeyEntryIterator&) = delete;
+    KeyEntryIterator& operator=(const KeyEntryIterator&) = delete;
+
+    bool Valid() const;
+    void Next();
+    // seek to the first row whose time is not larger than time
+    void Seek(uint64_t time);
+    void SeekToFirst();
+    void SeekToLast();
+    const uint64_t& GetKey() const;
+    Slice GetValue();
+
+ private:
+    bool HotValid() const { return !hot_end_ && it_.Valid(); }
+    // the current row is from the skiplist
+    bool IsHot() const;
+    // position the cold cursor at the first row of block idx
+    void LoadBlock(uint32_t idx);
+    void NextCold();
+
+ private:
+    TimeEntries::Iterator it_;
+    bool hot_end_;
+    const ColdBlockList* cold_;
+    // the uncompressed payloads, the rows returned refer to them
+    std::vector<std::string> bufs_;
+    uint32_t block_idx_;
+    Slice payload_;
+    uint32_t offset_;
+    uint64_t cold_time_;
+    Slice cold_row_;
+    bool cold_valid_;
+};
+
 class MemTableIterator : public TableIterator {
  public:
-    explicit MemTableIterator(TimeEntries::Iterator* it);
+    explicit MemTableIterator(KeyEntryIterator* it);
     virtual ~MemTableIterator();
     void Seek(const uint64_t time) override;
     bool Valid() override;
@@ -95,35 +160,23 @@ class MemTableIterator : public TableIterator {
     void SeekToLast() override;
 
  private:
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
 };
 
+class ColdKeyEntry;
+
 class KeyEntry {
  public:
-    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0) {}
-    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0) {}
+    KeyEntry() : entries(12, 4, tcmp), count_(0), refs_(0), mu_(), removed_(false), compactable_(false) {}
+    explicit KeyEntry(uint8_t height)
+        : entries(height, 4, tcmp), count_(0), refs_(0), mu_(), removed_(false), compactable_(false) {}
     ~KeyEntry() {}
 
+    // delete the entry as the class it was created, a KeyEntry has no vtable to keep it small
+    static void Delete(KeyEntry* entry);
+
     // just return the count of datablock
-    uint64_t Release() {
-        uint64_t cnt = 0;
-        TimeEntries::Iterator* it = entries.NewIterator();
-        it->SeekToFirst();
-        while (it->Valid()) {
-            cnt += 1;
-            DataBlock* block = it->GetValue();
-            // Avoid double free
-            if (block->dim_cnt_down > 1) {
-                block->dim_cnt_down--;
-            } else {
-                delete block;
-            }
-            it->Next();
-        }
-        entries.Clear();
-        delete it;
-        return cnt;
-    }
+    uint64_t Release();
 
     void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
 
@@ -131,19 +184,75 @@ class KeyEntry {
 
     uint64_t GetCount() { return count_.load(std::memory_order_relaxed); }
 
+    KeyEntryIterator* NewIterator() { return new KeyEntryIterator(&entries, GetColdBlocks()); }
+
+    // whether the entry is a ColdKeyEntry which Segment::Compact may freeze rows of
+    bool IsCompactable() const { return compactable_; }
+
+    const ColdBlockList* GetColdBlocks() const;
+
+    bool IsEmpty() { return entries.IsEmpty() && GetColdBlocks() == nullptr; }
+
+    // the time of the oldest row, return false if the entry is empty
+    bool GetLastTime(uint64_t* time);
+
  public:
     TimeEntries entries;
-    std::atomic<uint64_t> refs_;
     std::atomic<uint64_t> count_;
+    std::atomic<uint32_t> refs_;
     friend Segment;
+
+ protected:
+    KeyEntry(uint8_t height, bool compactable)
+        : entries(height, 4, tcmp), count_(0), refs_(0), mu_(), removed_(false), compactable_(compactable) {}
+
+ private:
+    // serialize the writers of entries, the readers need no lock
+    ::openmldb::base::SpinMutex mu_;
+    // set under mu_ when the entry is removed from the segment, the put which
+    // looked up the entry before the removal has to retry with the segment lock
+    bool removed_;
+    bool compactable_;
 };
 
+// the key entry of the segments with compaction on, only they pay for the pointer to the cold blocks
+class ColdKeyEntry : public KeyEntry {
+ public:
+    explicit ColdKeyEntry(uint8_t height) : KeyEntry(height, true), cold_(nullptr) {}
+    ~ColdKeyEntry() { delete cold_.load(std::memory_order_relaxed); }
+
+ private:
+    friend KeyEntry;
+    friend Segment;
+    // the rows frozen by Segment::Compact, all older than the rows compacted from entries.
+    // replaced under mu_, the replaced list is freed by Segment::GcFreeList
+    std::atomic<const ColdBlockList*> cold_;
+};
+
+inline void KeyEntry::Delete(KeyEntry* entry) {
+    if (entry != nullptr && entry->compactable_) {
+        delete static_cast<ColdKeyEntry*>(entry);
+    } else {
+        delete entry;
+    }
+}
+
+inline const ColdBlockList* KeyEntry::GetColdBlocks() const {
+    if (!compactable_) {
+        return nullptr;
+    }
+    return static_cast<const ColdKeyEntry*>(this)->cold_.load(std::memory_order_acquire);
+}
+
 struct SliceComparator {
     int operator()(const ::openmldb::base::Slice& a, const ::openmldb::base::Slice& b) const { return a.compare(b); }
 };
 
 typedef ::openmldb::base::Skiplist<::openmldb::base::Slice, void*, SliceComparator> KeyEntries;
 typedef ::openmldb::base::Skiplist<uint64_t, ::openmldb::base::Node<Slice, void*>*, TimeComparator> KeyEntryNodeList;
+typedef ::openmldb::base::Skiplist<uint64_t, ::openmldb::base::Node<uint64_t, DataBlock*>*, TimeComparator>
+    DataNodeList;
+typedef ::openmldb::base::Skiplist<uint64_t, const ColdBlockList*, TimeComparator> ColdBlockFreeList;
 
 class Segment {
  public:
@@ -189,6 +298,11 @@ class Segment {
     void GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& gc_idx_cnt,  // NOLINT
                    uint64_t& gc_record_cnt,                                            // NOLINT
                    uint64_t& gc_record_byte_size);                                     // NOLINT
+    // freeze the rows after the latest hot_cnt rows of every key entry into cold blocks of block_rows rows.
+    // only the entries created after SetCompact(true) of single ts segments are compacted
+    void Compact(uint32_t hot_cnt, uint32_t block_rows, bool compress,
+                 uint64_t& freed_byte_size,   // NOLINT
+                 uint64_t& block_byte_size);  // NOLINT
     MemTableIterator* NewIterator(const Slice& key, Ticket& ticket);                   // NOLINT
     MemTableIterator* NewIterator(const Slice& key, uint32_t idx,
                                   Ticket& ticket);  // NOLINT
@@ -240,22 +354,85 @@ class Segment {
                          uint64_t& gc_record_cnt,         // NOLINT
                          uint64_t& gc_record_byte_size);  // NOLINT
 
+    // trim a key entry to its latest keep_cnt rows on put instead of waiting for Gc4Head, 0 to disable.
+    // only for the single ts segments whose rows are not shared with other indexes. the trimmed rows
+    // are freed by GcFreeList like the deleted keys
+    void SetKeepCnt(uint64_t keep_cnt) { keep_cnt_.store(keep_cnt, std::memory_order_relaxed); }
+
+    // keep the keys in buckets of their oldest time, so Gc4TTL only visits the keys that may have expired rows
+    // instead of all the keys. a put older than the oldest row of its key indexes the key again, a full scan
+    // still runs every gc_expiry_index_full_scan_round rounds as a safety net. only for the single ts segments
+    void SetExpiryIndex(bool enable);
+
+    // create the new key entries as ColdKeyEntry, which Compact freezes the old rows of. the entries
+    // created before stay hot, so the tables not compacted keep the smaller KeyEntry. only for the
+    // single ts segments
+    void SetCompact(bool enable);
+
+    // the allocator is owned by the table, the blocks may be shared by segments of other indexes
+    void SetDataBlockAllocator(DataBlockAllocator* allocator, uint8_t shard) {
+        allocator_ = allocator;
+        allocator_shard_ = shard;
+    }
+
  private:
     void FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,  // NOLINT
                   uint64_t& gc_record_cnt,         // NOLINT
                   uint64_t& gc_record_byte_size);  // NOLINT
     void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node);
+    // drop the cold blocks out of ttl under the lock of the entry. a block is dropped only if all its rows expire,
+    // and_mode is true if both the time and the count have to expire
+    void SplitColdBlocks(KeyEntry* entry, uint64_t expire_time, uint64_t keep_cnt, bool and_mode,
+                         std::vector<std::shared_ptr<const ColdBlock>>* dropped);
+    void FreeColdBlocks(const std::vector<std::shared_ptr<const ColdBlock>>& dropped,
+                        uint64_t& gc_idx_cnt,            // NOLINT
+                        uint64_t& gc_record_cnt,         // NOLINT
+                        uint64_t& gc_record_byte_size);  // NOLINT
+
+    // insert under the lock of the key entry, return false if the entry has been removed.
+    // last_time is set to the oldest time before the put if given, UINT64_MAX if the entry was empty
+    bool PutToEntry(KeyEntry* entry, uint64_t time, DataBlock* row, uint64_t* last_time = nullptr);
+    // insert the ts_vec from start, return the position of the first ts not inserted
+    // because the entries have been removed
+    uint32_t PutToEntries(KeyEntry** entry_arr, const std::vector<std::pair<uint32_t, uint64_t>>& ts_vec,
+                          uint32_t start, DataBlock* row);
+    // create the key entry under mu_ if the key does not exist
+    void* GetOrCreateEntry(const Slice& key);
+    // mark the key entries removed, must be called under mu_
+    void SetRemoved(void* entry);
+    // remove the key if its single entry is still empty under mu_
+    ::openmldb::base::Node<Slice, void*>* RemoveIfEmpty(const Slice& key, KeyEntry* entry);
+
+    // gc the rows of one entry before time, return false if the key has been removed
+    bool GcEntry4TTL(const Slice& key, KeyEntry* entry, const uint64_t time,
+                     uint64_t& gc_idx_cnt,            // NOLINT
+                     uint64_t& gc_record_cnt,         // NOLINT
+                     uint64_t& gc_record_byte_size);  // NOLINT
+    // index the key in the bucket of time, moving it out of the bucket of last_time if it is there.
+    // last_time is UINT64_MAX if the key has no bucket yet
+    void AddExpiryKey(const Slice& key, uint64_t time, uint64_t last_time);
+    void AddExpiryKey(KeyEntry* entry, const Slice& key);
+    // move the key to an older bucket if the row put is older than the oldest row before
+    void UpdateExpiryKey(const Slice& key, uint64_t time, uint64_t last_time);
 
     void GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt,  // NOLINT
                          uint64_t& gc_record_cnt,                 // NOLINT
                          uint64_t& gc_record_byte_size);          // NOLINT
+    void GcNodeFreeList(uint64_t version, uint64_t& gc_idx_cnt,  // NOLINT
+                        uint64_t& gc_record_cnt,                 // NOLINT
+                        uint64_t& gc_record_byte_size);          // NOLINT
+    // free the rows moved to cold blocks and the replaced cold block lists, they are counted when compacted
+    void GcCompactFreeList(uint64_t version);
+    // replace the cold blocks of the entry under its lock, the old list is freed after the gc rounds
+    void SetColdBlocks(KeyEntry* entry, const ColdBlockList* list);
     void FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64_t& gc_idx_cnt,  // NOLINT
                    uint64_t& gc_record_cnt,         // NOLINT
                    uint64_t& gc_record_byte_size);  // NOLINT
 
  private:
     KeyEntries* entries_;
-    // only Put need mutex
+    // guard the creation and the removal of key entries. the puts of an existing key
+    // only take the lock of its KeyEntry
     std::mutex mu_;
     std::mutex gc_mu_;
     std::atomic<uint64_t> idx_cnt_;
@@ -263,11 +440,30 @@ class Segment {
     std::atomic<uint64_t> pk_cnt_;
     uint8_t key_entry_max_height_;
     KeyEntryNodeList* entry_free_list_;
+    // the rows split off the key entries while they may be read, freed with entry_free_list_
+    DataNodeList* node_free_list_;
+    // the rows moved to cold blocks by Compact and the replaced cold block lists
+    DataNodeList* compact_node_free_list_;
+    ColdBlockFreeList* cold_free_list_;
     uint32_t ts_cnt_;
     std::atomic<uint64_t> gc_version_;
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    DataBlockAllocator* allocator_;
+    uint8_t allocator_shard_;
+    std::atomic<uint64_t> keep_cnt_;
+    std::atomic<bool> expiry_index_;
+    std::atomic<bool> compact_;
+    // guard expiry_buckets_, expiry_index_ready_ and ttl_gc_round_
+    std::mutex expiry_mu_;
+    // bucket start time -> the keys whose oldest row falls in the bucket. a key is kept in one bucket only,
+    // except for the rare puts racing with the gc that consumes or rebuilds the buckets
+    std::map<uint64_t, std::unordered_set<std::string>> expiry_buckets_;
+    // the memory of the keys in expiry_buckets_, counted in idx_byte_size_ too
+    uint64_t expiry_byte_size_;
+    bool expiry_index_ready_;
+    uint32_t ttl_gc_round_;
 };
 
 }  // namespace storage
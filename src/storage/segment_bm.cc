@@ -0,0 +1,70 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/slice.h"
+#include "benchmark/benchmark.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::base::Slice;
+
+// the puts of existing keys from state.range(0) threads, which only take the lock of their KeyEntry
+static void BM_SegmentMultiThreadPut(benchmark::State& state) {  // NOLINT
+    const uint32_t key_cnt = 1000;
+    const uint32_t put_cnt = 400000;
+    const uint32_t thread_cnt = state.range(0);
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < key_cnt; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        Segment* segment = new Segment(8);
+        for (const auto& key : keys) {
+            segment->Put(Slice(key), 0, "value", 5);
+        }
+        state.ResumeTiming();
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < thread_cnt; t++) {
+            threads.emplace_back([segment, &keys, t, thread_cnt, put_cnt, key_cnt] {
+                for (uint32_t i = t; i < put_cnt; i += thread_cnt) {
+                    segment->Put(Slice(keys[i % key_cnt]), i + 1, "value", 5);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        state.PauseTiming();
+        segment->Release();
+        delete segment;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * put_cnt);
+}
+
+BENCHMARK(BM_SegmentMultiThreadPut)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace storage
+}  // namespace openmldb
+
+BENCHMARK_MAIN();
@@ -16,8 +16,14 @@
 
 #include "storage/segment.h"
 
+#include <gflags/gflags.h>
+
+#include <atomic>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "base/glog_wrapper.h"
 #include "base/slice.h"
@@ -26,6 +32,9 @@
 
 using ::openmldb::base::Slice;
 
+DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_uint32(gc_expiry_index_full_scan_round);
+
 namespace openmldb {
 namespace storage {
 
@@ -38,6 +47,7 @@ class SegmentTest : public ::testing::Test {
 TEST_F(SegmentTest, Size) {
     ASSERT_EQ(16, (int64_t)sizeof(DataBlock));
     ASSERT_EQ(40, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(48, (int64_t)sizeof(ColdKeyEntry));
 }
 
 TEST_F(SegmentTest, DataBlock) {
@@ -214,6 +224,49 @@ TEST_F(SegmentTest, TestGc4Head) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SegmentTest, TrimOnPut) {
+    Segment segment(1);
+    segment.SetKeepCnt(3);
+    Slice pk("PK");
+    for (uint64_t ts = 1; ts <= 20; ts++) {
+        std::string value = "test" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(pk, count));
+        ASSERT_EQ(std::min(ts, (uint64_t)3), count);
+    }
+    ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+    // the trimmed rows are freed after gc_deleted_pk_version_delta gc rounds
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_record_cnt);
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(pk, ticket);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(20, (int64_t)it->GetKey());
+    // the entry in use is trimmed too, the split nodes are still readable
+    segment.Put(pk, 21, "test21", 6);
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(3, (int64_t)count);
+    for (uint64_t ts = 20; ts > 18; ts--) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(ts, it->GetKey());
+        it->Next();
+    }
+    delete it;
+    ticket.Pop();
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+    }
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(18, (int64_t)gc_record_cnt);
+    ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+}
+
 TEST_F(SegmentTest, TestGc4TTL) {
     Segment segment;
     segment.Put("PK", 9768, "test1", 5);
@@ -235,6 +288,79 @@ TEST_F(SegmentTest, TestGc4TTL) {
     ASSERT_EQ(2 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, Gc4TTLWithExpiryIndex) {
+    Segment segment;
+    segment.SetExpiryIndex(true);
+    const uint64_t minute = 60 * 1000;
+    for (uint64_t i = 0; i < 10; i++) {
+        std::string pk = "PK" + std::to_string(i);
+        segment.Put(pk, i * minute + 1, "test1", 5);
+        segment.Put(pk, i * minute + 2, "test2", 5);
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the first round scans all the keys and builds the index
+    segment.Gc4TTL(0, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+    segment.Gc4TTL(3 * minute + 1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(7, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(7, (int64_t)gc_record_cnt);
+    ASSERT_EQ(7 * GetRecordSize(5), (int64_t)gc_record_byte_size);
+    ASSERT_EQ(13, (int64_t)segment.GetIdxCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(-1, segment.GetCount("PK2", count));
+    ASSERT_EQ(0, segment.GetCount("PK3", count));
+    ASSERT_EQ(1, (int64_t)count);
+    // a row put out of order indexes its key again
+    segment.Put("PK9", 1, "test0", 5);
+    segment.Gc4TTL(3 * minute + 2, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(9, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(-1, segment.GetCount("PK3", count));
+    ASSERT_EQ(0, segment.GetCount("PK9", count));
+    ASSERT_EQ(2, (int64_t)count);
+    // the keys in the index are counted in the index memory
+    uint64_t idx_byte_size = segment.GetIdxByteSize();
+    segment.SetExpiryIndex(false);
+    uint64_t no_index_byte_size = segment.GetIdxByteSize();
+    ASSERT_GT(idx_byte_size, no_index_byte_size);
+    // rebuilt by the full scan
+    segment.SetExpiryIndex(true);
+    segment.Gc4TTL(0, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_GT(segment.GetIdxByteSize(), no_index_byte_size);
+    segment.Gc4TTL(10 * minute, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(21, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
+}
+
+TEST_F(SegmentTest, ExpiryIndexKeepsOneCopyOfKey) {
+    Segment segment;
+    segment.SetExpiryIndex(true);
+    const uint64_t minute = 60 * 1000;
+    for (uint64_t i = 0; i < 10; i++) {
+        segment.Put("PK" + std::to_string(i), 100 * minute, "test1", 5);
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(0, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    // every row put out of order moves its key to an older bucket instead of adding a copy
+    for (uint64_t i = 0; i < 10; i++) {
+        std::string pk = "PK" + std::to_string(i);
+        for (uint64_t j = 1; j <= 5; j++) {
+            segment.Put(pk, (100 - j) * minute, "test1", 5);
+        }
+    }
+    uint64_t idx_byte_size = segment.GetIdxByteSize();
+    segment.SetExpiryIndex(false);
+    ASSERT_EQ(10 * (sizeof(std::string) + 3), idx_byte_size - segment.GetIdxByteSize());
+    segment.SetExpiryIndex(true);
+    segment.Gc4TTL(0, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    segment.Gc4TTL(96 * minute, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(20, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(40, (int64_t)segment.GetIdxCnt());
+}
+
 TEST_F(SegmentTest, TestGc4TTLAndHead) {
     Segment segment;
     segment.Put("PK1", 9766, "test1", 5);
@@ -370,6 +496,286 @@ TEST_F(SegmentTest, GetTsIdx) {
     ASSERT_EQ(2, (int64_t)real_idx);
 }
 
+TEST_F(SegmentTest, MultiThreadPut) {
+    const uint32_t key_cnt = 10;
+    const uint32_t thread_cnt = 4;
+    const uint32_t put_cnt = 2000;
+    Segment segment(8);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_cnt; t++) {
+        threads.emplace_back([&segment, t] {
+            // the threads put the same keys with distinct times
+            for (uint32_t i = t; i < put_cnt; i += thread_cnt) {
+                std::string key = "key" + std::to_string(i % key_cnt);
+                std::string value = "value" + std::to_string(i + 1);
+                segment.Put(Slice(key), i + 1, value.data(), value.size());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(put_cnt, segment.GetIdxCnt());
+    ASSERT_EQ(key_cnt, segment.GetPkCnt());
+    for (uint32_t k = 0; k < key_cnt; k++) {
+        std::string key = "key" + std::to_string(k);
+        uint64_t cnt = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), cnt));
+        ASSERT_EQ(put_cnt / key_cnt, cnt);
+        Ticket ticket;
+        std::unique_ptr<MemTableIterator> it(segment.NewIterator(Slice(key), ticket));
+        it->SeekToFirst();
+        // every row of the key in time desc
+        for (uint64_t ts = put_cnt - key_cnt + k + 1; ts > k; ts -= key_cnt) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(ts, it->GetKey());
+            ASSERT_EQ("value" + std::to_string(ts), it->GetValue().ToString());
+            it->Next();
+        }
+        ASSERT_FALSE(it->Valid());
+    }
+}
+
+TEST_F(SegmentTest, MultiThreadPutWithGc) {
+    Segment segment(8);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 4; t++) {
+        threads.emplace_back([&segment, t] {
+            for (uint32_t i = 0; i < 100000; i++) {
+                std::string key = "key" + std::to_string((i + t) % 100);
+                segment.Put(Slice(key), i + 1, "value", 5);
+            }
+        });
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    std::thread gc_thread([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            // the keys removed by gc are created again by the puts
+            segment.Gc4TTL(50000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            segment.IncrGcVersion();
+        }
+    });
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    done.store(true, std::memory_order_relaxed);
+    gc_thread.join();
+    ASSERT_EQ(400000u, segment.GetIdxCnt() + gc_idx_cnt);
+    uint64_t total = 0;
+    KeyEntries::Iterator* it = segment.GetKeyEntries()->NewIterator();
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        total += ((KeyEntry*)it->GetValue())->GetCount();  // NOLINT
+    }
+    delete it;
+    ASSERT_EQ(segment.GetIdxCnt(), total);
+    // free the keys removed by gc, they hold no rows
+    for (uint32_t i = 0; i <= FLAGS_gc_deleted_pk_version_delta; i++) {
+        segment.IncrGcVersion();
+    }
+    uint64_t freed_idx_cnt = 0;
+    segment.GcFreeList(freed_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0u, freed_idx_cnt);
+}
+
+TEST_F(SegmentTest, CompactAndScan) {
+    for (bool compress : {false, true}) {
+        Segment segment;
+        segment.SetCompact(true);
+        Slice pk("PK");
+        for (uint64_t ts = 1; ts <= 100; ts++) {
+            std::string value = "value" + std::to_string(ts) + std::string(100, 'a');
+            segment.Put(pk, ts, value.data(), value.size());
+        }
+        uint64_t freed_byte_size = 0;
+        uint64_t block_byte_size = 0;
+        // 90 rows after the hot rows, the 80 oldest of them are frozen
+        segment.Compact(10, 16, compress, freed_byte_size, block_byte_size);
+        void* entry = NULL;
+        ASSERT_EQ(0, segment.GetKeyEntries()->Get(pk, entry));
+        ASSERT_EQ(20u, ((KeyEntry*)entry)->entries.GetSize());  // NOLINT
+        auto cold = ((KeyEntry*)entry)->GetColdBlocks();         // NOLINT
+        ASSERT_TRUE(cold != nullptr);
+        ASSERT_EQ(5u, cold->blocks.size());
+        ASSERT_EQ(80u, cold->count);
+        ASSERT_EQ(compress, cold->blocks[0]->IsCompressed());
+        uint64_t frozen_byte_size = 0;
+        for (uint64_t ts = 1; ts <= 80; ts++) {
+            frozen_byte_size += GetRecordSize(5 + std::to_string(ts).size() + 100);
+        }
+        ASSERT_EQ(frozen_byte_size, freed_byte_size);
+        if (compress) {
+            ASSERT_LT(block_byte_size, freed_byte_size);
+        }
+        ASSERT_EQ(100u, segment.GetIdxCnt());
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(pk, count));
+        ASSERT_EQ(100u, count);
+
+        {
+            Ticket ticket;
+            MemTableIterator* it = segment.NewIterator(pk, ticket);
+            it->SeekToFirst();
+            for (uint64_t ts = 100; ts >= 1; ts--) {
+                ASSERT_TRUE(it->Valid());
+                ASSERT_EQ(ts, it->GetKey());
+                std::string value = "value" + std::to_string(ts) + std::string(100, 'a');
+                ASSERT_EQ(value, it->GetValue().ToString());
+                it->Next();
+            }
+            ASSERT_FALSE(it->Valid());
+            it->Seek(85);
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(85u, it->GetKey());
+            it->Seek(50);
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(50u, it->GetKey());
+            it->Next();
+            ASSERT_EQ(49u, it->GetKey());
+            it->SeekToLast();
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(1u, it->GetKey());
+            delete it;
+
+            // the late row is merged with the cold rows
+            segment.Put(pk, 5, "late", 4);
+            it = segment.NewIterator(pk, ticket);
+            it->Seek(5);
+            ASSERT_EQ(5u, it->GetKey());
+            ASSERT_EQ("late", it->GetValue().ToString());
+            it->Next();
+            ASSERT_EQ(5u, it->GetKey());
+            it->Next();
+            ASSERT_EQ(4u, it->GetKey());
+            delete it;
+        }
+        ASSERT_EQ(101u, segment.Release());
+    }
+}
+
+TEST_F(SegmentTest, CompactAndGc) {
+    Segment segment;
+    segment.SetCompact(true);
+    Slice pk("PK");
+    for (uint64_t ts = 1; ts <= 100; ts++) {
+        segment.Put(pk, ts, "value", 5);
+    }
+    uint64_t freed_byte_size = 0;
+    uint64_t block_byte_size = 0;
+    segment.Compact(10, 10, false, freed_byte_size, block_byte_size);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the block of 31 ~ 40 is not dropped until all its rows expire
+    segment.Gc4TTL(35, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(30u, gc_idx_cnt);
+    ASSERT_EQ(30u, gc_record_cnt);
+    ASSERT_EQ(70u, segment.GetIdxCnt());
+    {
+        // the entry referred by the ticket is skipped by gc
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToLast();
+        ASSERT_EQ(31u, it->GetKey());
+        delete it;
+    }
+
+    segment.Gc4Head(25, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(70u, gc_idx_cnt);
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(30u, count);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToLast();
+        ASSERT_EQ(71u, it->GetKey());
+        delete it;
+    }
+
+    segment.Gc4TTL(200, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(100u, gc_idx_cnt);
+    ASSERT_EQ(100u, gc_record_cnt);
+    ASSERT_EQ(0u, segment.GetIdxCnt());
+    ASSERT_EQ(-1, segment.GetCount(pk, count));
+}
+
+TEST_F(SegmentTest, CompactSkipHotEntry) {
+    Segment segment;
+    Slice pk1("PK1");
+    Slice pk2("PK2");
+    for (uint64_t ts = 1; ts <= 100; ts++) {
+        segment.Put(pk1, ts, "value", 5);
+    }
+    // only the entries created after compaction is on are compacted
+    segment.SetCompact(true);
+    for (uint64_t ts = 1; ts <= 100; ts++) {
+        segment.Put(pk1, ts + 100, "value", 5);
+        segment.Put(pk2, ts, "value", 5);
+    }
+    uint64_t freed_byte_size = 0;
+    uint64_t block_byte_size = 0;
+    segment.Compact(10, 10, false, freed_byte_size, block_byte_size);
+    void* entry = NULL;
+    ASSERT_EQ(0, segment.GetKeyEntries()->Get(pk1, entry));
+    ASSERT_FALSE(((KeyEntry*)entry)->IsCompactable());          // NOLINT
+    ASSERT_TRUE(((KeyEntry*)entry)->GetColdBlocks() == nullptr);  // NOLINT
+    ASSERT_EQ(200u, ((KeyEntry*)entry)->entries.GetSize());       // NOLINT
+    ASSERT_EQ(0, segment.GetKeyEntries()->Get(pk2, entry));
+    ASSERT_TRUE(((KeyEntry*)entry)->IsCompactable());  // NOLINT
+    ASSERT_EQ(10u, ((KeyEntry*)entry)->entries.GetSize());  // NOLINT
+    ASSERT_EQ(90u, ((KeyEntry*)entry)->GetColdBlocks()->count);  // NOLINT
+    ASSERT_EQ(300u, segment.Release());
+}
+
+TEST_F(SegmentTest, CompactDeferFree) {
+    Segment segment;
+    segment.SetCompact(true);
+    Slice pk("PK");
+    for (uint64_t ts = 1; ts <= 100; ts++) {
+        segment.Put(pk, ts, "value", 5);
+    }
+    void* entry = NULL;
+    ASSERT_EQ(0, segment.GetKeyEntries()->Get(pk, entry));
+    ASSERT_TRUE(((KeyEntry*)entry)->GetColdBlocks() == nullptr);  // NOLINT
+    // a reader without ticket, it is in the rows moved to the cold blocks
+    KeyEntryIterator* it = ((KeyEntry*)entry)->NewIterator();    // NOLINT
+    it->Seek(50);
+    ASSERT_TRUE(it->Valid());
+    uint64_t freed_byte_size = 0;
+    uint64_t block_byte_size = 0;
+    segment.Compact(10, 10, false, freed_byte_size, block_byte_size);
+    const ColdBlockList* cold = ((KeyEntry*)entry)->GetColdBlocks();  // NOLINT
+    ASSERT_TRUE(cold != nullptr);
+    ASSERT_EQ(90u, cold->count);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(40, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(40u, gc_record_cnt);
+    ASSERT_NE(cold, ((KeyEntry*)entry)->GetColdBlocks());  // NOLINT
+    // the split rows and the replaced list are still readable
+    for (uint64_t ts = 50; ts >= 1; ts--) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(ts, it->GetKey());
+        ASSERT_EQ("value", it->GetValue().ToString());
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+    ASSERT_EQ(9u, cold->blocks.size());
+    delete it;
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+    }
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    // the compacted rows are not counted again
+    ASSERT_EQ(40u, gc_record_cnt);
+    ASSERT_EQ(60u, segment.GetIdxCnt());
+    ASSERT_EQ(60u, segment.Release());
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
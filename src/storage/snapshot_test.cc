@@ -24,6 +24,7 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
@@ -42,6 +43,8 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(load_table_thread_num);
+DECLARE_uint32(load_table_batch);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -1630,6 +1633,64 @@ TEST_F(SnapshotTest, Recover_large_snapshot) {
     delete it;
 }
 
+TEST_F(SnapshotTest, Recover_snapshot_multi_thread) {
+    std::string binlog_dir = FLAGS_db_root_path + "/102_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    uint32_t key_num = 100;
+    uint32_t record_num = 100000;
+    for (uint32_t i = 0; i < record_num; i++) {
+        offset++;
+        std::string key = "key" + std::to_string(i % key_num);
+        auto entry = ::openmldb::test::PackKVEntry(offset, key, "value" + std::to_string(i), i + 1, 1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ::openmldb::base::Slice slice(buffer);
+        ::openmldb::log::Status status = wh->Write(slice);
+        ASSERT_TRUE(status.ok());
+    }
+    wh->Sync();
+    MemTableSnapshot snapshot(102, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+
+    uint32_t old_thread_num = FLAGS_load_table_thread_num;
+    uint32_t old_batch = FLAGS_load_table_batch;
+    FLAGS_load_table_thread_num = 4;
+    FLAGS_load_table_batch = 100;
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(table, snapshot_offset));
+    FLAGS_load_table_thread_num = old_thread_num;
+    FLAGS_load_table_batch = old_batch;
+    ASSERT_EQ(record_num, snapshot_offset);
+    ASSERT_EQ(record_num, table->GetRecordCnt());
+    for (uint32_t k = 0; k < key_num; k++) {
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(table->NewIterator("key" + std::to_string(k), ticket));
+        it->SeekToFirst();
+        uint32_t cnt = 0;
+        uint64_t last_ts = UINT64_MAX;
+        while (it->Valid()) {
+            ASSERT_LT(it->GetKey(), last_ts);
+            ASSERT_EQ(k, (it->GetKey() - 1) % key_num);
+            last_ts = it->GetKey();
+            cnt++;
+            it->Next();
+        }
+        ASSERT_EQ(record_num / key_num, cnt);
+    }
+    RemoveData(FLAGS_db_root_path);
+}
+
 TEST_F(SnapshotTest, Recover_large_snapshot_and_binlog) {
     std::string snapshot_dir = FLAGS_db_root_path + "/101_0/snapshot/";
     std::string binlog_dir = FLAGS_db_root_path + "/101_0/binlog/";
@@ -45,7 +45,8 @@ const uint64_t& MemTableWindowIterator::GetKey() const {
 }
 
 const ::hybridse::codec::Row& MemTableWindowIterator::GetValue() {
-    row_.Reset(reinterpret_cast<const int8_t*>(it_->GetValue()->data), it_->GetValue()->size);
+    Slice value = it_->GetValue();
+    row_.Reset(reinterpret_cast<const int8_t*>(value.data()), value.size());
     return row_;
 }
 
@@ -128,14 +129,13 @@ void MemTableKeyIterator::Next() {
 }
 
 ::hybridse::vm::RowIterator* MemTableKeyIterator::GetRawValue() {
-    TimeEntries::Iterator* it = nullptr;
+    KeyEntryIterator* it = nullptr;
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
+        it = entry->NewIterator();
         ticket_.Push(entry);
     } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
+        it = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
         ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
     }
     it->SeekToFirst();
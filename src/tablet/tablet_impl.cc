@@ -49,7 +49,9 @@
 #include "base/strings.h"
 #include "brpc/controller.h"
 #include "butil/iobuf.h"
+#include "bvar/bvar.h"
 #include "codec/codec.h"
+#include "codec/column_block_codec.h"
 #include "codec/row_codec.h"
 #include "codec/sql_rpc_row_codec.h"
 #include "common/timer.h"
@@ -116,11 +118,20 @@ DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_string(jit_object_cache_dir);
+DECLARE_uint64(jit_object_cache_max_size_mb);
 
 namespace openmldb {
 namespace tablet {
 
 static const std::string SERVER_CONCURRENCY_KEY = "server";  // NOLINT
+
+// the stats of the jit object cache, all zero before the engine opens the cache
+static uint64_t GetJitObjectCacheStat(void* arg) {
+    uint64_t stats[3] = {0, 0, 0};
+    ::hybridse::vm::Engine::GetJitObjectCacheStats(FLAGS_jit_object_cache_dir, &stats[0], &stats[1], &stats[2]);
+    return stats[reinterpret_cast<uintptr_t>(arg)];
+}
 static const uint32_t SEED = 0xe17a1465;
 
 static constexpr const char DEPLOY_STATS[] = "deploy_stats";
@@ -207,6 +218,17 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     } else {
         options.SetClusterOptimized(false);
     }
+    options.jit_options().SetObjectCacheDir(FLAGS_jit_object_cache_dir);
+    options.jit_options().SetObjectCacheMaxSize(FLAGS_jit_object_cache_max_size_mb * 1024 * 1024);
+    if (!FLAGS_jit_object_cache_dir.empty()) {
+        // the cache is shared by the process, so are the stats
+        static bvar::PassiveStatus<uint64_t> jit_cache_hit_cnt("openmldb_jit_object_cache_hit_count",
+                                                               GetJitObjectCacheStat, reinterpret_cast<void*>(0));
+        static bvar::PassiveStatus<uint64_t> jit_cache_miss_cnt("openmldb_jit_object_cache_miss_count",
+                                                                GetJitObjectCacheStat, reinterpret_cast<void*>(1));
+        static bvar::PassiveStatus<uint64_t> jit_cache_size("openmldb_jit_object_cache_size",
+                                                            GetJitObjectCacheStat, reinterpret_cast<void*>(2));
+    }
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
@@ -815,6 +837,121 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 }
 
+void TabletImpl::PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                          ::openmldb::api::PutBatchResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    response->set_put_cnt(0);
+    if (follower_.load(std::memory_order_relaxed)) {
+        response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
+        response->set_msg("is follower cluster");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (!table->IsLeader()) {
+        response->set_code(::openmldb::base::ReturnCode::kTableIsFollower);
+        response->set_msg("table is follower");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    uint32_t idx_cnt = table->GetIdxCnt();
+    for (const auto& row : request->rows()) {
+        if (row.dimensions_size() <= 0 || CheckDimessionPut(row.dimensions(), idx_cnt) != 0) {
+            response->set_code(::openmldb::base::ReturnCode::kInvalidDimensionParameter);
+            response->set_msg("invalid dimension parameter");
+            return;
+        }
+    }
+    // rows which have been put into table will be written to binlog even if a later row fails,
+    // so that the leader and the followers keep the same data
+    int put_cnt = 0;
+    for (const auto& row : request->rows()) {
+        if (!table->Put(row.time(), row.value(), row.dimensions())) {
+            break;
+        }
+        put_cnt++;
+    }
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    if (put_cnt < request->rows_size()) {
+        PDLOG(WARNING, "put batch failed. success/total %d/%d tid %u, pid %u", put_cnt, request->rows_size(), tid,
+              pid);
+        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+        response->set_msg("put failed");
+    }
+    std::shared_ptr<LogReplicator> replicator;
+    do {
+        if (put_cnt == 0) {
+            break;
+        }
+        replicator = GetReplicator(tid, pid);
+        if (!replicator) {
+            PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", tid, pid);
+            break;
+        }
+        uint64_t term = replicator->GetLeaderTerm();
+        std::vector<::openmldb::api::LogEntry> entries(put_cnt);
+        for (int idx = 0; idx < put_cnt; idx++) {
+            const auto& row = request->rows(idx);
+            auto& entry = entries[idx];
+            entry.set_ts(row.time());
+            entry.set_value(row.value());
+            entry.set_term(term);
+            entry.mutable_dimensions()->CopyFrom(row.dimensions());
+        }
+        // all entries get consecutive log index within the replicator lock,
+        // so the aggregators can be updated in one pass with strictly increasing binlog_offset.
+        // if the binlog fails in the middle, the closure still runs for the entries written before it
+        bool aggr_ok = true;
+        auto update_aggr = [this, &request, &entries, &aggr_ok, tid, pid]() {
+            for (size_t idx = 0; idx < entries.size() && aggr_ok; idx++) {
+                const auto& row = request->rows(idx);
+                aggr_ok = UpdateAggrs(tid, pid, row.value(), row.dimensions(), entries[idx].log_index());
+            }
+        };
+        UpdateAggrClosure closure(update_aggr);
+        if (!replicator->AppendEntries(entries, &closure)) {
+            PDLOG(WARNING, "fail to append binlog. tid %u pid %u", tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kError);
+            response->set_msg("append binlog failed");
+            break;
+        }
+        if (!aggr_ok) {
+            response->set_code(::openmldb::base::ReturnCode::kError);
+            response->set_msg("update aggr failed");
+        }
+    } while (false);
+    response->set_put_cnt(put_cnt);
+
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_put_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[put batch]. row cnt %d time %lu. tid %u, pid %u", request->rows_size(),
+              end_time - start_time, tid, pid);
+    }
+    if (replicator) {
+        if (FLAGS_binlog_notify_on_put) {
+            replicator->Notify();
+        }
+    }
+    // update global var in standalone mode
+    if (!IsClusterMode() && table->GetDB() == openmldb::nameserver::INFORMATION_SCHEMA_DB &&
+        table->GetName() == openmldb::nameserver::GLOBAL_VARIABLES) {
+        UpdateGlobalVarTable();
+    }
+}
+
 int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::string& msg) {
     msg.clear();
     if (table_meta->name().empty()) {
@@ -928,6 +1065,11 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
         }
         enable_project = true;
     }
+    // the projected rows are returned in one column block if required
+    std::unique_ptr<::openmldb::codec::ColumnBlockEncoder> block_encoder;
+    if (enable_project && request->format() == ::openmldb::api::kColumnFormat) {
+        block_encoder.reset(new ::openmldb::codec::ColumnBlockEncoder(row_project.GetOutputSchema()));
+    }
     bool remove_duplicated_record = request->enable_remove_duplicated_record();
     uint64_t last_time = 0;
     uint32_t total_block_size = 0;
@@ -963,7 +1105,16 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
                 PDLOG(WARNING, "fail to make a projection");
                 return -4;
             }
-            io_buf->append(reinterpret_cast<void*>(ptr), size);
+            if (block_encoder) {
+                ok = block_encoder->Append(ptr, size);
+            } else {
+                io_buf->append(reinterpret_cast<void*>(ptr), size);
+            }
+            delete[] ptr;
+            if (!ok) {
+                PDLOG(WARNING, "fail to append the projected row to column block");
+                return -4;
+            }
             total_block_size += size;
         } else {
             openmldb::base::Slice data = combine_it->GetValue();
@@ -977,6 +1128,11 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
         }
         combine_it->Next();
     }
+    if (block_encoder) {
+        std::string block;
+        block_encoder->Encode(&block);
+        io_buf->append(block);
+    }
     *count = record_count;
     return 0;
 }
@@ -1266,6 +1422,17 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
         auto* cntl = dynamic_cast<brpc::Controller*>(controller);
         butil::IOBuf& buf = cntl->response_attachment();
         code = ScanIndex(request, *table_meta, vers_schema, &combine_it, &buf, &count, &is_finish);
+        if (request->format() == ::openmldb::api::kColumnFormat && request->projection_size() > 0) {
+            response->set_format(::openmldb::api::kColumnFormat);
+        }
+        if (code == 0 && request->compress_type() == ::openmldb::type::kSnappy && !buf.empty()) {
+            std::string raw = buf.to_string();
+            std::string compressed;
+            ::snappy::Compress(raw.data(), raw.size(), &compressed);
+            buf.clear();
+            buf.append(compressed);
+            response->set_compress_type(::openmldb::type::kSnappy);
+        }
         response->set_buf_size(buf.size());
         DLOG(INFO) << " scan " << request->pk() << " with buf size " << buf.size();
     }
@@ -1660,7 +1827,7 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
         auto& request_buf = static_cast<brpc::Controller*>(ctrl)->request_attachment();
         if (request->parameter_row_size() > 0 &&
             !codec::DecodeRpcRow(request_buf, 0, request->parameter_row_size(), request->parameter_row_slices(),
-                                 &parameter_row)) {
+                                 &parameter_row, true)) {
             response->set_code(::openmldb::base::kSQLRunError);
             response->set_msg("fail to decode parameter row");
             return;
@@ -1685,7 +1852,7 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
                 return;
             }
             byte_size += output_row.size();
-            buf->append(reinterpret_cast<void*>(output_row.buf()), output_row.size());
+            codec::AppendRowSlice(&output_row, 0, buf);
             count += 1;
         }
         response->set_schema(session.GetEncodedSchema());
@@ -2200,7 +2367,8 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
     uint64_t last_log_offset = replicator->GetOffset();
-    if (request->pre_log_index() == 0 && request->entries_size() == 0) {
+    bool raw = request->raw_entry_sizes_size() > 0;
+    if (request->pre_log_index() == 0 && request->entries_size() == 0 && !raw) {
         response->set_log_offset(last_log_offset);
         if (!FLAGS_zk_cluster.empty() && request->term() > term) {
             replicator->SetLeaderTerm(request->term());
@@ -2211,14 +2379,31 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
-    for (int32_t i = 0; i < request->entries_size(); i++) {
-        const auto& entry = request->entries(i);
+    // the raw records are written to binlog as they are, they are parsed only to be put into the table
+    int32_t entry_cnt = raw ? request->raw_entry_sizes_size() : request->entries_size();
+    butil::IOBuf& raw_buf = static_cast<brpc::Controller*>(controller)->request_attachment();
+    ::openmldb::api::LogEntry raw_entry;
+    std::string raw_record;
+    for (int32_t i = 0; i < entry_cnt; i++) {
+        if (raw) {
+            uint32_t size = request->raw_entry_sizes(i);
+            raw_record.clear();
+            if (raw_buf.cutn(&raw_record, size) != size || !raw_entry.ParseFromString(raw_record)) {
+                PDLOG(WARNING, "bad raw log record. tid %u pid %u", tid, pid);
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("bad raw log record");
+                return;
+            }
+        }
+        const auto& entry = raw ? raw_entry : request->entries(i);
         if (entry.log_index() <= last_log_offset) {
-            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", request->entries(i).log_index(),
+            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", entry.log_index(),
                     last_log_offset, tid, pid);
             continue;
         }
-        if (!replicator->ApplyEntry(entry)) {
+        bool ok = raw ? replicator->ApplyRawEntry(entry.log_index(), ::openmldb::base::Slice(raw_record))
+                      : replicator->ApplyEntry(entry);
+        if (!ok) {
             PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
             response->set_msg("fail to append entries to replicator");
@@ -2397,6 +2582,10 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
                     }
                     status->set_idx_cnt(record_idx_cnt);
                 }
+            } else if (DiskTable* disk_table = dynamic_cast<DiskTable*>(table.get())) {
+                ::openmldb::api::DiskTableStatus* disk_status = status->mutable_disk_status();
+                disk_table->GetMemoryUsage(disk_status);
+                disk_table->GetStatistics(disk_status);
             }
         }
     }
@@ -4425,16 +4614,20 @@ bool TabletImpl::RefreshAggrCatalog() {
 }
 
 int TabletImpl::CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt) {
-    for (int32_t i = 0; i < request->dimensions_size(); i++) {
-        if (idx_cnt <= request->dimensions(i).idx()) {
+    return CheckDimessionPut(request->dimensions(), idx_cnt);
+}
+
+int TabletImpl::CheckDimessionPut(const ::openmldb::storage::Dimensions& dimensions, uint32_t idx_cnt) {
+    for (const auto& dimension : dimensions) {
+        if (idx_cnt <= dimension.idx()) {
             PDLOG(WARNING,
                   "invalid put request dimensions, request idx %u is greater "
                   "than table idx cnt %u",
-                  request->dimensions(i).idx(), idx_cnt);
+                  dimension.idx(), idx_cnt);
             return -1;
         }
-        if (request->dimensions(i).key().length() <= 0) {
-            PDLOG(WARNING, "invalid put request dimension key is empty with idx %u", request->dimensions(i).idx());
+        if (dimension.key().length() <= 0) {
+            PDLOG(WARNING, "invalid put request dimension key is empty with idx %u", dimension.idx());
             return 1;
         }
     }
@@ -5422,7 +5615,8 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     ::hybridse::codec::Row row;
     auto& request_buf = dynamic_cast<brpc::Controller*>(ctrl)->request_attachment();
     size_t input_slices = request.row_slices();
-    if (!codec::DecodeRpcRow(request_buf, 0, request.row_size(), input_slices, &row)) {
+    // the request row references the attachment, which is alive until the response is sent
+    if (!codec::DecodeRpcRow(request_buf, 0, request.row_size(), input_slices, &row, true)) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to decode input row");
         return;
@@ -5444,7 +5638,7 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
         return;
     }
     size_t buf_total_size;
-    if (!codec::EncodeRpcRow(output, &buf, &buf_total_size)) {
+    if (!codec::EncodeRpcRowZeroCopy(&output, &buf, &buf_total_size)) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to encode sql output row");
         return;
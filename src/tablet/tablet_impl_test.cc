@@ -1829,6 +1829,64 @@ TEST_P(TabletImplTest, Scan) {
 }
 
 
+TEST_P(TabletImplTest, PutBatch) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 0, 0, kAbsoluteTime, storage_mode, &tablet));
+    MockClosure closure;
+    ::openmldb::api::PutBatchRequest prequest;
+    prequest.set_tid(id);
+    prequest.set_pid(1);
+    for (int i = 0; i < 10; i++) {
+        auto row = prequest.add_rows();
+        row->set_time(9520 + i);
+        row->set_value(::openmldb::test::EncodeKV("test1", "value" + std::to_string(i)));
+        auto dim = row->add_dimensions();
+        dim->set_idx(0);
+        dim->set_key("test1");
+    }
+    ::openmldb::api::PutBatchResponse presponse;
+    prequest.set_tid(id + 100);
+    tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+    ASSERT_EQ(100, presponse.code());
+    prequest.set_tid(id);
+    tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+    ASSERT_EQ(0, presponse.code());
+    ASSERT_EQ(10u, presponse.put_cnt());
+
+    ::openmldb::api::ScanRequest sr;
+    sr.set_tid(id);
+    sr.set_pid(1);
+    sr.set_pk("test1");
+    sr.set_st(9529);
+    sr.set_et(0);
+    ::openmldb::api::ScanResponse srp;
+    tablet.Scan(NULL, &sr, &srp, &closure);
+    ASSERT_EQ(0, srp.code());
+    ASSERT_EQ(10, (signed)srp.count());
+
+    // all rows of a batch get consecutive binlog offsets
+    ::openmldb::api::GetTableStatusRequest gr;
+    ::openmldb::api::GetTableStatusResponse gres;
+    tablet.GetTableStatus(NULL, &gr, &gres, &closure);
+    bool found = false;
+    for (const auto& status : gres.all_table_status()) {
+        if (status.tid() == id && status.pid() == 1) {
+            ASSERT_EQ(10u, status.offset());
+            found = true;
+        }
+    }
+    ASSERT_TRUE(found);
+
+    // invalid dimension rejects the whole batch
+    prequest.mutable_rows(5)->mutable_dimensions(0)->set_key("");
+    tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+    ASSERT_EQ(::openmldb::base::ReturnCode::kInvalidDimensionParameter, presponse.code());
+    ASSERT_EQ(0u, presponse.put_cnt());
+}
+
 TEST_P(TabletImplTest, GCWithUpdateLatest) {
     ::openmldb::common::StorageMode storage_mode = GetParam();
     int32_t old_gc_interval = FLAGS_gc_interval;